@@ -1,13 +1,18 @@
 import 'dart:async';
 import 'dart:ffi';
+import 'dart:io';
 import 'dart:isolate';
+import 'dart:typed_data';
 
 import 'package:ffi/ffi.dart';
 
+/// File name of the native library for the current platform.
+String get _nativeLibraryPath => Platform.isWindows ? 'process_monitor.dll' : 'libprocess_monitor.so';
+
 /// C structure for process event data, used for FFI with the native DLL.
 base class ProcessEventData extends Struct {
   @Array(32)
-  external Array<Uint8> _eventType; // "start" or "stop"
+  external Array<Uint8> _eventType; // "start", "stop", "first_start" or "last_stop"
 
   @Array(512)
   external Array<Uint8> _processName; // Process name
@@ -41,6 +46,140 @@ base class ProcessEventData extends Struct {
   }
 }
 
+/// Compact 32-byte process event; the name is resolved by ID through `get_process_name`.
+base class CompactProcessEvent extends Struct {
+  @Int64()
+  external int timestampMs; // Timestamp in milliseconds since epoch
+
+  @Int32()
+  external int processId; // Process ID
+
+  @Int32()
+  external int parentProcessId; // Parent process ID (0 if unknown)
+
+  @Uint32()
+  external int nameId; // Process name ID (0 if unknown)
+
+  @Uint8()
+  external int eventTypeCode; // 1 = start, 2 = stop, 3 = first_start, 4 = last_stop
+
+  @Array(3)
+  external Array<Uint8> _reserved;
+
+  @Int64()
+  external int startTimeMs; // Process start time in milliseconds since epoch (0 if unknown)
+
+  /// Returns the event type ("start", "stop", "first_start" or "last_stop") as a Dart string.
+  String get eventType => _eventTypeName(eventTypeCode);
+}
+
+/// Details of a process as filled by `get_process_details`; the strings point into the caller's buffer.
+base class _NativeProcessDetails extends Struct {
+  @Int64()
+  external int startTimeMs;
+
+  @Int64()
+  external int userId;
+
+  external Pointer<Utf8> exePath;
+
+  external Pointer<Utf8> commandLine;
+
+  @Int32()
+  external int fields;
+
+  @Int32()
+  external int _reserved;
+}
+
+/// `get_process_details` fields: executable path, command line, user ID and start time.
+const int _detailExePath = 1;
+const int _detailCommandLine = 2;
+const int _detailUserId = 4;
+const int _detailStartTime = 8;
+
+/// Maps a native ProcessEventType code to its event type string.
+String _eventTypeName(int eventTypeCode) => switch (eventTypeCode) {
+      1 => 'start',
+      3 => 'first_start',
+      4 => 'last_stop',
+      _ => 'stop',
+    };
+
+/// Header of the native event queue mapped read-only by `map_event_ring`.
+/// Slots follow at [slotsOffset]; the slot for index n is readable once its leading 64-bit
+/// sequence equals n + 1, and its record starts at [recordOffset].
+base class ProcessEventRingHeader extends Struct {
+  @Uint32()
+  external int magic;
+
+  @Uint32()
+  external int version;
+
+  @Uint32()
+  external int capacity; // Slot count, a power of two
+
+  @Uint32()
+  external int slotSize;
+
+  @Uint32()
+  external int slotsOffset;
+
+  @Uint32()
+  external int recordOffset;
+
+  @Uint32()
+  external int recordSize;
+
+  @Uint32()
+  external int recordFormat;
+
+  @Array(32)
+  external Array<Uint8> _reserved;
+
+  @Uint64()
+  external int writeIndex;
+
+  @Array(56)
+  external Array<Uint8> _writePadding;
+
+  @Uint64()
+  external int readIndex;
+
+  @Array(56)
+  external Array<Uint8> _readPadding;
+}
+
+/// Record formats of the mapped event queue: bare [CompactProcessEvent]s, or timed records
+/// that start with one (and carry kernel, ingest and dequeue times after it).
+const int _compactRecordFormat = 1;
+const int _timedRecordFormat = 2;
+
+/// Byte offsets of the [CompactProcessEvent] fields, for decoding the records the native library
+/// posts to a receive port as a Uint8List. They follow the struct above (natural alignment, no
+/// packing); test/dart_port_test.cpp in the native build checks the same offsets.
+const int _compactTimestampMsOffset = 0;
+const int _compactProcessIdOffset = 8;
+const int _compactNameIdOffset = 16;
+const int _compactEventTypeOffset = 20;
+const int _compactStartTimeMsOffset = 24;
+
+/// `set_event_source` backends used by [ProcessMonitor.useSyntheticEvents] and friends.
+const int _eventSourceAuto = 0;
+const int _eventSourceSynthetic = 4;
+const int _eventSourceReplay = 5;
+
+/// `set_event_delivery` flags: raw start/stop events, and first/last instance edges per name.
+const int _eventsRaw = 1;
+const int _eventsEdges = 2;
+
+/// Returns the event stored in the mapped event queue for [index], which must have been acquired.
+CompactProcessEvent _mappedEventAt(Pointer<ProcessEventRingHeader> ring, int index) {
+  final header = ring.ref;
+  final slot = ring.address + header.slotsOffset + (index & (header.capacity - 1)) * header.slotSize;
+  return Pointer<CompactProcessEvent>.fromAddress(slot + header.recordOffset).ref;
+}
+
 // FFI function signatures
 typedef InitializeProcessMonitorNative = Bool Function();
 typedef InitializeProcessMonitorDart = bool Function();
@@ -48,6 +187,9 @@ typedef InitializeProcessMonitorDart = bool Function();
 typedef StartMonitoringNative = Bool Function();
 typedef StartMonitoringDart = bool Function();
 
+typedef StartMonitoringWithNativePortNative = Bool Function(Pointer<Void>, Int64);
+typedef StartMonitoringWithNativePortDart = bool Function(Pointer<Void>, int);
+
 typedef StopMonitoringNative = Bool Function();
 typedef StopMonitoringDart = bool Function();
 
@@ -67,6 +209,54 @@ typedef WaitForEventsDart = int Function(int);
 typedef GetAllEventsNative = Int32 Function(Pointer<ProcessEventData>, Int32);
 typedef GetAllEventsDart = int Function(Pointer<ProcessEventData>, int);
 
+typedef WaitAndDrainNative = Int32 Function(Pointer<CompactProcessEvent>, Int32, Int32);
+typedef WaitAndDrainDart = int Function(Pointer<CompactProcessEvent>, int, int);
+
+typedef MapEventRingNative = Pointer<ProcessEventRingHeader> Function();
+typedef MapEventRingDart = Pointer<ProcessEventRingHeader> Function();
+
+typedef AcquireMappedEventsNative = Int32 Function(Pointer<Int64>, Int32);
+typedef AcquireMappedEventsDart = int Function(Pointer<Int64>, int);
+
+typedef ReleaseMappedEventsNative = Int32 Function(Int32);
+typedef ReleaseMappedEventsDart = int Function(int);
+
+typedef UnmapEventRingNative = Void Function();
+typedef UnmapEventRingDart = void Function();
+
+typedef GetProcessNameNative = Pointer<Utf8> Function(Uint32);
+typedef GetProcessNameDart = Pointer<Utf8> Function(int);
+
+typedef SetProcessWatchSetNative = Bool Function(Pointer<Pointer<Utf8>>, Pointer<Pointer<Utf8>>, Int32);
+typedef SetProcessWatchSetDart = bool Function(Pointer<Pointer<Utf8>>, Pointer<Pointer<Utf8>>, int);
+
+typedef SetDeliverAllEventsNative = Void Function(Bool);
+typedef SetDeliverAllEventsDart = void Function(bool);
+
+typedef SetEventDeliveryNative = Bool Function(Int32);
+typedef SetEventDeliveryDart = bool Function(int);
+
+typedef IsRunningNative = Bool Function(Pointer<Utf8>);
+typedef IsRunningDart = bool Function(Pointer<Utf8>);
+
+typedef PidsOfNative = Int32 Function(Pointer<Utf8>, Pointer<Int32>, Int32);
+typedef PidsOfDart = int Function(Pointer<Utf8>, Pointer<Int32>, int);
+
+typedef GetProcessDetailsNative = Int32 Function(Int32, Int64, Int32, Pointer<_NativeProcessDetails>, Pointer<Uint8>, Int32);
+typedef GetProcessDetailsDart = int Function(int, int, int, Pointer<_NativeProcessDetails>, Pointer<Uint8>, int);
+
+typedef SetEventSourceNative = Bool Function(Int32);
+typedef SetEventSourceDart = bool Function(int);
+
+typedef SetSyntheticEventRateNative = Bool Function(Int32, Int64);
+typedef SetSyntheticEventRateDart = bool Function(int, int);
+
+typedef SetReplayTraceNative = Bool Function(Pointer<Utf8>);
+typedef SetReplayTraceDart = bool Function(Pointer<Utf8>);
+
+typedef SetEventRateMultiplierNative = Bool Function(Double);
+typedef SetEventRateMultiplierDart = bool Function(double);
+
 typedef IsMonitoringNative = Bool Function();
 typedef IsMonitoringDart = bool Function();
 
@@ -79,6 +269,20 @@ typedef CleanupProcessMonitorDart = void Function();
 typedef GetLastErrorNative = Pointer<Utf8> Function();
 typedef GetLastErrorDart = Pointer<Utf8> Function();
 
+/// How [ProcessMonitor.startMonitoring] gets events from the native library into Dart.
+enum EventDeliveryMode {
+  /// [nativePort], falling back to [isolate] when the native library can't post to this
+  /// isolate (e.g. its Dart API DL version is not supported).
+  auto,
+
+  /// The native ingest thread posts each batch straight to a receive port in this isolate.
+  /// Starting fails if that is unavailable.
+  nativePort,
+
+  /// A background isolate waits for events natively and forwards them to this isolate.
+  isolate,
+}
+
 /// Represents a process event (start/stop) detected by the monitor.
 class ProcessEvent {
   final String processName;
@@ -86,12 +290,37 @@ class ProcessEvent {
   final String eventType;
   final DateTime timestamp;
 
-  ProcessEvent({required this.processName, required this.processId, required this.eventType, required this.timestamp});
+  /// Process start time in milliseconds since epoch (0 if unknown)
+  final int startTimeMs;
+
+  ProcessEvent({required this.processName, required this.processId, required this.eventType, required this.timestamp, this.startTimeMs = 0});
+
+  /// Identifies this process for its whole life, unlike [processId], which the system reuses;
+  /// the same value as the native `make_process_key`.
+  int get processKey => processKeyOf(processId, startTimeMs);
 
   @override
   String toString() => 'ProcessEvent(processName: $processName, processId: $processId, eventType: $eventType, timestamp: $timestamp)';
 }
 
+/// Process key of the process with this ID that started at [startTimeMs]: the PID in the low 32 bits
+/// and the low 32 bits of the start time above them.
+int processKeyOf(int processId, int startTimeMs) => ((startTimeMs & 0xFFFFFFFF) << 32) | (processId & 0xFFFFFFFF);
+
+/// Details of a process, fetched on demand by [ProcessMonitor.processDetails].
+/// A field is null when it could not be read.
+class ProcessDetails {
+  final String? executablePath;
+  final String? commandLine;
+  final int? userId;
+  final DateTime? startTime;
+
+  ProcessDetails({this.executablePath, this.commandLine, this.userId, this.startTime});
+
+  @override
+  String toString() => 'ProcessDetails(executablePath: $executablePath, commandLine: $commandLine, userId: $userId, startTime: $startTime)';
+}
+
 /// Configuration for monitoring a specific process
 ///
 /// Used to specify which process to monitor, and what callbacks to run when it starts or stops.
@@ -99,6 +328,11 @@ class ProcessConfig {
   /// The name of the process to monitor
   final String processName;
 
+  /// Full path of the executable, to only match the process when it runs from there. Several
+  /// configs may share a process name with different paths; each gets the events of its own path.
+  /// Single-shot callbacks still follow the first/last instance of the name as a whole.
+  final String? executablePath;
+
   /// Callback called when the process starts
   final void Function(ProcessEvent event)? onStart;
 
@@ -113,7 +347,7 @@ class ProcessConfig {
   /// If false, onStop is only called when the last instance stops
   final bool allowMultipleStopCallbacks;
 
-  ProcessConfig({required this.processName, this.onStart, this.onStop, this.allowMultipleStartCallbacks = true, this.allowMultipleStopCallbacks = true});
+  ProcessConfig({required this.processName, this.executablePath, this.onStart, this.onStop, this.allowMultipleStartCallbacks = true, this.allowMultipleStopCallbacks = true});
 
   @override
   String toString() => 'ProcessConfig(processName: $processName, allowMultipleStart: $allowMultipleStartCallbacks, allowMultipleStop: $allowMultipleStopCallbacks)';
@@ -133,13 +367,26 @@ class ProcessMonitor {
   DynamicLibrary? _lib;
   InitializeProcessMonitorDart? _initialize;
   StartMonitoringDart? _startMonitoring;
+  StartMonitoringWithNativePortDart? _startMonitoringWithNativePort;
   StopMonitoringDart? _stopMonitoring;
+  UnmapEventRingDart? _unmapEventRing;
   WaitForEventsDart? _waitForEvents;
   GetAllEventsDart? _getAllEvents;
   IsMonitoringDart? _isMonitoring;
   GetPendingEventCountDart? _getPendingEventCount;
   CleanupProcessMonitorDart? _cleanup;
   GetLastErrorDart? _getLastError;
+  SetProcessWatchSetDart? _setProcessWatchSet;
+  SetDeliverAllEventsDart? _setDeliverAllEvents;
+  SetEventDeliveryDart? _setEventDelivery;
+  GetProcessNameDart? _getProcessName;
+  IsRunningDart? _isRunning;
+  PidsOfDart? _pidsOf;
+  GetProcessDetailsDart? _getProcessDetails;
+  SetEventSourceDart? _setEventSource;
+  SetSyntheticEventRateDart? _setSyntheticEventRate;
+  SetReplayTraceDart? _setReplayTrace;
+  SetEventRateMultiplierDart? _setEventRateMultiplier;
 
   final StreamController<ProcessEvent> _eventController = StreamController<ProcessEvent>.broadcast();
   Timer? _pollingTimer;
@@ -149,10 +396,10 @@ class ProcessMonitor {
 
   // New fields for process-specific monitoring
   List<ProcessConfig>? _processConfigs;
-  final Map<String, Set<int>> _runningProcesses = {}; // processName -> Set of PIDs
+  final Map<String, List<ProcessConfig>> _processConfigsByName = {}; // lowercased processName -> configs, in the order given
 
-  // Deduplication mechanism for events
-  final Set<String> _recentEvents = {}; // Store recent event signatures to detect duplicates
+  // Names by native ID for events posted to the receive port; IDs never change meaning
+  final Map<int, String> _processNames = {};
 
   /// Stream of all process events.
   Stream<ProcessEvent> get events => _eventController.stream;
@@ -178,6 +425,114 @@ class ProcessMonitor {
     return errorPtr.toDartString();
   }
 
+  /// Whether a process with this name is running, including ones started before monitoring.
+  /// Answered from the native process table while monitoring, without rescanning.
+  bool isRunning(String processName) {
+    if (!_isInitialized && !initialize()) return false;
+
+    final name = processName.toNativeUtf8(allocator: calloc);
+    try {
+      return _isRunning!(name);
+    } finally {
+      calloc.free(name);
+    }
+  }
+
+  /// IDs of the processes running under this name.
+  List<int> pidsOf(String processName) {
+    if (!_isInitialized && !initialize()) return const [];
+
+    final name = processName.toNativeUtf8(allocator: calloc);
+    var capacity = 16;
+    try {
+      while (true) {
+        final pids = calloc<Int32>(capacity);
+        try {
+          final count = _pidsOf!(name, pids, capacity);
+          if (count < 0) return const [];
+          if (count <= capacity) return List<int>.generate(count, (i) => pids[i]);
+          capacity = count + 16;
+        } finally {
+          calloc.free(pids);
+        }
+      }
+    } finally {
+      calloc.free(name);
+    }
+  }
+
+  /// Executable path, command line, user ID and start time of a process, read only when asked and
+  /// cached natively per process. [startTimeMs] (see [ProcessEvent.startTimeMs]) names one particular process,
+  /// so its details stay available after it exits; without it the process now running under
+  /// [processId] is looked up. Returns null if the process is unknown and not running.
+  ProcessDetails? processDetails(int processId, {int startTimeMs = 0}) => _readProcessDetails(processId, startTimeMs, _detailExePath | _detailCommandLine | _detailUserId | _detailStartTime);
+
+  /// Reads the detail [fields] of a process, as [processDetails] describes (internal).
+  ProcessDetails? _readProcessDetails(int processId, int startTimeMs, int fields) {
+    if (!_isInitialized && !initialize()) return null;
+    if (_getProcessDetails == null) return null;
+
+    final details = calloc<_NativeProcessDetails>();
+    var capacity = 1024;
+    try {
+      while (true) {
+        final buffer = calloc<Uint8>(capacity);
+        try {
+          final required = _getProcessDetails!(processId, startTimeMs, fields, details, buffer, capacity);
+          if (required < 0) return null;
+          if (required > capacity) {
+            capacity = required;
+            continue;
+          }
+
+          final native = details.ref;
+          return ProcessDetails(
+            executablePath: native.fields & _detailExePath != 0 ? native.exePath.toDartString() : null,
+            commandLine: native.fields & _detailCommandLine != 0 ? native.commandLine.toDartString() : null,
+            userId: native.fields & _detailUserId != 0 ? native.userId : null,
+            startTime: native.fields & _detailStartTime != 0 ? DateTime.fromMillisecondsSinceEpoch(native.startTimeMs) : null,
+          );
+        } finally {
+          calloc.free(buffer);
+        }
+      }
+    } finally {
+      calloc.free(details);
+    }
+  }
+
+  /// Makes the next [startMonitoring] deliver generated events instead of real ones, for load testing
+  /// consumers without real process churn. [eventsPerSecond] starts and stops of processes named
+  /// synthetic-0 to synthetic-63 are generated (sped up by [rateMultiplier], 0 for as fast as possible),
+  /// [eventCount] in total (0 for no limit). They take the same native path as real events.
+  bool useSyntheticEvents({int eventsPerSecond = 1000, int eventCount = 0, double rateMultiplier = 1}) {
+    if (!_isInitialized && !initialize()) return false;
+
+    return _setSyntheticEventRate!(eventsPerSecond, eventCount) &&
+        _setEventRateMultiplier!(rateMultiplier) &&
+        _setEventSource!(_eventSourceSynthetic);
+  }
+
+  /// Makes the next [startMonitoring] replay the events of a recorded trace (see `set_replay_trace`
+  /// in process_monitor_api.h for the format), [rateMultiplier] times as fast as recorded (0 for as fast as possible).
+  bool useReplayTrace(String path, {double rateMultiplier = 1}) {
+    if (!_isInitialized && !initialize()) return false;
+
+    final nativePath = path.toNativeUtf8(allocator: calloc);
+    try {
+      return _setReplayTrace!(nativePath) && _setEventRateMultiplier!(rateMultiplier) && _setEventSource!(_eventSourceReplay);
+    } finally {
+      calloc.free(nativePath);
+    }
+  }
+
+  /// Goes back to the platform's own event source for the next [startMonitoring].
+  bool useSystemEvents() {
+    if (!_isInitialized && !initialize()) return false;
+
+    return _setEventSource!(_eventSourceAuto);
+  }
+
   /// Initializes the native DLL and loads FFI function pointers.
   /// Returns true if successful, false otherwise.
   bool initialize() {
@@ -185,20 +540,31 @@ class ProcessMonitor {
 
     try {
       // Try to load the FFI DLL
-      const dllPath = 'process_monitor.dll';
-
-      _lib = DynamicLibrary.open(dllPath);
+      _lib = DynamicLibrary.open(_nativeLibraryPath);
 
       // Load function pointers
       _initialize = _lib!.lookupFunction<InitializeProcessMonitorNative, InitializeProcessMonitorDart>('initialize_process_monitor');
       _startMonitoring = _lib!.lookupFunction<StartMonitoringNative, StartMonitoringDart>('start_monitoring');
+      _startMonitoringWithNativePort = _lib!.lookupFunction<StartMonitoringWithNativePortNative, StartMonitoringWithNativePortDart>('start_monitoring_with_native_port');
       _stopMonitoring = _lib!.lookupFunction<StopMonitoringNative, StopMonitoringDart>('stop_monitoring');
+      _unmapEventRing = _lib!.lookupFunction<UnmapEventRingNative, UnmapEventRingDart>('unmap_event_ring');
       _waitForEvents = _lib!.lookupFunction<WaitForEventsNative, WaitForEventsDart>('wait_for_events');
       _getAllEvents = _lib!.lookupFunction<GetAllEventsNative, GetAllEventsDart>('get_all_events');
       _isMonitoring = _lib!.lookupFunction<IsMonitoringNative, IsMonitoringDart>('is_monitoring');
       _getPendingEventCount = _lib!.lookupFunction<GetPendingEventCountNative, GetPendingEventCountDart>('get_pending_event_count');
       _cleanup = _lib!.lookupFunction<CleanupProcessMonitorNative, CleanupProcessMonitorDart>('cleanup_process_monitor');
       _getLastError = _lib!.lookupFunction<GetLastErrorNative, GetLastErrorDart>('get_last_error');
+      _setProcessWatchSet = _lib!.lookupFunction<SetProcessWatchSetNative, SetProcessWatchSetDart>('set_process_watch_set');
+      _setDeliverAllEvents = _lib!.lookupFunction<SetDeliverAllEventsNative, SetDeliverAllEventsDart>('set_deliver_all_events');
+      _setEventDelivery = _lib!.lookupFunction<SetEventDeliveryNative, SetEventDeliveryDart>('set_event_delivery');
+      _getProcessName = _lib!.lookupFunction<GetProcessNameNative, GetProcessNameDart>('get_process_name');
+      _isRunning = _lib!.lookupFunction<IsRunningNative, IsRunningDart>('is_running');
+      _pidsOf = _lib!.lookupFunction<PidsOfNative, PidsOfDart>('pids_of');
+      _getProcessDetails = _lib!.lookupFunction<GetProcessDetailsNative, GetProcessDetailsDart>('get_process_details');
+      _setEventSource = _lib!.lookupFunction<SetEventSourceNative, SetEventSourceDart>('set_event_source');
+      _setSyntheticEventRate = _lib!.lookupFunction<SetSyntheticEventRateNative, SetSyntheticEventRateDart>('set_synthetic_event_rate');
+      _setReplayTrace = _lib!.lookupFunction<SetReplayTraceNative, SetReplayTraceDart>('set_replay_trace');
+      _setEventRateMultiplier = _lib!.lookupFunction<SetEventRateMultiplierNative, SetEventRateMultiplierDart>('set_event_rate_multiplier');
 
       // Initialize the native library
       final success = _initialize!();
@@ -215,15 +581,32 @@ class ProcessMonitor {
     }
   }
 
-  /// Starts monitoring all processes (general mode).
+  /// Starts monitoring all processes (general mode), with events delivered as [delivery] says.
   /// Returns true if monitoring started successfully.
-  Future<bool> startMonitoring() async {
+  Future<bool> startMonitoring({EventDeliveryMode delivery = EventDeliveryMode.auto}) async {
     if (!_isInitialized && !initialize()) {
       print('[ERROR] Failed to initialize ProcessMonitor');
       return false;
     }
 
-    // Use event-driven monitoring (no polling!)
+    // Every process, unless startMonitoringProcesses registered a watch set
+    if (_processConfigs == null) _setNativeWatchSet(null, includeAllEvents: true);
+
+    // Configured processes also get first/last instance edges, tracked natively from the processes already running
+    if (_setEventDelivery != null && !_setEventDelivery!(_processConfigs == null ? _eventsRaw : _eventsRaw | _eventsEdges)) {
+      print('[ERROR] Failed to set event delivery: $lastError');
+    }
+
+    // Have the native ingest thread post events straight to this isolate
+    if (delivery != EventDeliveryMode.isolate) {
+      if (_startNativePortDelivery()) return true;
+      if (delivery == EventDeliveryMode.nativePort) {
+        print('Failed to start monitoring with native port delivery: $lastError');
+        return false;
+      }
+    }
+
+    // Otherwise wait for events in a background isolate
     if (_startMonitoring != null && _waitForEvents != null && _getAllEvents != null) {
       final success = _startMonitoring!();
       if (!success) {
@@ -241,48 +624,65 @@ class ProcessMonitor {
   /// Start monitoring specific processes with individual callbacks.
   ///
   /// [processConfigs] - List of process configurations specifying which processes to monitor and their respective callbacks.
+  /// Events for other processes are dropped natively before they reach Dart, unless [includeAllEvents]
+  /// is true, in which case they still appear on [events].
   /// Returns true if monitoring started successfully.
-  Future<bool> startMonitoringProcesses(List<ProcessConfig> processConfigs) async {
+  Future<bool> startMonitoringProcesses(List<ProcessConfig> processConfigs, {bool includeAllEvents = false, EventDeliveryMode delivery = EventDeliveryMode.auto}) async {
     if (processConfigs.isEmpty) return false;
 
+    if (!_isInitialized && !initialize()) {
+      print('[ERROR] Failed to initialize ProcessMonitor');
+      return false;
+    }
+
     // Store process configurations
     _processConfigs = processConfigs;
-    _runningProcesses.clear();
+    _processConfigsByName.clear();
 
-    // Initialize all process sets
     for (final config in processConfigs) {
-      _runningProcesses[config.processName] = <int>{};
+      _processConfigsByName.putIfAbsent(config.processName.toLowerCase(), () => []).add(config);
     }
 
+    // Only the configured processes cross the FFI boundary
+    _setNativeWatchSet(processConfigs, includeAllEvents: includeAllEvents);
+
     // Start general monitoring first
-    final success = await startMonitoring();
+    final success = await startMonitoring(delivery: delivery);
     if (!success) {
       _processConfigs = null;
-      _runningProcesses.clear();
+      _processConfigsByName.clear();
+      _setNativeWatchSet(null, includeAllEvents: true);
       return false;
     }
 
-    // Set up event filtering and callback routing
-    _setupProcessSpecificEventHandling();
-
     return true;
   }
 
-  /// Sets up process-specific event handling (internal).
-  void _setupProcessSpecificEventHandling() {
-    if (_processConfigs == null) return;
-  }
+  /// Registers the processes to deliver with the native filter; null delivers every process (internal).
+  void _setNativeWatchSet(List<ProcessConfig>? processConfigs, {required bool includeAllEvents}) {
+    if (_setProcessWatchSet == null || _setDeliverAllEvents == null) return;
 
-  /// Cleans up old event signatures from deduplication cache (internal).
-  void _cleanupOldEventSignatures() {
-    // In a production app, you might want to implement time-based cleanup
-    // For now, just limit the size to prevent memory leaks
-    if (_recentEvents.length > 1000) {
-      // Remove half of the entries (oldest ones)
-      final signatures = _recentEvents.toList();
-      _recentEvents.clear();
-      // Add back the more recent half
-      _recentEvents.addAll(signatures.sublist(signatures.length ~/ 2));
+    final count = processConfigs?.length ?? 0;
+    final names = calloc<Pointer<Utf8>>(count == 0 ? 1 : count);
+    final paths = calloc<Pointer<Utf8>>(count == 0 ? 1 : count);
+    try {
+      for (int i = 0; i < count; i++) {
+        final config = processConfigs![i];
+        names[i] = config.processName.toNativeUtf8(allocator: calloc);
+        paths[i] = config.executablePath == null ? nullptr : config.executablePath!.toNativeUtf8(allocator: calloc);
+      }
+
+      if (!_setProcessWatchSet!(names, paths, count)) {
+        print('[ERROR] Failed to set the process watch set: $lastError');
+      }
+      _setDeliverAllEvents!(includeAllEvents);
+    } finally {
+      for (int i = 0; i < count; i++) {
+        calloc.free(names[i]);
+        if (paths[i] != nullptr) calloc.free(paths[i]);
+      }
+      calloc.free(names);
+      calloc.free(paths);
     }
   }
 
@@ -290,56 +690,107 @@ class ProcessMonitor {
   void _handleProcessSpecificEvent(ProcessEvent event) {
     if (_processConfigs == null) return;
 
-    // Find the process config for this event
-    ProcessConfig? config;
-    for (final processConfig in _processConfigs!) {
-      if (processConfig.processName.toLowerCase() == event.processName.toLowerCase()) {
-        config = processConfig;
-        break;
+    // Find the process configs for this event
+    final configs = _processConfigsByName[event.processName.toLowerCase()];
+
+    // If the process not in our monitoring list, ignore
+    if (configs == null) return;
+
+    // Configs narrowed to an executable path only get events of processes running from there.
+    // The path is looked up once per event, and only if some config needs it.
+    String? eventPath;
+    var eventPathLoaded = false;
+    for (final config in configs) {
+      if (config.executablePath != null) {
+        if (!eventPathLoaded) {
+          eventPath = _executablePathOf(event.processId, event.startTimeMs);
+          eventPathLoaded = true;
+        }
+        if (eventPath == null || _normalizePath(eventPath) != _normalizePath(config.executablePath!)) continue;
       }
+      _runProcessCallbacks(config, event);
     }
+  }
 
-    // If the process not in our monitoring list, ignore
-    if (config == null) return;
-
-    final processName = config.processName;
-    final processInstances = _runningProcesses[processName]!;
-
-    if (event.eventType == 'start') {
-      final wasEmpty = processInstances.isEmpty;
-      processInstances.add(event.processId);
-
-      // Call start callback based on configuration
-      if (config.onStart != null) {
-        if (config.allowMultipleStartCallbacks || wasEmpty) {
-          try {
-            config.onStart!(event);
-          } catch (e) {
-            print('[ERROR] Error in onStart callback for ${event.processName}: $e');
-          }
-        } else {
-          // Skipped due to configuration
+  /// Runs the callbacks of [config] that [event] calls for (internal).
+  void _runProcessCallbacks(ProcessConfig config, ProcessEvent event) {
+    // Every instance fires on the raw events; single-shot callbacks fire on the native
+    // first_start/last_stop edges, which count instances running before monitoring began
+    if (event.eventType == 'start' || event.eventType == 'first_start') {
+      if (config.onStart != null && config.allowMultipleStartCallbacks == (event.eventType == 'start')) {
+        try {
+          config.onStart!(event);
+        } catch (e) {
+          print('[ERROR] Error in onStart callback for ${event.processName}: $e');
         }
       }
-    } else if (event.eventType == 'stop') {
-      processInstances.remove(event.processId);
-      final isEmpty = processInstances.isEmpty;
-
-      // Call stop callback based on configuration
-      if (config.onStop != null) {
-        if (config.allowMultipleStopCallbacks || isEmpty) {
-          try {
-            config.onStop!(event);
-          } catch (e) {
-            print('[ERROR] Error in onStop callback for ${event.processName}: $e');
-          }
-        } else {
-          // Skipped due to configuration
+    } else if (event.eventType == 'stop' || event.eventType == 'last_stop') {
+      if (config.onStop != null && config.allowMultipleStopCallbacks == (event.eventType == 'stop')) {
+        try {
+          config.onStop!(event);
+        } catch (e) {
+          print('[ERROR] Error in onStop callback for ${event.processName}: $e');
         }
       }
     }
   }
 
+  /// Executable path of a process from the native details cache, which keeps it after the process exits (internal).
+  String? _executablePathOf(int processId, int startTimeMs) => _readProcessDetails(processId, startTimeMs, _detailExePath)?.executablePath;
+
+  /// Paths compared the way the native watch set compares them: case-insensitive with either separator on Windows (internal).
+  static String _normalizePath(String path) => Platform.isWindows ? path.toLowerCase().replaceAll('/', '\\') : path;
+
+  /// Starts monitoring with events posted by the native library to a receive port in this isolate,
+  /// so no background isolate or per-event copy is needed. Returns false if unavailable, with the
+  /// reason in [lastError] (internal).
+  bool _startNativePortDelivery() {
+    if (_startMonitoringWithNativePort == null || _getProcessName == null) return false;
+
+    final receivePort = ReceivePort();
+    if (!_startMonitoringWithNativePort!(NativeApi.initializeApiDLData, receivePort.sendPort.nativePort)) {
+      // The reason stays in lastError
+      receivePort.close();
+      return false;
+    }
+
+    _receivePort = receivePort;
+    _receivePort!.listen((data) {
+      if (data is Uint8List) _handleNativeEventBatch(data);
+    });
+    return true;
+  }
+
+  /// Decodes a batch of CompactProcessEvent records posted by the native library (internal).
+  void _handleNativeEventBatch(Uint8List batch) {
+    final records = ByteData.sublistView(batch);
+    final recordSize = sizeOf<CompactProcessEvent>();
+    for (int offset = 0; offset + recordSize <= batch.length; offset += recordSize) {
+      try {
+        final nameId = records.getUint32(offset + _compactNameIdOffset, Endian.host);
+        final processName = _processNames.putIfAbsent(nameId, () {
+          final name = _getProcessName!(nameId);
+          return name == nullptr ? '' : name.toDartString();
+        });
+
+        _dispatchEvent(ProcessEvent(processName: processName, processId: records.getInt32(offset + _compactProcessIdOffset, Endian.host), eventType: _eventTypeName(records.getUint8(offset + _compactEventTypeOffset)), timestamp: DateTime.fromMillisecondsSinceEpoch(records.getInt64(offset + _compactTimestampMsOffset, Endian.host)), startTimeMs: records.getInt64(offset + _compactStartTimeMsOffset, Endian.host)));
+      } catch (e) {
+        print('[ERROR] Error processing native event: $e');
+      }
+    }
+  }
+
+  /// Routes an event to the process-specific callbacks and the general event stream (internal).
+  void _dispatchEvent(ProcessEvent event) {
+    // Repeats were already dropped natively (see set_dedup_window)
+    // Handle process-specific callbacks if configured (only once)
+    if (_processConfigs != null) _handleProcessSpecificEvent(event);
+
+    // The general event stream carries raw start/stop events only, for backward compatibility
+    final isEdge = event.eventType == 'first_start' || event.eventType == 'last_stop';
+    if (!isEdge && !_eventController.isClosed) _eventController.add(event);
+  }
+
   /// Starts the background isolate that receives process events from the native DLL (internal).
   Future<void> _startBackgroundEventLoop() async {
     // Create a receive port to get events from the isolate
@@ -349,26 +800,8 @@ class ProcessMonitor {
     _receivePort!.listen((data) {
       if (data is Map<String, dynamic>) {
         try {
-          final event = ProcessEvent(processName: data['processName'] as String, processId: data['processId'] as int, eventType: data['eventType'] as String, timestamp: DateTime.fromMillisecondsSinceEpoch(data['timestampMs'] as int));
-
-          // Create a unique signature for this event
-          final eventSignature = '${event.eventType}-${event.processName}-${event.processId}-${event.timestamp.millisecondsSinceEpoch ~/ 1000}'; // Round to nearest second
-
-          // Check for duplicate events within the deduplication window
-          if (_recentEvents.contains(eventSignature)) {
-            // Duplicate event, ignore
-            return;
-          }
-
-          // Add to recent events and clean up old entries
-          _recentEvents.add(eventSignature);
-          _cleanupOldEventSignatures();
-
-          // Handle process-specific callbacks if configured (only once)
-          if (_processConfigs != null) _handleProcessSpecificEvent(event);
-
-          // Always add to the general event stream for backward compatibility
-          if (!_eventController.isClosed) _eventController.add(event);
+          final event = ProcessEvent(processName: data['processName'] as String, processId: data['processId'] as int, eventType: data['eventType'] as String, timestamp: DateTime.fromMillisecondsSinceEpoch(data['timestampMs'] as int), startTimeMs: data['startTimeMs'] as int);
+          _dispatchEvent(event);
         } catch (e) {
           print('[ERROR] Error processing event from isolate: $e');
         }
@@ -394,62 +827,104 @@ class ProcessMonitor {
     // We need to reinitialize the DLL in this isolate
     DynamicLibrary? lib;
     WaitForEventsDart? waitForEvents;
-    GetAllEventsDart? getAllEvents;
+    WaitAndDrainDart? waitAndDrain;
     IsMonitoringDart? isMonitoring;
+    AcquireMappedEventsDart? acquireMappedEvents;
+    ReleaseMappedEventsDart? releaseMappedEvents;
+    UnmapEventRingDart? unmapEventRing;
+    GetProcessNameDart? getProcessName;
+    Pointer<ProcessEventRingHeader> ring = nullptr;
 
     try {
       // Load the DLL in this isolate
-      const dllPath = 'process_monitor.dll';
-      lib = DynamicLibrary.open(dllPath);
+      lib = DynamicLibrary.open(_nativeLibraryPath);
 
       // Load the functions we need
       waitForEvents = lib.lookupFunction<WaitForEventsNative, WaitForEventsDart>('wait_for_events');
-      getAllEvents = lib.lookupFunction<GetAllEventsNative, GetAllEventsDart>('get_all_events');
+      waitAndDrain = lib.lookupFunction<WaitAndDrainNative, WaitAndDrainDart>('wait_and_drain');
       isMonitoring = lib.lookupFunction<IsMonitoringNative, IsMonitoringDart>('is_monitoring');
+      acquireMappedEvents = lib.lookupFunction<AcquireMappedEventsNative, AcquireMappedEventsDart>('acquire_mapped_events');
+      releaseMappedEvents = lib.lookupFunction<ReleaseMappedEventsNative, ReleaseMappedEventsDart>('release_mapped_events');
+      unmapEventRing = lib.lookupFunction<UnmapEventRingNative, UnmapEventRingDart>('unmap_event_ring');
+      getProcessName = lib.lookupFunction<GetProcessNameNative, GetProcessNameDart>('get_process_name');
+
+      // Read events in place from the native queue instead of copying them out
+      ring = lib.lookupFunction<MapEventRingNative, MapEventRingDart>('map_event_ring')();
+      if (ring != nullptr && ring.ref.recordFormat != _compactRecordFormat && ring.ref.recordFormat != _timedRecordFormat) {
+        unmapEventRing();
+        ring = nullptr;
+      }
     } catch (e) {
       print('[ERROR] Failed to load DLL in isolate: $e');
       sendPort.send('stopped');
       return;
     }
 
-    // Event loop in background isolate
+    // Index of the first acquired event and the drain buffer, allocated once for the isolate's lifetime
+    const maxEvents = 100;
+    final firstIndex = calloc<Int64>();
+    final eventsArray = calloc<CompactProcessEvent>(maxEvents);
+
+    // Names by ID; native IDs never change meaning, so each name is converted once
+    final processNames = <int, String>{};
+    void sendEvent(CompactProcessEvent eventData) {
+      final processName = processNames.putIfAbsent(eventData.nameId, () {
+        final name = getProcessName!(eventData.nameId);
+        return name == nullptr ? '' : name.toDartString();
+      });
+
+      sendPort.send({'processName': processName, 'processId': eventData.processId, 'eventType': eventData.eventType, 'timestampMs': eventData.timestampMs, 'startTimeMs': eventData.startTimeMs});
+    }
+
+    // Event loop in background isolate. The waits block until events arrive or monitoring
+    // stops (stop_monitoring wakes them), so an idle monitor never wakes this thread.
     while (true) {
       try {
         // Check if monitoring is still active
         if (!isMonitoring()) break;
 
-        // Wait for events with 500 milliseconds timeout
-        final eventCount = waitForEvents(500);
-
-        if (eventCount > 0) {
-          // Events available, fetch all of them
-          const maxEvents = 100;
-          final eventsArray = calloc<ProcessEventData>(maxEvents);
+        if (ring != nullptr) {
+          final eventCount = waitForEvents(-1);
+          if (eventCount < 0) {
+            // This means an error has occurred
+            print('[DEBUG] Error waiting for events in isolate: $eventCount');
+            break;
+          }
 
-          try {
-            final actualCount = getAllEvents(eventsArray, maxEvents);
+          // Events available, read them where they are and hand the slots back
+          int acquiredCount;
+          do {
+            acquiredCount = acquireMappedEvents!(firstIndex, maxEvents);
 
             // Send all events to main isolate
-            for (int i = 0; i < actualCount; i++) {
-              final eventData = eventsArray.elementAt(i).ref;
-
-              sendPort.send({'processName': eventData.processName, 'processId': eventData.processId, 'eventType': eventData.eventType, 'timestampMs': eventData.timestampMs});
+            for (int i = 0; i < acquiredCount; i++) {
+              sendEvent(_mappedEventAt(ring, firstIndex.value + i));
             }
-          } finally {
-            calloc.free(eventsArray);
+            releaseMappedEvents!(acquiredCount);
+          } while (acquiredCount == maxEvents);
+        } else {
+          // Wait and copy the events out in one call
+          final actualCount = waitAndDrain(eventsArray, maxEvents, -1);
+          if (actualCount < 0) {
+            print('[DEBUG] Error waiting for events in isolate: $actualCount');
+            break;
+          }
+
+          // Send all events to main isolate
+          for (int i = 0; i < actualCount; i++) {
+            sendEvent(eventsArray[i]);
           }
-        } else if (eventCount < 0) {
-          // This means an error has occurred
-          print('[DEBUG] Error waiting for events in isolate: $eventCount');
-          break;
         }
-        // eventCount == 0 means timeout which is normal
       } catch (e) {
         print('[ERROR] Event loop isolate error: $e');
         break;
       }
     }
 
+    calloc.free(firstIndex);
+    calloc.free(eventsArray);
+    if (ring != nullptr) unmapEventRing!();
+
     sendPort.send('stopped');
   }
 
@@ -458,8 +933,7 @@ class ProcessMonitor {
   Future<bool> stopMonitoring() async {
     // Clear process-specific configurations
     _processConfigs = null;
-    _runningProcesses.clear();
-    _recentEvents.clear(); // Clear deduplication cache
+    _processConfigsByName.clear();
 
     try {
       // Cancel timer immediately
@@ -470,6 +944,10 @@ class ProcessMonitor {
       if (_backgroundIsolate != null) {
         _backgroundIsolate!.kill(priority: Isolate.immediate);
         _backgroundIsolate = null;
+
+        // The killed isolate never gets to release its mapping of the native queue, which would
+        // otherwise keep the mapped overflow policy and block set_event_queue_capacity
+        _unmapEventRing?.call();
       }
 
       // Clean up receive port
@@ -497,7 +975,7 @@ class ProcessMonitor {
     try {
       // Clear process-specific configurations
       _processConfigs = null;
-      _runningProcesses.clear();
+      _processConfigsByName.clear();
 
       // Stop monitoring immediately and synchronously
       if (isMonitoring) await stopMonitoring();
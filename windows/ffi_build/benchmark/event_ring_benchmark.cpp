@@ -0,0 +1,170 @@
+// Compares the lock-free EventRing against the mutex + std::queue it replaced,
+// with several producer threads pushing ProcessEventData and one consumer draining
+// in batches of 100 like the Dart event loop isolate.
+//
+// Usage: event_ring_benchmark [events_per_producer]
+
+#include "event_ring.h"
+#include "process_monitor_api.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+// Only every Nth push is timed, to keep the clock reads out of the measured throughput
+static constexpr int kLatencySampleInterval = 64;
+static constexpr int kDrainBatch = 100;
+static constexpr size_t kQueueCapacity = 1024;
+
+// The previous implementation: one mutex for producers and consumer, oldest events popped past 1000
+class MutexQueue
+{
+public:
+    void Push(const ProcessEventData &event_data)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_queue.push(event_data);
+        while (m_queue.size() > 1000)
+        {
+            m_queue.pop();
+            m_overwritten++;
+        }
+    }
+
+    size_t PopBatch(ProcessEventData *events, size_t max_events)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        size_t count = 0;
+        while (!m_queue.empty() && count < max_events)
+        {
+            events[count++] = m_queue.front();
+            m_queue.pop();
+        }
+        return count;
+    }
+
+    uint64_t DroppedCount() const { return 0; }
+    uint64_t OverwrittenCount() const { return m_overwritten; }
+
+private:
+    std::mutex m_mutex;
+    std::queue<ProcessEventData> m_queue;
+    uint64_t m_overwritten = 0;
+};
+
+struct Result
+{
+    double seconds;
+    uint64_t delivered;
+    uint64_t lost;
+    double p50_ns;
+    double p99_ns;
+    double max_ns;
+};
+
+template <typename Queue>
+static Result run(Queue &queue, int producers, int events_per_producer)
+{
+    std::atomic<int> running_producers{producers};
+    std::vector<std::vector<double>> latencies(producers);
+    std::vector<std::thread> threads;
+    uint64_t delivered = 0;
+
+    auto start = Clock::now();
+    for (int p = 0; p < producers; p++)
+    {
+        threads.emplace_back([&, p] {
+            ProcessEventData event_data = {};
+            snprintf(event_data.event_type, sizeof(event_data.event_type), "start");
+            snprintf(event_data.process_name, sizeof(event_data.process_name), "producer-%d.exe", p);
+            latencies[p].reserve(events_per_producer / kLatencySampleInterval + 1);
+
+            for (int i = 0; i < events_per_producer; i++)
+            {
+                event_data.process_id = i;
+                if (i % kLatencySampleInterval == 0)
+                {
+                    auto before = Clock::now();
+                    queue.Push(event_data);
+                    latencies[p].push_back(std::chrono::duration<double, std::nano>(Clock::now() - before).count());
+                }
+                else
+                {
+                    queue.Push(event_data);
+                }
+            }
+            running_producers--;
+        });
+    }
+
+    std::vector<ProcessEventData> batch(kDrainBatch);
+    while (true)
+    {
+        bool done = running_producers == 0;
+        size_t count = queue.PopBatch(batch.data(), batch.size());
+        delivered += count;
+        if (count == 0)
+        {
+            if (done)
+                break;
+            std::this_thread::yield();
+        }
+    }
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    for (auto &thread : threads)
+        thread.join();
+
+    std::vector<double> all;
+    for (auto &samples : latencies)
+        all.insert(all.end(), samples.begin(), samples.end());
+    std::sort(all.begin(), all.end());
+
+    Result result;
+    result.seconds = seconds;
+    result.delivered = delivered;
+    result.lost = queue.DroppedCount() + queue.OverwrittenCount();
+    result.p50_ns = all.empty() ? 0 : all[all.size() / 2];
+    result.p99_ns = all.empty() ? 0 : all[all.size() * 99 / 100];
+    result.max_ns = all.empty() ? 0 : all.back();
+    return result;
+}
+
+static void print(const char *name, int producers, int events_per_producer, const Result &result)
+{
+    double total = (double)producers * events_per_producer;
+    printf("%-12s %9d %14.0f %12llu %10llu %10.0f %10.0f %12.0f\n", name, producers, total / result.seconds,
+           (unsigned long long)result.delivered, (unsigned long long)result.lost, result.p50_ns, result.p99_ns, result.max_ns);
+}
+
+int main(int argc, char **argv)
+{
+    int events_per_producer = argc > 1 ? atoi(argv[1]) : 200000;
+    if (events_per_producer <= 0)
+    {
+        fprintf(stderr, "usage: %s [events_per_producer]\n", argv[0]);
+        return 1;
+    }
+
+    printf("%-12s %9s %14s %12s %10s %10s %10s %12s\n", "queue", "producers", "pushes/s", "delivered", "lost", "p50 ns", "p99 ns", "max push ns");
+    for (int producers : {1, 2, 4})
+    {
+        {
+            MutexQueue queue;
+            print("mutex_queue", producers, events_per_producer, run(queue, producers, events_per_producer));
+        }
+        {
+            EventRing<ProcessEventData> ring(kQueueCapacity);
+            print("event_ring", producers, events_per_producer, run(ring, producers, events_per_producer));
+        }
+    }
+    return 0;
+}
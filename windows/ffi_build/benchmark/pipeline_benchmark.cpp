@@ -0,0 +1,277 @@
+// Measures the hot paths of the event pipeline with synthetic events, so a change to one of
+// them can be compared before and after:
+//   - enqueue/drain: publish_process_event through deduplication, the process table and the
+//     default context's queue, drained with get_all_events (and get_all_events_compact)
+//   - name interning: exe path to file name and NameTable::Intern, for known and new names
+//   - watch-list matching: WatchList::Matches and the per-name verdicts of ProcessFilter
+//   - deduplication: EventDeduplicator::IsDuplicate with every event seen twice
+//
+// The library is compiled into the benchmark so its internal functions can be driven directly.
+// Every allocation is counted through a replaced operator new.
+// Prints one JSON object with events/sec, ns/event and allocations/event per stage.
+//
+// Usage: pipeline_benchmark [events_per_stage]
+
+#include "event_dedup.h"
+#include "event_source.h"
+#include "name_table.h"
+#include "process_filter.h"
+#include "process_monitor_api.h"
+#include "procfs.h"
+#include "watch_list.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+static std::atomic<uint64_t> g_allocations{0};
+
+void *operator new(size_t size)
+{
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void *memory = malloc(size ? size : 1))
+        return memory;
+    throw std::bad_alloc();
+}
+
+void *operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void *memory) noexcept
+{
+    free(memory);
+}
+
+void operator delete[](void *memory) noexcept
+{
+    free(memory);
+}
+
+void operator delete(void *memory, size_t) noexcept
+{
+    free(memory);
+}
+
+void operator delete[](void *memory, size_t) noexcept
+{
+    free(memory);
+}
+
+static constexpr int kNameCount = 64;
+static constexpr int kWatchedCount = 16;
+static constexpr int kDrainBatch = 100;
+
+struct Stage
+{
+    const char *name;
+    uint64_t events;
+    double seconds;
+    uint64_t allocations;
+};
+
+static std::vector<Stage> g_stages;
+
+// Runs `body` once over `events` events and records its cost
+template <typename Body>
+static void measure(const char *name, uint64_t events, Body body)
+{
+    uint64_t allocations = g_allocations.load(std::memory_order_relaxed);
+    auto start = Clock::now();
+    body();
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    g_stages.push_back({name, events, seconds, g_allocations.load(std::memory_order_relaxed) - allocations});
+}
+
+static std::string synthetic_name(int index)
+{
+    return "synthetic-" + std::to_string(index);
+}
+
+static CompactProcessEvent synthetic_event(unsigned char type, int pid, uint32_t name_id)
+{
+    CompactProcessEvent event = {};
+    event.event_type = type;
+    event.process_id = pid;
+    event.parent_process_id = 1;
+    event.name_id = name_id;
+    event.start_time_ms = 1000000 + pid;
+    event.timestamp_ms = event.start_time_ms;
+    return event;
+}
+
+// Start and stop of `events / 2` processes through the default context, drained every kDrainBatch events
+static bool bench_enqueue_drain(int events)
+{
+    // A /proc scan that never comes round again keeps real processes out of the measurement
+    set_event_source(PROCESS_EVENT_SOURCE_PROC_SCAN);
+    set_proc_scan_interval(24 * 60 * 60 * 1000);
+    if (!initialize_process_monitor() || !start_monitoring())
+    {
+        fprintf(stderr, "start_monitoring failed: %s\n", get_last_error());
+        return false;
+    }
+
+    uint32_t name_ids[kNameCount];
+    for (int i = 0; i < kNameCount; i++)
+        name_ids[i] = intern_process_name(synthetic_name(i));
+
+    std::vector<ProcessEventData> expanded(kDrainBatch);
+    std::vector<CompactProcessEvent> compact(kDrainBatch);
+    while (get_all_events(expanded.data(), kDrainBatch) > 0)
+    {
+    }
+
+    int next_pid = 1000000;
+    auto run = [&](bool expand) {
+        uint64_t drained = 0;
+        for (int i = 0; i < events; i += 2)
+        {
+            int pid = next_pid++;
+            uint32_t name_id = name_ids[pid % kNameCount];
+            publish_process_event(synthetic_event(PROCESS_EVENT_START, pid, name_id));
+            publish_process_event(synthetic_event(PROCESS_EVENT_STOP, pid, name_id));
+            if ((i + 2) % kDrainBatch == 0)
+                drained += expand ? get_all_events(expanded.data(), kDrainBatch) : get_all_events_compact(compact.data(), kDrainBatch);
+        }
+        drained += expand ? get_all_events(expanded.data(), kDrainBatch) : get_all_events_compact(compact.data(), kDrainBatch);
+        if (drained != (uint64_t)events)
+            fprintf(stderr, "enqueue/drain: drained %llu of %d events\n", (unsigned long long)drained, events);
+    };
+
+    measure("enqueue_drain", (uint64_t)events, [&] { run(true); });
+    measure("enqueue_drain_compact", (uint64_t)events, [&] { run(false); });
+
+    stop_monitoring();
+    cleanup_process_monitor();
+    return true;
+}
+
+static void bench_name_interning(int events)
+{
+    std::vector<std::string> paths;
+    for (int i = 0; i < kNameCount; i++)
+        paths.push_back("/usr/lib/synthetic/bin/" + synthetic_name(i));
+
+    // Names seen before, as with a busy system that keeps starting the same programs
+    NameTable known;
+    for (const std::string &path : paths)
+        known.Intern(exe_file_name(path));
+    uint64_t checksum = 0;
+    measure("name_intern_known", (uint64_t)events, [&] {
+        for (int i = 0; i < events; i++)
+            checksum += known.Intern(exe_file_name(paths[i % kNameCount]));
+    });
+
+    // Every name new to the table
+    std::vector<std::string> fresh_names;
+    fresh_names.reserve(events);
+    for (int i = 0; i < events; i++)
+        fresh_names.push_back(synthetic_name(kNameCount + i));
+    NameTable fresh;
+    measure("name_intern_new", (uint64_t)events, [&] {
+        for (int i = 0; i < events; i++)
+            checksum += fresh.Intern(fresh_names[i]);
+    });
+
+    if (checksum == 0)
+        fprintf(stderr, "name interning returned no IDs\n");
+}
+
+static void bench_watch_list(int events)
+{
+    WatchList watch_list;
+    for (int i = 0; i < kWatchedCount; i++)
+        watch_list.Add(synthetic_name(i * kNameCount / kWatchedCount));
+
+    NameTable names;
+    std::vector<std::string> strings;
+    std::vector<uint32_t> name_ids;
+    for (int i = 0; i < kNameCount; i++)
+    {
+        strings.push_back(synthetic_name(i));
+        name_ids.push_back(names.Intern(strings.back()));
+    }
+
+    uint64_t matches = 0;
+    measure("watch_list_match", (uint64_t)events, [&] {
+        for (int i = 0; i < events; i++)
+            matches += watch_list.Matches(strings[i % kNameCount].c_str()) ? 1 : 0;
+    });
+
+    // The verdict per name ID is cached after the first sighting; starts and stops alternate
+    ProcessFilter filter(watch_list);
+    measure("process_filter", (uint64_t)events, [&] {
+        for (int i = 0; i < events; i += 2)
+        {
+            int index = i % kNameCount;
+            ProcessKey key = make_process_key(2000000 + i, 1000000 + i);
+            matches += filter.AcceptStart(key, 1000000 + i, name_ids[index], strings[index].c_str()) ? 1 : 0;
+            matches += filter.AcceptStop(key, name_ids[index], strings[index].c_str()) ? 1 : 0;
+        }
+    });
+
+    if (matches == 0)
+        fprintf(stderr, "watch list matched nothing\n");
+}
+
+static void bench_dedup(int events)
+{
+    EventDeduplicator dedup;
+    uint64_t duplicates = 0;
+    measure("dedup", (uint64_t)events, [&] {
+        for (int i = 0; i < events; i += 2)
+        {
+            CompactProcessEvent event = synthetic_event(PROCESS_EVENT_START, 3000000 + i, (uint32_t)(i % kNameCount) + 1);
+            long long now_ms = i / 1000;
+            duplicates += dedup.IsDuplicate(event, now_ms) ? 1 : 0;
+            duplicates += dedup.IsDuplicate(event, now_ms) ? 1 : 0;
+        }
+    });
+
+    if (duplicates != (uint64_t)events / 2)
+        fprintf(stderr, "dedup: %llu duplicates of %d events\n", (unsigned long long)duplicates, events);
+}
+
+static void print_json(int events)
+{
+    printf("{\n  \"benchmark\": \"pipeline\",\n  \"events_per_stage\": %d,\n  \"stages\": [\n", events);
+    for (size_t i = 0; i < g_stages.size(); i++)
+    {
+        const Stage &stage = g_stages[i];
+        double events_per_sec = stage.seconds > 0 ? (double)stage.events / stage.seconds : 0;
+        double ns_per_event = stage.events > 0 ? stage.seconds * 1e9 / (double)stage.events : 0;
+        double allocs_per_event = stage.events > 0 ? (double)stage.allocations / (double)stage.events : 0;
+        printf("    {\"stage\": \"%s\", \"events\": %llu, \"seconds\": %.6f, \"events_per_sec\": %.0f, \"ns_per_event\": %.2f, \"allocs_per_event\": %.4f}%s\n",
+               stage.name, (unsigned long long)stage.events, stage.seconds, events_per_sec, ns_per_event, allocs_per_event,
+               i + 1 < g_stages.size() ? "," : "");
+    }
+    printf("  ]\n}\n");
+}
+
+int main(int argc, char **argv)
+{
+    int events = argc > 1 ? atoi(argv[1]) : 1000000;
+    if (events <= 0)
+    {
+        fprintf(stderr, "usage: %s [events_per_stage]\n", argv[0]);
+        return 1;
+    }
+    events += events % 2; // Stages that pair events need an even count
+
+    if (!bench_enqueue_drain(events))
+        return 1;
+    bench_name_interning(events);
+    bench_watch_list(events);
+    bench_dedup(events);
+
+    print_json(events);
+    return 0;
+}
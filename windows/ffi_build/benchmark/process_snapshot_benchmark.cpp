@@ -0,0 +1,166 @@
+// Measures the running-process queries with a given number of processes alive: a fresh
+// snapshot_processes scan (getdents64 listing plus one stat parse per PID) against the
+// readdir loop it replaced, and the same queries answered from the live table while monitoring.
+//
+// Idle child processes are forked to reach the requested count, so the PID limit
+// (/proc/sys/kernel/pid_max, RLIMIT_NPROC, the cgroup's pids.max) may need raising.
+//
+// Usage: process_snapshot_benchmark [process_count] [iterations]
+
+#include "process_monitor_api.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/prctl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using Clock = std::chrono::steady_clock;
+
+// The previous listing: readdir over /proc, then stat and exe for each PID
+static size_t readdir_scan()
+{
+    int proc_fd = open("/proc", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    DIR *proc_dir = fdopendir(dup(proc_fd));
+    size_t count = 0;
+    while (dirent *entry = readdir(proc_dir))
+    {
+        char *end = nullptr;
+        long pid = strtol(entry->d_name, &end, 10);
+        if (pid <= 0 || *end != '\0')
+            continue;
+
+        char path[64];
+        snprintf(path, sizeof(path), "%ld/stat", pid);
+        int fd = openat(proc_fd, path, O_RDONLY | O_CLOEXEC);
+        if (fd < 0)
+            continue;
+        char buffer[1024];
+        ssize_t length = read(fd, buffer, sizeof(buffer) - 1);
+        close(fd);
+        if (length <= 0)
+            continue;
+
+        snprintf(path, sizeof(path), "%ld/exe", pid);
+        char target[4096];
+        readlinkat(proc_fd, path, target, sizeof(target));
+        count++;
+    }
+    closedir(proc_dir);
+    close(proc_fd);
+    return count;
+}
+
+// Median wall time of `iterations` calls, in microseconds
+template <typename Call>
+static double median_us(int iterations, Call call)
+{
+    std::vector<double> samples;
+    for (int i = 0; i < iterations; i++)
+    {
+        auto start = Clock::now();
+        call();
+        samples.push_back(std::chrono::duration<double, std::micro>(Clock::now() - start).count());
+    }
+    std::sort(samples.begin(), samples.end());
+    return samples[samples.size() / 2];
+}
+
+static std::vector<pid_t> spawn_idle_children(int count)
+{
+    std::vector<pid_t> children;
+    children.reserve(count);
+    for (int i = 0; i < count; i++)
+    {
+        pid_t pid = fork();
+        if (pid < 0)
+        {
+            fprintf(stderr, "fork failed after %d children: %s\n", i, strerror(errno));
+            break;
+        }
+        if (pid == 0)
+        {
+            prctl(PR_SET_PDEATHSIG, SIGKILL);
+            for (;;)
+                pause();
+        }
+        children.push_back(pid);
+    }
+    return children;
+}
+
+int main(int argc, char **argv)
+{
+    int process_count = argc > 1 ? atoi(argv[1]) : 50000;
+    int iterations = argc > 2 ? atoi(argv[2]) : 5;
+    if (process_count < 0 || iterations <= 0)
+    {
+        fprintf(stderr, "usage: %s [process_count] [iterations]\n", argv[0]);
+        return 1;
+    }
+
+    // Counts what is already running towards the total
+    int running = snapshot_processes(nullptr, 0);
+    std::vector<pid_t> children = spawn_idle_children(std::max(0, process_count - running));
+
+    std::string own_name = argv[0];
+    own_name = own_name.substr(own_name.rfind('/') + 1);
+
+    std::vector<ProcessSnapshotEntry> entries(process_count + 4096);
+    std::vector<int> pids(process_count + 4096);
+    int listed = 0;
+    int matched = 0;
+
+    printf("%-28s %12s %12s\n", "query", "processes", "median us");
+
+    size_t scanned = 0;
+    double us = median_us(iterations, [&] { scanned = readdir_scan(); });
+    printf("%-28s %12zu %12.0f\n", "readdir scan", scanned, us);
+
+    us = median_us(iterations, [&] { listed = snapshot_processes(entries.data(), (int)entries.size()); });
+    printf("%-28s %12d %12.0f\n", "snapshot_processes (scan)", listed, us);
+
+    us = median_us(iterations, [&] { matched = pids_of(own_name.c_str(), pids.data(), (int)pids.size()); });
+    printf("%-28s %12d %12.0f\n", "pids_of (scan)", matched, us);
+
+    // The table is loaded once when monitoring starts; queries after that touch no files
+    auto start = Clock::now();
+    if (!start_monitoring())
+    {
+        fprintf(stderr, "start_monitoring failed: %s\n", get_last_error());
+    }
+    else
+    {
+        listed = snapshot_processes(nullptr, 0);
+        printf("%-28s %12d %12.0f\n", "start + table load", listed, std::chrono::duration<double, std::micro>(Clock::now() - start).count());
+
+        us = median_us(iterations, [&] { listed = snapshot_processes(entries.data(), (int)entries.size()); });
+        printf("%-28s %12d %12.0f\n", "snapshot_processes (table)", listed, us);
+
+        us = median_us(iterations, [&] { matched = pids_of(own_name.c_str(), pids.data(), (int)pids.size()); });
+        printf("%-28s %12d %12.0f\n", "pids_of (table)", matched, us);
+
+        bool found = false;
+        us = median_us(iterations, [&] { found = is_running(own_name.c_str()); });
+        printf("%-28s %12d %12.3f\n", "is_running (table)", found ? 1 : 0, us);
+
+        stop_monitoring();
+    }
+    cleanup_process_monitor();
+
+    for (pid_t child : children)
+        kill(child, SIGKILL);
+    for (pid_t child : children)
+        waitpid(child, nullptr, 0);
+    return 0;
+}
@@ -0,0 +1,413 @@
+// Measures how completely each Linux backend reports process storms. The harness spawns
+// processes itself, so it knows every PID that started and when, and compares that ground
+// truth with what the library delivered:
+//   - short:     processes that live for a few milliseconds, at a fixed rate
+//   - exec_exit: processes that exit as soon as they have exec'd
+//   - chain:     fork chains, each process exec'ing the next level before it exits
+//   - fork_only: forked processes that exit after a few milliseconds without exec'ing, like
+//                pre-forked workers; the proc connector reports neither their start nor their stop
+//
+// Outside fork_only every spawned process re-execs this binary, so the proc connector reports its
+// start. Spawn times are taken just before fork() and exit times just before _exit(), on CLOCK_MONOTONIC,
+// the clock of TimedProcessEvent, so detection latency is dequeue time minus those.
+// Prints one JSON object with the capture rates, duplicates, stops delivered before their
+// starts, stops delivered without any start and p50/p99/p999 latencies for every storm and backend.
+//
+// Usage: process_storm_harness [processes_per_second] [seconds] [chain_depth]
+
+#include "process_monitor_api.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+static constexpr int kShortLifetimeUs = 5000;
+static constexpr int kQueueCapacity = 1 << 16;
+static constexpr int kDrainBatch = 1024;
+static constexpr int kSettleMs = 500; // Time left for the last exits to come through
+
+// Written to the ground-truth pipe by spawned processes; small enough to be written atomically
+struct TruthRecord
+{
+    int32_t type; // PROCESS_EVENT_START when spawned, PROCESS_EVENT_STOP when exiting
+    int32_t pid;
+    int64_t time_ns;
+};
+
+struct Delivered
+{
+    unsigned char type;
+    int pid;
+    long long dequeue_ns;
+};
+
+static long long monotonic_ns()
+{
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (long long)now.tv_sec * 1000000000LL + now.tv_nsec;
+}
+
+static void write_record(int fd, int type, int pid, long long time_ns)
+{
+    TruthRecord record = {type, pid, time_ns};
+    ssize_t written;
+    do
+        written = write(fd, &record, sizeof(record));
+    while (written < 0 && errno == EINTR);
+}
+
+// Spawns `depth` levels of this binary in child mode, or with `exec` false a plain fork that
+// lives out `lifetime_us`; returns the first PID, or -1
+static pid_t spawn_child(int truth_fd, int depth, int lifetime_us, bool exec, long long *spawn_ns)
+{
+    char fd_arg[16], depth_arg[16], lifetime_arg[16];
+    snprintf(fd_arg, sizeof(fd_arg), "%d", truth_fd);
+    snprintf(depth_arg, sizeof(depth_arg), "%d", depth);
+    snprintf(lifetime_arg, sizeof(lifetime_arg), "%d", lifetime_us);
+
+    *spawn_ns = monotonic_ns();
+    pid_t pid = fork();
+    if (pid == 0 && !exec)
+    {
+        usleep((useconds_t)lifetime_us);
+        write_record(truth_fd, PROCESS_EVENT_STOP, (int)getpid(), monotonic_ns());
+        _exit(0);
+    }
+    if (pid == 0)
+    {
+        char *args[] = {(char *)"process_storm_harness", (char *)"--child", fd_arg, depth_arg, lifetime_arg, nullptr};
+        execv("/proc/self/exe", args);
+        _exit(127);
+    }
+    return pid;
+}
+
+// One process of a storm: starts the next level of a chain, waits for it, lives out its
+// lifetime and reports its exit
+static int run_child(int truth_fd, int depth, int lifetime_us)
+{
+    if (depth > 1)
+    {
+        long long spawn_ns = 0;
+        pid_t pid = spawn_child(truth_fd, depth - 1, lifetime_us, true, &spawn_ns);
+        if (pid > 0)
+        {
+            write_record(truth_fd, PROCESS_EVENT_START, pid, spawn_ns);
+            waitpid(pid, nullptr, 0);
+        }
+    }
+    if (lifetime_us > 0)
+        usleep((useconds_t)lifetime_us);
+
+    write_record(truth_fd, PROCESS_EVENT_STOP, (int)getpid(), monotonic_ns());
+    _exit(0);
+}
+
+struct Storm
+{
+    const char *name;
+    int depth;
+    int lifetime_us;
+    bool exec;
+};
+
+struct Backend
+{
+    const char *name;
+    ProcessEventSourceType type;
+};
+
+struct Percentiles
+{
+    double p50_us = 0;
+    double p99_us = 0;
+    double p999_us = 0;
+};
+
+struct Result
+{
+    std::string storm;
+    std::string backend;
+    std::string error;
+    long long processes = 0;
+    long long starts_seen = 0;
+    long long stops_seen = 0;
+    long long duplicates = 0;
+    long long misordered = 0;
+    long long unpaired_stops = 0;
+    long long queue_dropped = 0;
+    Percentiles start_latency;
+    Percentiles stop_latency;
+};
+
+static Percentiles percentiles(std::vector<long long> &latencies_ns)
+{
+    Percentiles result;
+    if (latencies_ns.empty())
+        return result;
+
+    std::sort(latencies_ns.begin(), latencies_ns.end());
+    auto at = [&](double quantile) {
+        size_t index = (size_t)(quantile * (double)(latencies_ns.size() - 1));
+        return (double)std::max(0LL, latencies_ns[index]) / 1000.0;
+    };
+    result.p50_us = at(0.5);
+    result.p99_us = at(0.99);
+    result.p999_us = at(0.999);
+    return result;
+}
+
+static bool start_backend(const Backend &backend, std::string *error)
+{
+    set_event_source(backend.type);
+    set_event_queue_capacity(kQueueCapacity, EVENT_QUEUE_DROP_NEWEST);
+    if (!start_monitoring())
+    {
+        *error = get_last_error();
+        return false;
+    }
+
+    // The source is created on the monitor thread; it fails there if it is not available
+    for (int i = 0; i < 500 && is_monitoring(); i++)
+    {
+        if (get_active_event_source() == backend.type)
+            return true;
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    *error = get_last_error();
+    stop_monitoring();
+    return false;
+}
+
+static Result run_storm(const Storm &storm, const Backend &backend, int processes_per_second, int seconds)
+{
+    Result result;
+    result.storm = storm.name;
+    result.backend = backend.name;
+    if (!start_backend(backend, &result.error))
+        return result;
+
+    int truth_pipe[2];
+    if (pipe(truth_pipe) != 0)
+    {
+        result.error = std::string("pipe failed: ") + strerror(errno);
+        stop_monitoring();
+        return result;
+    }
+    fcntl(truth_pipe[0], F_SETFD, FD_CLOEXEC);
+
+    std::vector<TruthRecord> truth;
+    std::thread truth_reader([&] {
+        TruthRecord record;
+        while (read(truth_pipe[0], &record, sizeof(record)) == (ssize_t)sizeof(record))
+            truth.push_back(record);
+    });
+
+    std::atomic<bool> collecting{true};
+    std::vector<Delivered> delivered;
+    std::thread consumer([&] {
+        std::vector<TimedProcessEvent> events(kDrainBatch);
+        while (true)
+        {
+            bool last_pass = !collecting;
+            int count = wait_and_drain_timed(events.data(), kDrainBatch, 50);
+            for (int i = 0; i < count; i++)
+                delivered.push_back({events[i].event.event_type, events[i].event.process_id, events[i].dequeue_time_ns});
+            if (last_pass && count <= 0)
+                break;
+        }
+    });
+
+    std::atomic<long long> spawned{0};
+    std::atomic<bool> spawning{true};
+    std::thread reaper([&] {
+        long long reaped = 0;
+        while (spawning || reaped < spawned)
+        {
+            if (waitpid(-1, nullptr, 0) > 0)
+                reaped++;
+            else
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    });
+
+    // A chain counts as `depth` processes, so every storm spawns about the same number per second
+    std::vector<TruthRecord> spawns;
+    long long total = (long long)processes_per_second * seconds / storm.depth;
+    auto start = std::chrono::steady_clock::now();
+    for (long long i = 0; i < total; i++)
+    {
+        std::this_thread::sleep_until(start + std::chrono::nanoseconds(i * 1000000000LL * storm.depth / processes_per_second));
+        long long spawn_ns = 0;
+        pid_t pid = spawn_child(truth_pipe[1], storm.depth, storm.lifetime_us, storm.exec, &spawn_ns);
+        if (pid > 0)
+        {
+            spawns.push_back({PROCESS_EVENT_START, pid, spawn_ns});
+            spawned++;
+        }
+    }
+    spawning = false;
+    reaper.join();
+
+    // Every process holding the write end has exited
+    close(truth_pipe[1]);
+    truth_reader.join();
+    close(truth_pipe[0]);
+
+    // Slower backends report what they saw on their next pass
+    EventQueueStats queue_stats = {};
+    std::this_thread::sleep_for(std::chrono::milliseconds(kSettleMs));
+    if (backend.type == PROCESS_EVENT_SOURCE_PROC_SCAN)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+    collecting = false;
+    consumer.join();
+    get_event_queue_stats(&queue_stats);
+    stop_monitoring();
+    result.queue_dropped = queue_stats.dropped + queue_stats.overwritten;
+
+    // Ground truth by PID: spawned at, exited at
+    struct Process
+    {
+        long long spawn_ns = 0;
+        long long exit_ns = 0;
+        int starts = 0;
+        int stops = 0;
+        bool stop_first = false;
+    };
+    std::unordered_map<int, Process> processes;
+    truth.insert(truth.end(), spawns.begin(), spawns.end());
+    for (const TruthRecord &record : truth)
+    {
+        Process &process = processes[record.pid];
+        if (record.type == PROCESS_EVENT_START)
+            process.spawn_ns = record.time_ns;
+        else
+            process.exit_ns = record.time_ns;
+    }
+
+    std::vector<long long> start_latencies;
+    std::vector<long long> stop_latencies;
+    for (const Delivered &event : delivered)
+    {
+        auto found = processes.find(event.pid);
+        if (found == processes.end())
+            continue; // Some other process on the system
+        Process &process = found->second;
+        if (event.type == PROCESS_EVENT_START)
+        {
+            if (process.starts++ == 0)
+                start_latencies.push_back(event.dequeue_ns - process.spawn_ns);
+        }
+        else if (event.type == PROCESS_EVENT_STOP)
+        {
+            if (process.starts == 0 && process.stops == 0)
+                process.stop_first = true;
+            if (process.stops++ == 0)
+                stop_latencies.push_back(event.dequeue_ns - process.exit_ns);
+        }
+    }
+
+    for (const auto &entry : processes)
+    {
+        const Process &process = entry.second;
+        result.processes++;
+        result.starts_seen += process.starts > 0 ? 1 : 0;
+        result.stops_seen += process.stops > 0 ? 1 : 0;
+        result.duplicates += std::max(0, process.starts - 1) + std::max(0, process.stops - 1);
+        result.misordered += process.stop_first && process.starts > 0 ? 1 : 0;
+        result.unpaired_stops += process.stops > 0 && process.starts == 0 ? 1 : 0;
+    }
+    result.start_latency = percentiles(start_latencies);
+    result.stop_latency = percentiles(stop_latencies);
+    return result;
+}
+
+static void print_percentiles(const char *name, const Percentiles &latency)
+{
+    printf("\"%s\": {\"p50\": %.1f, \"p99\": %.1f, \"p999\": %.1f}", name, latency.p50_us, latency.p99_us, latency.p999_us);
+}
+
+static void print_json(int processes_per_second, int seconds, int chain_depth, const std::vector<Result> &results)
+{
+    printf("{\n  \"harness\": \"process_storm\",\n  \"processes_per_second\": %d,\n  \"seconds\": %d,\n  \"chain_depth\": %d,\n  \"results\": [\n",
+           processes_per_second, seconds, chain_depth);
+    for (size_t i = 0; i < results.size(); i++)
+    {
+        const Result &result = results[i];
+        printf("    {\"storm\": \"%s\", \"backend\": \"%s\", ", result.storm.c_str(), result.backend.c_str());
+        if (!result.error.empty())
+        {
+            printf("\"error\": \"%s\"}%s\n", result.error.c_str(), i + 1 < results.size() ? "," : "");
+            continue;
+        }
+
+        double processes = result.processes > 0 ? (double)result.processes : 1;
+        printf("\"processes\": %lld, \"start_capture_rate\": %.4f, \"stop_capture_rate\": %.4f, \"duplicates\": %lld, "
+               "\"stop_before_start\": %lld, \"stop_without_start\": %lld, \"queue_dropped\": %lld, ",
+               result.processes, result.starts_seen / processes, result.stops_seen / processes, result.duplicates,
+               result.misordered, result.unpaired_stops, result.queue_dropped);
+        print_percentiles("start_latency_us", result.start_latency);
+        printf(", ");
+        print_percentiles("stop_latency_us", result.stop_latency);
+        printf("}%s\n", i + 1 < results.size() ? "," : "");
+    }
+    printf("  ]\n}\n");
+}
+
+int main(int argc, char **argv)
+{
+    if (argc == 5 && strcmp(argv[1], "--child") == 0)
+        return run_child(atoi(argv[2]), atoi(argv[3]), atoi(argv[4]));
+
+    int processes_per_second = argc > 1 ? atoi(argv[1]) : 500;
+    int seconds = argc > 2 ? atoi(argv[2]) : 3;
+    int chain_depth = argc > 3 ? atoi(argv[3]) : 16;
+    if (processes_per_second <= 0 || seconds <= 0 || chain_depth <= 1)
+    {
+        fprintf(stderr, "usage: %s [processes_per_second] [seconds] [chain_depth > 1]\n", argv[0]);
+        return 1;
+    }
+
+    const Storm storms[] = {
+        {"short", 1, kShortLifetimeUs, true},
+        {"exec_exit", 1, 0, true},
+        {"chain", chain_depth, 0, true},
+        {"fork_only", 1, kShortLifetimeUs, false},
+    };
+    const Backend backends[] = {
+        {"proc_connector", PROCESS_EVENT_SOURCE_PROC_CONNECTOR},
+        {"proc_scan", PROCESS_EVENT_SOURCE_PROC_SCAN},
+    };
+
+    if (!initialize_process_monitor())
+    {
+        fprintf(stderr, "initialize_process_monitor failed: %s\n", get_last_error());
+        return 1;
+    }
+
+    std::vector<Result> results;
+    for (const Backend &backend : backends)
+    {
+        for (const Storm &storm : storms)
+            results.push_back(run_storm(storm, backend, processes_per_second, seconds));
+    }
+    cleanup_process_monitor();
+
+    print_json(processes_per_second, seconds, chain_depth, results);
+    return 0;
+}
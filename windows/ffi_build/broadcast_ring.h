@@ -0,0 +1,219 @@
+#ifndef BROADCAST_RING_H_
+#define BROADCAST_RING_H_
+
+#include "event_ring.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+
+// Read position of one broadcast subscriber
+struct BroadcastCursor
+{
+    uint64_t position = 0; // Next position to read
+};
+
+// Bounded ring read by any number of subscribers, each with its own cursor, so every
+// subscriber sees every item and nothing is copied per subscriber on the way in.
+//
+// The producer never waits for readers: it overwrites the oldest slot once the ring is full.
+// Every slot carries a sequence (a seqlock) that is odd while the slot is being written and
+// 2 * (position + 1) once it holds the item for `position`, so a reader that fell more than
+// a ring behind sees a newer sequence, skips ahead to the oldest item still in the ring and
+// is told how many it lost. Items are stored as 64-bit atomic words, so a read racing a
+// write is detected rather than undefined.
+//
+// Single producer: concurrent Publish() calls are serialized by a mutex that only producers take.
+template <typename T>
+class BroadcastRing
+{
+    static_assert(std::is_trivially_copyable<T>::value && sizeof(T) % sizeof(uint64_t) == 0, "BroadcastRing needs a trivially copyable T made of whole 64-bit words");
+
+public:
+    explicit BroadcastRing(size_t capacity)
+    {
+        size_t rounded = 2;
+        while (rounded < capacity)
+            rounded <<= 1;
+
+        m_slots.reset(new Slot[rounded]);
+        m_mask = rounded - 1;
+        for (size_t i = 0; i < rounded; i++)
+        {
+            m_slots[i].sequence.store(0, std::memory_order_relaxed);
+            for (auto &word : m_slots[i].words)
+                word.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    BroadcastRing(const BroadcastRing &) = delete;
+    BroadcastRing &operator=(const BroadcastRing &) = delete;
+
+    void Publish(const T &item)
+    {
+        uint64_t words[kWords];
+        memcpy(words, &item, sizeof(T));
+
+        {
+            std::lock_guard<std::mutex> lock(m_producer_mutex);
+            uint64_t position = m_tail.value.load(std::memory_order_relaxed);
+            Slot &slot = m_slots[position & m_mask];
+
+            slot.sequence.store(2 * position + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            for (size_t i = 0; i < kWords; i++)
+                slot.words[i].store(words[i], std::memory_order_relaxed);
+            slot.sequence.store(2 * (position + 1), std::memory_order_release);
+
+            m_tail.value.store(position + 1, std::memory_order_release);
+        }
+
+        // Readers blocked in Wait() register themselves, so an unwatched ring costs no wakeup.
+        // The fence pairs with the one in Wait(): either the reader sees the new tail or this sees the reader.
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (m_waiters.load(std::memory_order_relaxed) > 0)
+        {
+            std::lock_guard<std::mutex> lock(m_wait_mutex);
+            m_wait_cond.notify_all();
+        }
+    }
+
+    // A cursor that starts with the next item published
+    BroadcastCursor Subscribe() const
+    {
+        BroadcastCursor cursor;
+        cursor.position = m_tail.value.load(std::memory_order_acquire);
+        return cursor;
+    }
+
+    // Copies up to `max_items` unread items and advances the cursor. Adds the number of items
+    // that were overwritten before this reader got to them to `*lost`.
+    size_t Read(BroadcastCursor *cursor, T *items, size_t max_items, uint64_t *lost)
+    {
+        return ReadWith(cursor, max_items, lost, [items](size_t index, const T &item) { items[index] = item; });
+    }
+
+    // Same as Read, handing each item to `store(index, item)` instead of copying it into an array
+    template <typename Store>
+    size_t ReadWith(BroadcastCursor *cursor, size_t max_items, uint64_t *lost, Store store)
+    {
+        size_t count = 0;
+        while (count < max_items)
+        {
+            uint64_t position = cursor->position;
+            const Slot &slot = m_slots[position & m_mask];
+
+            uint64_t expected = 2 * (position + 1);
+            uint64_t sequence = slot.sequence.load(std::memory_order_acquire);
+            if (sequence < expected)
+                break; // Not written yet, or being written for the first time
+
+            uint64_t words[kWords];
+            if (sequence == expected)
+            {
+                for (size_t i = 0; i < kWords; i++)
+                    words[i] = slot.words[i].load(std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (slot.sequence.load(std::memory_order_relaxed) == expected)
+                {
+                    T item;
+                    memcpy(&item, words, sizeof(T));
+                    store(count++, item);
+                    cursor->position = position + 1;
+                    continue;
+                }
+            }
+
+            // Overwritten: skip to the oldest item still in the ring
+            uint64_t tail = m_tail.value.load(std::memory_order_acquire);
+            uint64_t oldest = tail > m_mask + 1 ? tail - (m_mask + 1) : 0;
+            if (oldest <= position)
+                oldest = position + 1;
+            *lost += oldest - position;
+            cursor->position = oldest;
+        }
+        return count;
+    }
+
+    // Waits until an item past the cursor is published, for `timeout_ms` (negative waits
+    // without limit), or until Interrupt() is called after Interrupts() returned `interrupts`.
+    // Taking `interrupts` before checking why to wait means an interruption in between isn't missed.
+    // Returns false on timeout or interruption.
+    bool Wait(const BroadcastCursor &cursor, uint64_t interrupts, int timeout_ms)
+    {
+        std::unique_lock<std::mutex> lock(m_wait_mutex);
+        auto ready = [&] { return m_tail.value.load(std::memory_order_acquire) > cursor.position || m_interrupts != interrupts; };
+
+        m_waiters.fetch_add(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        bool woken;
+        if (timeout_ms < 0)
+        {
+            m_wait_cond.wait(lock, ready);
+            woken = true;
+        }
+        else
+        {
+            woken = m_wait_cond.wait_for(lock, std::chrono::milliseconds(timeout_ms), ready);
+        }
+        m_waiters.fetch_sub(1, std::memory_order_acq_rel);
+        return woken && m_interrupts == interrupts;
+    }
+
+    uint64_t Interrupts()
+    {
+        std::lock_guard<std::mutex> lock(m_wait_mutex);
+        return m_interrupts;
+    }
+
+    // Releases every reader blocked in Wait()
+    void Interrupt()
+    {
+        std::lock_guard<std::mutex> lock(m_wait_mutex);
+        m_interrupts++;
+        m_wait_cond.notify_all();
+    }
+
+    size_t Capacity() const { return m_mask + 1; }
+    uint64_t Published() const { return m_tail.value.load(std::memory_order_acquire); }
+
+    // Items a cursor has not read yet, including any it has already lost
+    uint64_t Backlog(const BroadcastCursor &cursor) const
+    {
+        uint64_t tail = m_tail.value.load(std::memory_order_acquire);
+        return tail > cursor.position ? tail - cursor.position : 0;
+    }
+
+private:
+    static constexpr size_t kWords = sizeof(T) / sizeof(uint64_t);
+
+    struct alignas(kCacheLineSize) Slot
+    {
+        std::atomic<uint64_t> sequence;
+        std::atomic<uint64_t> words[kWords];
+    };
+
+    struct alignas(kCacheLineSize) PaddedCounter
+    {
+        std::atomic<uint64_t> value{0};
+    };
+
+    std::unique_ptr<Slot[]> m_slots;
+    size_t m_mask = 0;
+    PaddedCounter m_tail; // Next position to publish
+
+    std::mutex m_producer_mutex;
+
+    std::mutex m_wait_mutex;
+    std::condition_variable m_wait_cond;
+    std::atomic<int> m_waiters{0};
+    uint64_t m_interrupts = 0;
+};
+
+#endif // BROADCAST_RING_H_
@@ -0,0 +1,63 @@
+#include "dart_port.h"
+#include "event_source.h"
+
+#include <cstring>
+#include <string>
+
+// DartApi / DartApiEntry from dart_api_dl.h
+struct DartApiEntry
+{
+    const char *name;
+    void (*function)();
+};
+
+struct DartApi
+{
+    int major;
+    int minor;
+    const DartApiEntry *functions; // Terminated by an entry with a null name
+};
+
+static constexpr int kDartApiDlMajorVersion = 2;
+
+bool DartPortPoster::Initialize(void *api_dl_data)
+{
+    m_post_cobject = nullptr;
+
+    const DartApi *api = (const DartApi *)api_dl_data;
+    if (api == nullptr || api->functions == nullptr)
+    {
+        set_last_error("Missing Dart API DL data");
+        return false;
+    }
+    if (api->major != kDartApiDlMajorVersion)
+    {
+        set_last_error("Unsupported Dart API DL version " + std::to_string(api->major) + "." + std::to_string(api->minor));
+        return false;
+    }
+
+    for (const DartApiEntry *entry = api->functions; entry->name != nullptr; entry++)
+    {
+        if (strcmp(entry->name, "Dart_PostCObject") == 0)
+        {
+            m_post_cobject = (PostCObjectFunction)entry->function;
+            return true;
+        }
+    }
+
+    set_last_error("Dart_PostCObject is not in the Dart API DL table");
+    return false;
+}
+
+bool DartPortPoster::Post(int64_t port, const CompactProcessEvent *events, size_t count) const
+{
+    if (m_post_cobject == nullptr || count == 0)
+        return false;
+
+    DartCObject message = {};
+    message.type = kDartCObjectTypedData;
+    message.value.as_typed_data.type = kDartTypedDataUint8;
+    message.value.as_typed_data.length = (intptr_t)(count * sizeof(CompactProcessEvent));
+    message.value.as_typed_data.values = (const uint8_t *)events;
+    return m_post_cobject(port, &message);
+}
@@ -0,0 +1,59 @@
+#ifndef DART_PORT_H_
+#define DART_PORT_H_
+
+#include "process_monitor_api.h"
+
+#include <cstddef>
+#include <cstdint>
+
+// Posts event batches to a Dart ReceivePort from native threads through Dart_PostCObject.
+//
+// Dart_PostCObject is resolved by name from the table Dart passes in as
+// NativeApi.initializeApiDLData, so the library needs neither the Dart SDK headers nor
+// dart_api_dl.c at build time. The structures below mirror the parts of
+// dart_api_dl.h / dart_native_api.h that are used, for API DL major version 2.
+class DartPortPoster
+{
+public:
+    // Resolves Dart_PostCObject from `api_dl_data`. Returns false (after set_last_error) if the
+    // table is missing, from an incompatible Dart version, or lacks the function.
+    bool Initialize(void *api_dl_data);
+
+    bool IsInitialized() const { return m_post_cobject != nullptr; }
+
+    // Posts `count` records as one Uint8List message; Dart copies it before this returns.
+    // Safe to call from any thread.
+    bool Post(int64_t port, const CompactProcessEvent *events, size_t count) const;
+
+private:
+    // Layout of Dart_CObject, enough for a typed data message
+    enum DartCObjectType : int32_t
+    {
+        kDartCObjectTypedData = 7,
+    };
+
+    enum DartTypedDataType : int32_t
+    {
+        kDartTypedDataUint8 = 2,
+    };
+
+    struct DartCObject
+    {
+        DartCObjectType type;
+        union
+        {
+            struct
+            {
+                DartTypedDataType type;
+                intptr_t length;
+                const uint8_t *values;
+            } as_typed_data;
+            int64_t padding[5]; // Largest member of the real union
+        } value;
+    };
+
+    typedef bool (*PostCObjectFunction)(int64_t port, DartCObject *message);
+    PostCObjectFunction m_post_cobject = nullptr;
+};
+
+#endif // DART_PORT_H_
@@ -0,0 +1,108 @@
+#include "event_batcher.h"
+#include "pipeline_stats.h"
+
+#include <algorithm>
+
+EventBatcher::EventBatcher(ProcessEventBatchCallback callback, void *user_data, size_t max_events, int max_delay_us)
+    : m_callback(callback), m_user_data(user_data), m_max_events(max_events), m_max_delay(max_delay_us)
+{
+    m_pending.reserve(max_events);
+}
+
+EventBatcher::~EventBatcher()
+{
+    Stop();
+}
+
+bool EventBatcher::Start()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_running)
+        return true;
+
+    try
+    {
+        m_running = true;
+        m_thread = std::thread(&EventBatcher::ThreadMain, this);
+    }
+    catch (...)
+    {
+        m_running = false;
+        return false;
+    }
+    return true;
+}
+
+void EventBatcher::Stop()
+{
+    RequestStop();
+    if (m_thread.joinable())
+        m_thread.join();
+}
+
+void EventBatcher::RequestStop()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_running = false;
+    }
+    m_cond.notify_one();
+}
+
+void EventBatcher::Add(const CompactProcessEvent *events, size_t count)
+{
+    bool wake;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_pending.empty())
+            m_oldest = std::chrono::steady_clock::now();
+        m_pending.insert(m_pending.end(), events, events + count);
+
+        // The thread sleeps until the first event arrives, then until the batch fills or ages out
+        wake = m_pending.size() == count || m_pending.size() >= m_max_events;
+    }
+    if (wake)
+        m_cond.notify_one();
+}
+
+void EventBatcher::ThreadMain()
+{
+    std::vector<CompactProcessEvent> batch;
+    batch.reserve(m_max_events);
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true)
+    {
+        m_cond.wait(lock, [this] { return !m_running || !m_pending.empty(); });
+        if (m_pending.empty())
+            break;
+
+        m_cond.wait_until(lock, m_oldest + m_max_delay, [this] { return !m_running || m_pending.size() >= m_max_events; });
+
+        // Deliver outside the lock so producers never wait on the callback
+        batch.swap(m_pending);
+        lock.unlock();
+        Deliver(batch);
+        batch.clear();
+        lock.lock();
+    }
+}
+
+void EventBatcher::Deliver(const std::vector<CompactProcessEvent> &events)
+{
+    for (size_t first = 0; first < events.size(); first += m_max_events)
+    {
+        size_t count = std::min(m_max_events, events.size() - first);
+        try
+        {
+            m_callback(events.data() + first, (int)count, m_user_data);
+        }
+        catch (...)
+        {
+            // Ignore callback errors to prevent crashes
+        }
+
+        // Counted once the callback has them, not when they join the batch
+        pipeline_stats().Add(PipelineCounter::kDelivered, (uint64_t)count);
+    }
+}
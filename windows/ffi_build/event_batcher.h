@@ -0,0 +1,55 @@
+#ifndef EVENT_BATCHER_H_
+#define EVENT_BATCHER_H_
+
+#include "process_monitor_api.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Gathers events and hands them to a batch callback from its own thread, either when
+// `max_events` are waiting or when the oldest waiting event is `max_delay_us` old.
+//
+// Producers only append under a mutex and wake the thread for the first event of a batch
+// and for a full batch, so the ingest thread never runs the callback and a storm costs one
+// callback per batch instead of one per event.
+class EventBatcher
+{
+public:
+    EventBatcher(ProcessEventBatchCallback callback, void *user_data, size_t max_events, int max_delay_us);
+    ~EventBatcher();
+
+    EventBatcher(const EventBatcher &) = delete;
+    EventBatcher &operator=(const EventBatcher &) = delete;
+
+    bool Start();
+
+    // Delivers whatever is still waiting, then stops the thread
+    void Stop();
+
+    // Like Stop() but returns without waiting for the thread to finish
+    void RequestStop();
+
+    void Add(const CompactProcessEvent *events, size_t count);
+
+private:
+    ProcessEventBatchCallback m_callback;
+    void *m_user_data;
+    size_t m_max_events;
+    std::chrono::microseconds m_max_delay;
+
+    std::mutex m_mutex;
+    std::condition_variable m_cond;
+    std::vector<CompactProcessEvent> m_pending;
+    std::chrono::steady_clock::time_point m_oldest; // Arrival of m_pending[0]
+    bool m_running = false;
+    std::thread m_thread;
+
+    void ThreadMain();
+    void Deliver(const std::vector<CompactProcessEvent> &events);
+};
+
+#endif // EVENT_BATCHER_H_
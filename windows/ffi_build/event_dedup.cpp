@@ -0,0 +1,103 @@
+#include "event_dedup.h"
+#include "process_key.h"
+
+// 64-bit mix (from MurmurHash3's finalizer) over the key fields
+static uint64_t hash_event(const CompactProcessEvent &event)
+{
+    uint64_t hash = process_key(event) * 0x9E3779B97F4A7C15ULL;
+    hash ^= event.name_id ^ ((uint64_t)event.event_type << 56);
+    hash ^= hash >> 33;
+    hash *= 0xFF51AFD7ED558CCDULL;
+    hash ^= hash >> 33;
+    hash *= 0xC4CEB9FE1A85EC53ULL;
+    hash ^= hash >> 33;
+    return hash;
+}
+
+EventDeduplicator::EventDeduplicator(size_t capacity)
+{
+    size_t rounded = kMaxProbes;
+    while (rounded < capacity)
+        rounded <<= 1;
+
+    m_entries.resize(rounded);
+    m_mask = rounded - 1;
+}
+
+bool EventDeduplicator::IsDuplicate(const CompactProcessEvent &event, long long now_ms)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_window_ms <= 0)
+        return false;
+
+    m_checked++;
+    uint64_t hash = hash_event(event);
+
+    Entry *free_slot = nullptr;
+    Entry *oldest = nullptr;
+    for (size_t probe = 0; probe < kMaxProbes; probe++)
+    {
+        Entry &entry = m_entries[(hash + probe) & m_mask];
+        bool expired = entry.type == 0 || now_ms - entry.seen_ms >= m_window_ms;
+
+        if (!expired && entry.hash == hash && entry.type == event.event_type && entry.key == process_key(event) && entry.name_id == event.name_id)
+        {
+            m_duplicates++;
+            return true;
+        }
+
+        if (expired)
+        {
+            if (free_slot == nullptr)
+                free_slot = &entry;
+        }
+        else if (oldest == nullptr || entry.seen_ms < oldest->seen_ms)
+        {
+            oldest = &entry;
+        }
+    }
+
+    Entry *slot = free_slot;
+    if (slot == nullptr)
+    {
+        slot = oldest;
+        m_evicted++;
+    }
+
+    slot->hash = hash;
+    slot->key = process_key(event);
+    slot->seen_ms = now_ms;
+    slot->name_id = event.name_id;
+    slot->type = event.event_type;
+    return false;
+}
+
+void EventDeduplicator::SetWindow(int window_ms)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_window_ms = window_ms;
+}
+
+int EventDeduplicator::Window() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_window_ms;
+}
+
+uint64_t EventDeduplicator::CheckedCount() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_checked;
+}
+
+uint64_t EventDeduplicator::DuplicateCount() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_duplicates;
+}
+
+uint64_t EventDeduplicator::EvictedCount() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_evicted;
+}
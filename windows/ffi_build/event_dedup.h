@@ -0,0 +1,57 @@
+#ifndef EVENT_DEDUP_H_
+#define EVENT_DEDUP_H_
+
+#include "process_monitor_api.h"
+
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+// Suppresses repeats of an event within a time window, keyed on (type, process key, name). The
+// process key (PID and start time) keeps a reused PID from being taken for a repeat, and the name
+// keeps a second exec by the same process from being dropped.
+//
+// Entries live in a fixed-size open-addressed table. An entry older than the window counts as free,
+// so expiry costs nothing, and when a probe run has no free slot the oldest entry in it is replaced.
+// Called from the ingest thread and the exit watcher thread.
+class EventDeduplicator
+{
+public:
+    explicit EventDeduplicator(size_t capacity = 4096);
+
+    // Returns true if `event` repeats one seen within the window; records it otherwise.
+    // `now_ms` is a monotonic clock reading.
+    bool IsDuplicate(const CompactProcessEvent &event, long long now_ms);
+
+    // 0 disables deduplication. Existing entries are kept.
+    void SetWindow(int window_ms);
+    int Window() const;
+
+    uint64_t CheckedCount() const;
+    uint64_t DuplicateCount() const;
+    uint64_t EvictedCount() const; // Live entries replaced because their probe run was full
+
+private:
+    // Slots probed per lookup before the oldest one is replaced
+    static constexpr size_t kMaxProbes = 8;
+
+    struct Entry
+    {
+        uint64_t hash = 0;
+        ProcessKey key = 0;
+        long long seen_ms = 0;
+        uint32_t name_id = 0;
+        uint8_t type = 0; // 0 marks a never-used slot
+    };
+
+    mutable std::mutex m_mutex;
+    std::vector<Entry> m_entries;
+    size_t m_mask;
+    int m_window_ms = 1000;
+
+    uint64_t m_checked = 0;
+    uint64_t m_duplicates = 0;
+    uint64_t m_evicted = 0;
+};
+
+#endif // EVENT_DEDUP_H_
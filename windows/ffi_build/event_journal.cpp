@@ -0,0 +1,413 @@
+#include "event_journal.h"
+#include "event_source.h"
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <system_error>
+
+static constexpr size_t kHeaderSize = sizeof(JournalSegmentHeader);
+
+static std::string segment_path(const std::string &directory, uint64_t first_sequence)
+{
+    char name[64];
+    snprintf(name, sizeof(name), "journal-%020" PRIu64 ".pmj", first_sequence);
+    return (std::filesystem::u8path(directory) / name).u8string();
+}
+
+static size_t padded_size(size_t size)
+{
+    return (size + 7) & ~(size_t)7;
+}
+
+std::vector<JournalSegmentFile> list_journal_segments(const std::string &directory)
+{
+    std::vector<JournalSegmentFile> segments;
+    std::error_code error;
+    for (const auto &entry : std::filesystem::directory_iterator(std::filesystem::u8path(directory), error))
+    {
+        std::string name = entry.path().filename().u8string();
+        unsigned long long first_sequence = 0;
+        int length = 0;
+        if (name.size() == 32 && sscanf(name.c_str(), "journal-%20llu.pmj%n", &first_sequence, &length) == 1 && length == 32)
+            segments.push_back({(uint64_t)first_sequence, entry.path().u8string()});
+    }
+
+    std::sort(segments.begin(), segments.end(), [](const JournalSegmentFile &a, const JournalSegmentFile &b) {
+        return a.first_sequence < b.first_sequence;
+    });
+    return segments;
+}
+
+// Maps a segment and checks its header; false for anything that isn't a segment of this format
+static bool open_segment(MappedFile *file, const std::string &path)
+{
+    if (!file->OpenReadOnly(path))
+        return false;
+
+    const JournalSegmentHeader *header = static_cast<const JournalSegmentHeader *>(file->Data());
+    if (file->Size() < kHeaderSize || header->magic != kJournalMagic || header->version != kJournalVersion ||
+        header->header_size != kHeaderSize || header->committed_bytes.load(std::memory_order_acquire) > file->Size() - kHeaderSize)
+    {
+        file->Close();
+        return false;
+    }
+    return true;
+}
+
+JournalWriter::JournalWriter(const std::string &directory, size_t segment_size, int max_segments)
+    : m_directory(directory), m_segment_size(segment_size), m_max_segments(max_segments > 0 ? max_segments : 0)
+{
+}
+
+bool JournalWriter::Open()
+{
+    std::error_code error;
+    std::filesystem::create_directories(std::filesystem::u8path(m_directory), error);
+    if (error)
+    {
+        set_last_error("Failed to create journal directory " + m_directory + ": " + error.message());
+        return false;
+    }
+
+    // Carry on from the newest segment a previous writer left
+    m_segments = list_journal_segments(m_directory);
+    if (!m_segments.empty())
+    {
+        MappedFile last;
+        if (open_segment(&last, m_segments.back().path))
+            m_next_sequence = static_cast<const JournalSegmentHeader *>(last.Data())->next_sequence.load(std::memory_order_acquire);
+        else
+            m_next_sequence = m_segments.back().first_sequence;
+    }
+    return StartSegment();
+}
+
+bool JournalWriter::StartSegment()
+{
+    JournalSegmentFile segment = {m_next_sequence, segment_path(m_directory, m_next_sequence)};
+    if (!m_file.Create(segment.path, m_segment_size))
+    {
+        set_last_error("Failed to create journal segment: " + m_file.Error());
+        return false;
+    }
+
+    JournalSegmentHeader *header = Header();
+    header->magic = kJournalMagic;
+    header->version = kJournalVersion;
+    header->header_size = (uint32_t)kHeaderSize;
+    header->first_sequence = m_next_sequence;
+    header->created_ms = event_timestamp_ms();
+    header->next_sequence.store(m_next_sequence, std::memory_order_release);
+
+    m_used = 0;
+    m_published = 0;
+    m_synced = 0;
+    m_named.clear();
+    m_segments_created.fetch_add(1, std::memory_order_relaxed);
+
+    // An empty segment left at this sequence by an earlier writer has just been recreated
+    if (m_segments.empty() || m_segments.back().first_sequence != segment.first_sequence)
+        m_segments.push_back(segment);
+    RemoveOldSegments();
+    return true;
+}
+
+void JournalWriter::FinishSegment()
+{
+    Publish();
+    Sync();
+    m_file.Close(kHeaderSize + m_used);
+}
+
+void JournalWriter::RemoveOldSegments()
+{
+    // Removal fails on Windows while a reader has the segment open; the next rotation tries again
+    while (m_max_segments > 0 && m_segments.size() > (size_t)m_max_segments)
+    {
+        std::error_code error;
+        if (!std::filesystem::remove(std::filesystem::u8path(m_segments.front().path), error) && error)
+            break;
+        m_segments.erase(m_segments.begin());
+    }
+}
+
+size_t JournalWriter::NameEntrySize(uint32_t name_id, const char **name, size_t *length) const
+{
+    *name = nullptr;
+    if (name_id == 0 || (name_id < m_named.size() && m_named[name_id]))
+        return 0;
+
+    *name = lookup_process_name(name_id);
+    if (*name == nullptr)
+        return 0;
+    *length = std::min(strlen(*name), kMaxNameLength);
+    return padded_size(sizeof(JournalNameEntry) + *length);
+}
+
+bool JournalWriter::Append(const CompactProcessEvent &event)
+{
+    if (m_file.Data() == nullptr && !StartSegment())
+    {
+        Skip(1);
+        return false;
+    }
+
+    // A name entry goes in ahead of the first event in the segment that uses the name
+    const char *name;
+    size_t name_length = 0;
+    size_t name_entry_size = NameEntrySize(event.name_id, &name, &name_length);
+    if (kHeaderSize + m_used + name_entry_size + sizeof(JournalEventEntry) > m_file.Size())
+    {
+        FinishSegment();
+        if (!StartSegment())
+        {
+            Skip(1);
+            return false;
+        }
+        name_entry_size = NameEntrySize(event.name_id, &name, &name_length);
+    }
+
+    JournalSegmentHeader *header = Header();
+    if (m_used == 0)
+        header->first_timestamp_ms = event.timestamp_ms;
+
+    char *base = static_cast<char *>(m_file.Data()) + kHeaderSize;
+    if (name != nullptr)
+    {
+        JournalNameEntry *entry = reinterpret_cast<JournalNameEntry *>(base + m_used);
+        entry->header.kind = kJournalEntryName;
+        entry->header.size = (uint32_t)name_entry_size;
+        entry->name_id = event.name_id;
+        entry->length = (uint32_t)name_length;
+        memcpy(entry + 1, name, name_length); // The padding is still zero from the fresh file
+        m_used += name_entry_size;
+
+        if (event.name_id >= m_named.size())
+            m_named.resize((size_t)event.name_id + 1);
+        m_named[event.name_id] = true;
+    }
+
+    JournalEventEntry *entry = reinterpret_cast<JournalEventEntry *>(base + m_used);
+    entry->header.kind = kJournalEntryEvent;
+    entry->header.size = (uint32_t)sizeof(JournalEventEntry);
+    entry->sequence = m_next_sequence++;
+    entry->event = event;
+    m_used += sizeof(JournalEventEntry);
+
+    m_events_written.fetch_add(1, std::memory_order_relaxed);
+    m_bytes_written.fetch_add(name_entry_size + sizeof(JournalEventEntry), std::memory_order_relaxed);
+    return true;
+}
+
+void JournalWriter::Skip(uint64_t count)
+{
+    m_next_sequence += count;
+    m_events_lost.fetch_add(count, std::memory_order_relaxed);
+}
+
+void JournalWriter::Publish()
+{
+    if (m_file.Data() == nullptr)
+        return;
+
+    // Readers load committed_bytes with acquire, so the entries below it are complete for them
+    Header()->next_sequence.store(m_next_sequence, std::memory_order_release);
+    if (m_used != m_published)
+        Header()->committed_bytes.store(m_used, std::memory_order_release);
+    m_published = m_used;
+}
+
+bool JournalWriter::Sync()
+{
+    if (m_file.Data() == nullptr || m_synced == m_published)
+        return true;
+
+    // The header goes too, for committed_bytes; usually it shares a page with the new entries
+    bool ok = m_file.Flush(0, kHeaderSize) && m_file.Flush(kHeaderSize + m_synced, m_published - m_synced);
+    if (!ok)
+    {
+        set_last_error("Failed to flush journal segment: " + m_file.Error());
+        return false;
+    }
+    m_synced = m_published;
+    m_commits.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+void JournalWriter::Close()
+{
+    if (m_file.Data() != nullptr)
+        FinishSegment();
+}
+
+void JournalWriter::GetStats(JournalStats *stats) const
+{
+    stats->events_written = (long long)m_events_written.load(std::memory_order_relaxed);
+    stats->events_lost = (long long)m_events_lost.load(std::memory_order_relaxed);
+    stats->bytes_written = (long long)m_bytes_written.load(std::memory_order_relaxed);
+    stats->segments_created = (long long)m_segments_created.load(std::memory_order_relaxed);
+    stats->commits = (long long)m_commits.load(std::memory_order_relaxed);
+}
+
+JournalReader::JournalReader(const std::string &directory)
+    : m_directory(directory)
+{
+}
+
+bool JournalReader::Open()
+{
+    m_segments = list_journal_segments(m_directory);
+    if (m_segments.empty())
+    {
+        set_last_error("No journal segments in " + m_directory);
+        return false;
+    }
+    return Seek(0);
+}
+
+bool JournalReader::Seek(size_t segment_index)
+{
+    m_segment_index = segment_index;
+    m_file.Close();
+    return MapSegment();
+}
+
+bool JournalReader::MapSegment()
+{
+    // Segments that can't be read (deleted by retention, or not a journal) are passed over
+    m_segment_names.clear();
+    while (m_segment_index < m_segments.size())
+    {
+        if (open_segment(&m_file, m_segments[m_segment_index].path))
+        {
+            m_current_sequence = m_segments[m_segment_index].first_sequence;
+            m_offset = kHeaderSize;
+            return true;
+        }
+        m_segment_index++;
+    }
+    set_last_error("No readable journal segments in " + m_directory);
+    return false;
+}
+
+bool JournalReader::NextSegment()
+{
+    auto after_current = [this]() {
+        return std::upper_bound(m_segments.begin(), m_segments.end(), m_current_sequence, [](uint64_t sequence, const JournalSegmentFile &segment) {
+            return sequence < segment.first_sequence;
+        });
+    };
+
+    // A segment the writer started since the directory was listed only shows up in a new listing
+    auto next = after_current();
+    if (next == m_segments.end())
+    {
+        m_segments = list_journal_segments(m_directory);
+        next = after_current();
+    }
+    if (next == m_segments.end())
+        return false;
+
+    m_segment_index = (size_t)(next - m_segments.begin());
+    m_file.Close();
+    return true;
+}
+
+bool JournalReader::SeekSequence(uint64_t sequence)
+{
+    m_segments = list_journal_segments(m_directory);
+    if (m_segments.empty())
+    {
+        set_last_error("No journal segments in " + m_directory);
+        return false;
+    }
+
+    // The newest segment starting at or before the sequence holds it, if any does
+    size_t index = 0;
+    while (index + 1 < m_segments.size() && m_segments[index + 1].first_sequence <= sequence)
+        index++;
+
+    m_min_sequence = sequence;
+    m_has_min_time = false;
+    return Seek(index);
+}
+
+bool JournalReader::SeekTime(long long timestamp_ms)
+{
+    m_segments = list_journal_segments(m_directory);
+    if (m_segments.empty())
+    {
+        set_last_error("No journal segments in " + m_directory);
+        return false;
+    }
+
+    // Start from the newest segment whose first event is no later than the time
+    size_t index = 0;
+    for (size_t i = 0; i < m_segments.size(); i++)
+    {
+        MappedFile file;
+        if (!open_segment(&file, m_segments[i].path))
+            continue;
+        const JournalSegmentHeader *header = static_cast<const JournalSegmentHeader *>(file.Data());
+        if (header->committed_bytes.load(std::memory_order_acquire) == 0 || header->first_timestamp_ms > timestamp_ms)
+            break;
+        index = i;
+    }
+
+    m_min_sequence = 0;
+    m_has_min_time = true;
+    m_min_time_ms = timestamp_ms;
+    return Seek(index);
+}
+
+size_t JournalReader::Read(JournalEvent *events, size_t max_events)
+{
+    size_t count = 0;
+    while (count < max_events)
+    {
+        if (m_file.Data() == nullptr)
+        {
+            if (!MapSegment())
+                break;
+        }
+
+        const char *base = static_cast<const char *>(m_file.Data());
+        const JournalSegmentHeader *header = reinterpret_cast<const JournalSegmentHeader *>(base);
+        size_t end = kHeaderSize + (size_t)header->committed_bytes.load(std::memory_order_acquire);
+
+        const JournalEntryHeader *entry = reinterpret_cast<const JournalEntryHeader *>(base + m_offset);
+        if (m_offset + sizeof(JournalEntryHeader) > end || entry->size < sizeof(JournalEntryHeader) || m_offset + entry->size > end)
+        {
+            // At the end of what's committed. A later segment means this one is finished (a damaged
+            // entry ends it early); otherwise the writer may still add to it.
+            if (!NextSegment())
+                break;
+            continue;
+        }
+        m_offset += entry->size;
+
+        if (entry->kind == kJournalEntryName && entry->size >= sizeof(JournalNameEntry))
+        {
+            const JournalNameEntry *name = reinterpret_cast<const JournalNameEntry *>(entry);
+            if (sizeof(JournalNameEntry) + name->length <= entry->size)
+                m_segment_names[name->name_id] = m_names.Intern(reinterpret_cast<const char *>(name + 1), name->length);
+        }
+        else if (entry->kind == kJournalEntryEvent && entry->size >= sizeof(JournalEventEntry))
+        {
+            const JournalEventEntry *event = reinterpret_cast<const JournalEventEntry *>(entry);
+            if (event->sequence < m_min_sequence || (m_has_min_time && event->event.timestamp_ms < m_min_time_ms))
+                continue;
+            m_has_min_time = false;
+
+            JournalEvent &out = events[count++];
+            out.sequence = (long long)event->sequence;
+            out.event = event->event;
+            auto name = m_segment_names.find(event->event.name_id);
+            out.event.name_id = name != m_segment_names.end() ? name->second : 0;
+        }
+    }
+    return count;
+}
@@ -0,0 +1,183 @@
+#ifndef EVENT_JOURNAL_H_
+#define EVENT_JOURNAL_H_
+
+#include "mapped_file.h"
+#include "name_table.h"
+#include "process_monitor_api.h"
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// On-disk format of the event journal. A journal is a directory of segment files named
+// journal-<first sequence, 20 digits>.pmj, each a JournalSegmentHeader followed by entries.
+// Every entry starts with a JournalEntryHeader and is a multiple of 8 bytes long. Segments are
+// self-contained: a name entry precedes the first event in the segment that uses the name, and
+// name IDs mean nothing outside their segment.
+static constexpr uint32_t kJournalMagic = 0x4A4D5050; // "PPMJ"
+static constexpr uint32_t kJournalVersion = 1;
+
+struct JournalSegmentHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t header_size;
+    uint32_t reserved;
+    uint64_t first_sequence;
+    int64_t created_ms;
+    int64_t first_timestamp_ms;              // timestamp_ms of the first event (valid once committed_bytes > 0)
+    std::atomic<uint64_t> committed_bytes;   // Entry bytes after the header that are complete
+    std::atomic<uint64_t> next_sequence;     // Sequence the next event will get
+    uint8_t padding[8];
+};
+static_assert(sizeof(JournalSegmentHeader) == 64, "JournalSegmentHeader must stay 64 bytes");
+
+enum JournalEntryKind : uint32_t
+{
+    kJournalEntryEvent = 1, // JournalEventEntry
+    kJournalEntryName = 2,  // JournalNameEntry followed by the UTF-8 name, zero-padded
+};
+
+struct JournalEntryHeader
+{
+    uint32_t kind;
+    uint32_t size; // Including this header and any padding
+};
+
+struct JournalEventEntry
+{
+    JournalEntryHeader header;
+    uint64_t sequence;
+    CompactProcessEvent event;
+};
+static_assert(sizeof(JournalEventEntry) == 48, "JournalEventEntry must stay 48 bytes");
+
+struct JournalNameEntry
+{
+    JournalEntryHeader header;
+    uint32_t name_id;
+    uint32_t length;
+};
+
+struct JournalSegmentFile
+{
+    uint64_t first_sequence;
+    std::string path;
+};
+
+// Segments in `directory`, oldest first
+std::vector<JournalSegmentFile> list_journal_segments(const std::string &directory);
+
+// Appends events to the segments of one journal directory. Entries are written straight into
+// the mapped segment, become visible to readers on Publish() and durable on Sync(), so a caller
+// can publish every batch and sync once per commit interval. Segments are rotated when full
+// and the oldest are deleted beyond max_segments. Used by one thread; the counters may be read
+// from any. Failures are reported through set_last_error.
+class JournalWriter
+{
+public:
+    // `max_segments` of 0 keeps every segment
+    JournalWriter(const std::string &directory, size_t segment_size, int max_segments);
+    ~JournalWriter() { Close(); }
+
+    JournalWriter(const JournalWriter &) = delete;
+    JournalWriter &operator=(const JournalWriter &) = delete;
+
+    // Creates the directory if needed and starts a new segment, continuing the sequence
+    // numbers of any journal already there
+    bool Open();
+
+    // Writes one event, rotating to a new segment first if it doesn't fit. False if no segment
+    // could be created, in which case the event is counted as lost.
+    bool Append(const CompactProcessEvent &event);
+
+    // Skips the sequence numbers of events that never reached the journal
+    void Skip(uint64_t count);
+
+    // Makes everything appended so far visible to readers
+    void Publish();
+
+    // Flushes everything published to disk, waiting for it
+    bool Sync();
+
+    // Publishes, syncs and closes the current segment, trimming it to its used size
+    void Close();
+
+    void GetStats(JournalStats *stats) const;
+
+private:
+    static constexpr size_t kMaxNameLength = 4096;
+
+    // Bytes of the name entry `name_id` needs in the current segment (0 if it has one or the name is unknown)
+    size_t NameEntrySize(uint32_t name_id, const char **name, size_t *length) const;
+    bool StartSegment();
+    void FinishSegment();
+    void RemoveOldSegments();
+    JournalSegmentHeader *Header() const { return static_cast<JournalSegmentHeader *>(m_file.Data()); }
+
+    std::string m_directory;
+    size_t m_segment_size;
+    int m_max_segments;
+
+    std::vector<JournalSegmentFile> m_segments;
+    MappedFile m_file;
+    size_t m_used = 0;      // Entry bytes written to the current segment
+    size_t m_published = 0; // Of which readers can see
+    size_t m_synced = 0;    // Of which are on disk
+    uint64_t m_next_sequence = 0;
+    std::vector<bool> m_named; // Name IDs that have a name entry in the current segment
+
+    std::atomic<uint64_t> m_events_written{0};
+    std::atomic<uint64_t> m_events_lost{0};
+    std::atomic<uint64_t> m_bytes_written{0};
+    std::atomic<uint64_t> m_segments_created{0};
+    std::atomic<uint64_t> m_commits{0};
+};
+
+// Reads a journal directory from a chosen position onwards. Names are interned into a table of
+// the reader's own, so name IDs returned by Read() stay valid for the reader's lifetime whichever
+// segment or writer session the events came from. Reading past the end returns nothing until
+// the writer publishes more, so a reader can follow a live journal. Used by one thread.
+class JournalReader
+{
+public:
+    explicit JournalReader(const std::string &directory);
+
+    // Lists the segments and positions the reader at the oldest event; fails without any
+    bool Open();
+
+    // Positions the reader at the first event with a sequence at or after `sequence`
+    bool SeekSequence(uint64_t sequence);
+
+    // Positions the reader at the first event, in journal order, with a timestamp at or after `timestamp_ms`
+    bool SeekTime(long long timestamp_ms);
+
+    // Reads up to `max_events` events from the current position
+    size_t Read(JournalEvent *events, size_t max_events);
+
+    const char *Name(uint32_t name_id) const { return m_names.Lookup(name_id); }
+
+private:
+    bool Seek(size_t segment_index);
+    bool MapSegment();
+    bool NextSegment();
+
+    std::string m_directory;
+    std::vector<JournalSegmentFile> m_segments;
+    size_t m_segment_index = 0;
+    uint64_t m_current_sequence = 0; // First sequence of the mapped segment
+    MappedFile m_file;
+    size_t m_offset = 0; // Of the next entry, from the start of the segment
+
+    // Events before these are skipped; the time bound is dropped at the first event it lets through
+    uint64_t m_min_sequence = 0;
+    bool m_has_min_time = false;
+    long long m_min_time_ms = 0;
+
+    NameTable m_names;
+    std::unordered_map<uint32_t, uint32_t> m_segment_names; // Current segment's name IDs -> m_names IDs
+};
+
+#endif // EVENT_JOURNAL_H_
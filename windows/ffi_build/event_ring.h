@@ -0,0 +1,303 @@
+#ifndef EVENT_RING_H_
+#define EVENT_RING_H_
+
+#include "shared_memory.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+
+// Size of a cache line; cells and indices are padded to it so producers and the
+// consumer don't invalidate each other's lines
+static constexpr size_t kCacheLineSize = 64;
+
+// What a producer does when the ring is full
+enum class RingOverflowPolicy
+{
+    kOverwriteOldest, // Discard the oldest queued item to make room (counted as overwritten)
+    kDropNewest,      // Discard the item being pushed (counted as dropped)
+};
+
+// Control block at the start of the ring memory. Its layout is published to in-place
+// readers as ProcessEventRingHeader, so fields may only be appended.
+struct RingControl
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t capacity;
+    uint32_t slot_size;
+    uint32_t slots_offset;
+    uint32_t record_offset;
+    uint32_t record_size;
+    uint32_t record_format;
+    uint8_t reserved[32];
+    alignas(kCacheLineSize) std::atomic<uint64_t> tail; // Next position to write
+    alignas(kCacheLineSize) std::atomic<uint64_t> head; // Next position to read
+};
+
+static constexpr uint32_t kRingMagic = 0x47524D50; // "PMRG"
+static constexpr uint32_t kRingVersion = 1;
+
+// Bounded lock-free queue for many producers (the event source threads) and a consumer
+// (the C API drain calls). Based on Dmitry Vyukov's bounded MPMC queue: every cell carries
+// a sequence number that says whether it is free for the producer of a given lap or
+// holds data for the consumer of that lap, so the only shared writes are one CAS per
+// push and per pop.
+//
+// Producers never wait for the consumer. A full ring is resolved by the overflow policy,
+// and an overwriting producer gives up and drops after one unsuccessful eviction, so a
+// push does a bounded amount of work even while a consumer is stalled mid-read.
+//
+// The ring lives in a SharedMemoryRegion whose read-only view can be handed to a consumer,
+// which then reads cells in place (Peek) and hands them back (Release) instead of copying.
+// Cell i holds data for position p when its sequence equals p + 1.
+//
+// Not resizable while in use; Reset() must only be called when no thread is pushing or popping.
+template <typename T>
+class EventRing
+{
+public:
+    // `record_format` is published in the control block so in-place readers know what T is
+    explicit EventRing(size_t capacity, RingOverflowPolicy policy = RingOverflowPolicy::kOverwriteOldest, uint32_t record_format = 0)
+        : m_record_format(record_format)
+    {
+        Reset(capacity, policy);
+    }
+
+    EventRing(const EventRing &) = delete;
+    EventRing &operator=(const EventRing &) = delete;
+
+    // Reallocates the ring with `capacity` rounded up to a power of two, discarding queued items
+    bool Reset(size_t capacity, RingOverflowPolicy policy)
+    {
+        size_t rounded = 2;
+        while (rounded < capacity)
+            rounded <<= 1;
+
+        size_t slots_offset = (sizeof(RingControl) + kCacheLineSize - 1) & ~(kCacheLineSize - 1);
+        if (!m_memory.Allocate(slots_offset + rounded * sizeof(Cell)))
+        {
+            m_control = nullptr;
+            m_cells = nullptr;
+            m_mask = 0;
+            return false;
+        }
+
+        uint8_t *base = (uint8_t *)m_memory.Writable();
+        m_control = new (base) RingControl();
+        m_control->magic = kRingMagic;
+        m_control->version = kRingVersion;
+        m_control->capacity = (uint32_t)rounded;
+        m_control->slot_size = (uint32_t)sizeof(Cell);
+        m_control->slots_offset = (uint32_t)slots_offset;
+        m_control->record_offset = (uint32_t)offsetof(Cell, data);
+        m_control->record_size = (uint32_t)sizeof(T);
+        m_control->record_format = m_record_format;
+        m_control->tail.store(0, std::memory_order_relaxed);
+        m_control->head.store(0, std::memory_order_relaxed);
+
+        m_cells = (Cell *)(base + slots_offset);
+        for (size_t i = 0; i < rounded; i++)
+            new (&m_cells[i]) Cell{{i}, T()};
+
+        m_mask = rounded - 1;
+        m_policy.store(policy, std::memory_order_relaxed);
+        m_dropped.value.store(0, std::memory_order_relaxed);
+        m_overwritten.value.store(0, std::memory_order_relaxed);
+        m_high_water.value.store(0, std::memory_order_relaxed);
+        return true;
+    }
+
+    // Returns false if the item was dropped. `overwrote`, if given, tells whether the oldest
+    // item was discarded to make room.
+    bool Push(const T &item, bool *overwrote = nullptr)
+    {
+        bool evicted = false;
+        while (true)
+        {
+            Cell *cell = nullptr;
+            uint64_t position = m_control->tail.load(std::memory_order_relaxed);
+            if (TryClaim(&m_control->tail, position, 0, &cell, &position))
+            {
+                cell->data = item;
+                cell->sequence.store(position + 1, std::memory_order_release);
+                UpdateHighWater(position + 1);
+                return true;
+            }
+
+            if (m_policy.load(std::memory_order_relaxed) == RingOverflowPolicy::kOverwriteOldest && !evicted)
+            {
+                evicted = true;
+                if (Discard())
+                {
+                    m_overwritten.value.fetch_add(1, std::memory_order_relaxed);
+                    if (overwrote != nullptr)
+                        *overwrote = true;
+                    continue;
+                }
+            }
+
+            m_dropped.value.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+    }
+
+    // Returns false if the ring is empty
+    bool Pop(T *item)
+    {
+        Cell *cell = nullptr;
+        uint64_t position = m_control->head.load(std::memory_order_relaxed);
+        if (!TryClaim(&m_control->head, position, 1, &cell, &position))
+            return false;
+
+        *item = cell->data;
+        cell->sequence.store(position + m_mask + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Pops up to `max_items`, returns how many were popped
+    size_t PopBatch(T *items, size_t max_items)
+    {
+        size_t count = 0;
+        while (count < max_items && Pop(&items[count]))
+            count++;
+        return count;
+    }
+
+    // In-place read: returns how many consecutive items starting at the head are ready
+    // (at most `max_items`) and stores the head position in `first`. The items stay
+    // owned by the ring until Release(). Only valid with a single consumer and the
+    // kDropNewest policy, otherwise a producer may recycle the cells being read.
+    size_t Peek(uint64_t *first, size_t max_items) const
+    {
+        uint64_t position = m_control->head.load(std::memory_order_acquire);
+        size_t count = 0;
+        while (count < max_items && count <= m_mask)
+        {
+            const Cell &cell = m_cells[(position + count) & m_mask];
+            if (cell.sequence.load(std::memory_order_acquire) != position + count + 1)
+                break;
+            count++;
+        }
+        *first = position;
+        return count;
+    }
+
+    // Hands back `count` items read in place, returns how many were actually released
+    size_t Release(size_t count)
+    {
+        size_t released = 0;
+        while (released < count && Discard())
+            released++;
+        return released;
+    }
+
+    void Clear()
+    {
+        while (Discard())
+        {
+        }
+    }
+
+    // Approximate while producers are active
+    size_t Size() const
+    {
+        uint64_t tail = m_control->tail.load(std::memory_order_acquire);
+        uint64_t head = m_control->head.load(std::memory_order_acquire);
+        return tail > head ? (size_t)(tail - head) : 0;
+    }
+
+    void SetOverflowPolicy(RingOverflowPolicy policy) { m_policy.store(policy, std::memory_order_relaxed); }
+    RingOverflowPolicy OverflowPolicy() const { return m_policy.load(std::memory_order_relaxed); }
+
+    size_t Capacity() const { return m_mask + 1; }
+    uint64_t DroppedCount() const { return m_dropped.value.load(std::memory_order_relaxed); }
+    uint64_t OverwrittenCount() const { return m_overwritten.value.load(std::memory_order_relaxed); }
+
+    // Largest number of items queued at once since Reset()
+    size_t HighWaterMark() const { return (size_t)m_high_water.value.load(std::memory_order_relaxed); }
+
+    // Control block, or nullptr if the last Reset() failed
+    const RingControl *Control() const { return m_control; }
+
+    // Read-only view of the whole ring (control block followed by the cells)
+    const void *ReadOnlyView() const { return m_memory.ReadOnly(); }
+
+private:
+    struct alignas(kCacheLineSize) Cell
+    {
+        std::atomic<uint64_t> sequence;
+        T data;
+    };
+
+    struct alignas(kCacheLineSize) PaddedCounter
+    {
+        std::atomic<uint64_t> value{0};
+    };
+
+    SharedMemoryRegion m_memory;
+    uint32_t m_record_format;
+    RingControl *m_control = nullptr;
+    Cell *m_cells = nullptr;
+    size_t m_mask = 0;
+    std::atomic<RingOverflowPolicy> m_policy{RingOverflowPolicy::kOverwriteOldest};
+
+    PaddedCounter m_dropped;
+    PaddedCounter m_overwritten;
+    PaddedCounter m_high_water;
+
+    // Claims the cell at `*index` for a producer (`lap_offset` 0) or consumer (`lap_offset` 1).
+    // Returns false if the cell is not ready, meaning the ring is full or empty respectively.
+    bool TryClaim(std::atomic<uint64_t> *index, uint64_t position, uint64_t lap_offset, Cell **cell, uint64_t *claimed)
+    {
+        while (true)
+        {
+            Cell *candidate = &m_cells[position & m_mask];
+            uint64_t sequence = candidate->sequence.load(std::memory_order_acquire);
+            int64_t difference = (int64_t)(sequence - (position + lap_offset));
+
+            if (difference == 0)
+            {
+                if (index->compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                {
+                    *cell = candidate;
+                    *claimed = position;
+                    return true;
+                }
+            }
+            else if (difference < 0)
+            {
+                return false;
+            }
+            else
+            {
+                position = index->load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Removes the oldest item without copying it out
+    bool Discard()
+    {
+        Cell *cell = nullptr;
+        uint64_t position = m_control->head.load(std::memory_order_relaxed);
+        if (!TryClaim(&m_control->head, position, 1, &cell, &position))
+            return false;
+
+        cell->sequence.store(position + m_mask + 1, std::memory_order_release);
+        return true;
+    }
+
+    void UpdateHighWater(uint64_t tail)
+    {
+        uint64_t head = m_control->head.load(std::memory_order_relaxed);
+        uint64_t depth = tail > head ? tail - head : 0;
+        uint64_t current = m_high_water.value.load(std::memory_order_relaxed);
+        while (depth > current && !m_high_water.value.compare_exchange_weak(current, depth, std::memory_order_relaxed))
+        {
+        }
+    }
+};
+
+#endif // EVENT_RING_H_
@@ -0,0 +1,132 @@
+#ifndef EVENT_SIGNAL_H_
+#define EVENT_SIGNAL_H_
+
+#ifdef _WIN32
+  #include <windows.h>
+#else
+  #include <atomic>
+  #include <cstdint>
+
+  #include <poll.h>
+  #include <sys/eventfd.h>
+  #include <unistd.h>
+#endif
+
+// Auto-reset wakeup used by wait_for_events, wait_and_drain and to stop event sources.
+// Set() wakes one waiter; the signal is consumed by the Wait() that observes it.
+// An idle waiter sleeps in the kernel (WaitForSingleObject / poll on an eventfd) with no periodic wakeups.
+class EventSignal
+{
+public:
+    EventSignal() = default;
+    ~EventSignal() { Close(); }
+
+    EventSignal(const EventSignal &) = delete;
+    EventSignal &operator=(const EventSignal &) = delete;
+
+#ifdef _WIN32
+    bool Create()
+    {
+        if (m_handle == nullptr)
+            m_handle = CreateEvent(nullptr, FALSE, FALSE, nullptr); // Auto-reset event
+        return m_handle != nullptr;
+    }
+
+    void Close()
+    {
+        if (m_handle != nullptr)
+        {
+            CloseHandle(m_handle);
+            m_handle = nullptr;
+        }
+    }
+
+    bool IsCreated() const { return m_handle != nullptr; }
+
+    void Set()
+    {
+        if (m_handle != nullptr)
+            SetEvent(m_handle);
+    }
+
+    // Returns 1 when signaled, 0 on timeout, -1 on error. A negative timeout waits forever.
+    int Wait(int timeout_ms)
+    {
+        DWORD result = WaitForSingleObject(m_handle, timeout_ms < 0 ? INFINITE : (DWORD)timeout_ms);
+        if (result == WAIT_OBJECT_0)
+            return 1;
+        if (result == WAIT_TIMEOUT)
+            return 0;
+        return -1;
+    }
+
+private:
+    HANDLE m_handle = nullptr;
+#else
+    bool Create()
+    {
+        int expected = -1;
+        int fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (fd < 0)
+            return false;
+        if (!m_fd.compare_exchange_strong(expected, fd))
+            close(fd);
+        return true;
+    }
+
+    void Close()
+    {
+        int fd = m_fd.exchange(-1);
+        if (fd >= 0)
+        {
+            // Release any waiter before the descriptor goes away
+            uint64_t one = 1;
+            (void)!write(fd, &one, sizeof(one));
+            close(fd);
+        }
+    }
+
+    bool IsCreated() const { return m_fd.load() >= 0; }
+
+    // The eventfd, readable while the signal is set, for waiting on it together with other descriptors.
+    // Consume the signal with Wait(0) once poll reports it.
+    int Descriptor() const { return m_fd.load(); }
+
+    void Set()
+    {
+        int fd = m_fd.load();
+        if (fd < 0)
+            return;
+        uint64_t one = 1;
+        (void)!write(fd, &one, sizeof(one));
+    }
+
+    // Returns 1 when signaled, 0 on timeout, -1 on error. A negative timeout waits forever.
+    int Wait(int timeout_ms)
+    {
+        int fd = m_fd.load();
+        if (fd < 0)
+            return -1;
+
+        pollfd wait_fd = {};
+        wait_fd.fd = fd;
+        wait_fd.events = POLLIN;
+        int ready = poll(&wait_fd, 1, timeout_ms < 0 ? -1 : timeout_ms);
+        if (ready < 0)
+            return -1;
+        if (ready == 0)
+            return 0;
+
+        // Consume the signal; another waiter may have taken it first
+        uint64_t count = 0;
+        if (read(fd, &count, sizeof(count)) != (ssize_t)sizeof(count))
+            return 0;
+        return 1;
+    }
+
+private:
+    std::atomic<int> m_fd{-1};
+#endif
+};
+
+#endif // EVENT_SIGNAL_H_
@@ -0,0 +1,93 @@
+#ifndef EVENT_SOURCE_H_
+#define EVENT_SOURCE_H_
+
+#include "event_signal.h"
+#include "process_monitor_api.h"
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+struct ProcessDetailsRecord;
+
+// Platform backend that produces process start/stop events.
+// The C API owns one source per monitoring session and drives it from the monitor thread.
+class EventSource
+{
+public:
+    virtual ~EventSource() = default;
+
+    // Subscribes to the platform's process notifications.
+    // Returns false (after calling set_last_error) if the subscription could not be made.
+    virtual bool Initialize() = 0;
+
+    // Delivers events through publish_process_event until `running` is cleared.
+    // `stop_signal` is set whenever `running` is cleared; an idle source sleeps on it instead of
+    // re-checking `running` on a timer. It can also be set while `running` is still true.
+    virtual void Run(const std::atomic<bool> &running, EventSignal &stop_signal) = 0;
+
+    // Forcefully releases the subscription when the monitor thread could not be joined.
+    virtual void Cleanup() = 0;
+
+    virtual ProcessEventSourceType Type() const = 0;
+};
+
+// Settings the C API passes to create_event_source
+struct EventSourceOptions
+{
+    ProcessEventSourceType type = PROCESS_EVENT_SOURCE_AUTO;
+    int proc_scan_interval_ms = 1000;
+    int synthetic_events_per_second = 1000;
+    long long synthetic_event_count = 0;     // 0 for no limit
+    std::string replay_trace_path;
+    double rate_multiplier = 1.0;            // Synthetic and replay sources; 0 for as fast as possible
+};
+
+// Creates and initializes the requested event source, falling back to the next best
+// backend for PROCESS_EVENT_SOURCE_AUTO. Returns nullptr (after set_last_error) on failure.
+// Implemented once per platform.
+EventSource *create_event_source(const EventSourceOptions &options);
+
+// Creates and initializes the synthetic or replay source, which every platform has.
+// Returns nullptr (after set_last_error) on failure or for any other source type.
+EventSource *create_paced_event_source(const EventSourceOptions &options);
+
+// Hooks implemented by process_monitor_api.cpp for use by event sources.
+// `kernel_time_ns` is when the platform reported the event, on the monotonic_time_ns clock (0 if unknown)
+void publish_process_event(const CompactProcessEvent &event, long long kernel_time_ns = 0);
+void flush_process_events(); // Ends a pass (e.g. one recv): hands what was published since the last call on as one batch
+void publish_process_fork(int pid, int parent_pid); // For the process tree, from sources that see forks before exec
+void publish_process_fork_exit(int pid, long long start_time_ms); // A fork from publish_process_fork exited without exec'ing
+void publish_proc_scan_stats(const ProcScanStats &stats);
+void record_process_details(int pid, long long start_time_ms, const ProcessDetailsRecord &details); // Fields captured anyway while the process ran
+std::string lookup_process_exe_path(int pid, long long start_time_ms); // Through the details cache; empty if unknown
+void set_last_error(const std::string &message);
+
+// Process name table shared by all sources (see NameTable); IDs go in CompactProcessEvent::name_id
+uint32_t intern_process_name(const std::string &name);
+uint32_t intern_process_name(const char *name, size_t length);
+#ifdef _WIN32
+uint32_t intern_process_name(const wchar_t *name, size_t length); // UTF-16, converted only on first sight
+#endif
+const char *lookup_process_name(uint32_t name_id);
+
+// Whether the backend's process table holds this process, i.e. consumers were told it is running
+bool is_known_process(int process_id, long long start_time_ms);
+
+// Copies the process table's entry for `process_id`; false if the table doesn't hold one
+bool find_known_process(int process_id, ProcessSnapshotEntry *process);
+
+// Whether `process_id` descends from `root_process_id` in the process tree kept while monitoring
+bool is_descendant_process(int process_id, int root_process_id);
+
+// Current time in milliseconds since the Unix epoch, for CompactProcessEvent::timestamp_ms
+long long event_timestamp_ms();
+
+// Current time on the monotonic clock of the TimedProcessEvent timestamps, in nanoseconds.
+// On Linux this is CLOCK_MONOTONIC, the clock of the proc connector's timestamps.
+long long monotonic_time_ns();
+
+// Converts a monotonic_time_ns reading to milliseconds since the Unix epoch
+long long monotonic_to_timestamp_ms(long long monotonic_ns);
+
+#endif // EVENT_SOURCE_H_
@@ -0,0 +1,120 @@
+#include "event_source.h"
+#include "netlink_event_source.h"
+#include "proc_scan_event_source.h"
+#include "process_details.h"
+#include "process_snapshot.h"
+#include "procfs.h"
+
+#include <string>
+
+#include <unistd.h>
+
+static EventSource *initialize_or_delete(EventSource *source)
+{
+    if (!source->Initialize())
+    {
+        delete source;
+        return nullptr;
+    }
+    return source;
+}
+
+EventSource *create_event_source(const EventSourceOptions &options)
+{
+    switch (options.type)
+    {
+    case PROCESS_EVENT_SOURCE_AUTO:
+    {
+        // Prefer the push-based proc connector, fall back to scanning without CAP_NET_ADMIN
+        EventSource *source = initialize_or_delete(new NetlinkEventSource());
+        if (source == nullptr)
+            source = initialize_or_delete(new ProcScanEventSource(options.proc_scan_interval_ms));
+        return source;
+    }
+    case PROCESS_EVENT_SOURCE_PROC_CONNECTOR:
+        return initialize_or_delete(new NetlinkEventSource());
+    case PROCESS_EVENT_SOURCE_PROC_SCAN:
+        return initialize_or_delete(new ProcScanEventSource(options.proc_scan_interval_ms));
+    case PROCESS_EVENT_SOURCE_SYNTHETIC:
+    case PROCESS_EVENT_SOURCE_REPLAY:
+        return create_paced_event_source(options);
+    default:
+        set_last_error("Event source " + std::to_string(options.type) + " is not available on Linux");
+        return nullptr;
+    }
+}
+
+bool query_process_details(int pid, long long start_time_ms, int fields, ProcessDetailsRecord *details)
+{
+    static int proc_fd = open_proc_dir();
+    if (proc_fd < 0)
+        return false;
+
+    // Everything is read through /proc/<pid>, so once the start time matches, the rest can't
+    // come from a process that reused the PID
+    int pid_dir_fd = open_proc_pid_dir(proc_fd, pid);
+    if (pid_dir_fd < 0)
+        return false;
+
+    ProcStat stat;
+    if (!read_proc_stat_at(pid_dir_fd, pid, &stat) || stat.state == 'Z' || (start_time_ms != 0 && proc_start_time_ms(stat.start_time) != start_time_ms))
+    {
+        close(pid_dir_fd);
+        return false;
+    }
+
+    details->fields = PROCESS_DETAIL_START_TIME;
+    details->start_time_ms = proc_start_time_ms(stat.start_time);
+    if (fields & PROCESS_DETAIL_EXE_PATH)
+    {
+        details->exe_path = read_process_exe_path_at(pid_dir_fd);
+        if (!details->exe_path.empty())
+            details->fields |= PROCESS_DETAIL_EXE_PATH;
+    }
+    if ((fields & PROCESS_DETAIL_COMMAND_LINE) && read_process_cmdline_at(pid_dir_fd, &details->command_line))
+        details->fields |= PROCESS_DETAIL_COMMAND_LINE;
+    if ((fields & PROCESS_DETAIL_USER_ID) && read_process_uid_at(pid_dir_fd, &details->user_id))
+        details->fields |= PROCESS_DETAIL_USER_ID;
+    close(pid_dir_fd);
+    return true;
+}
+
+bool list_running_processes(std::vector<RunningProcess> *processes)
+{
+    int proc_fd = open_proc_dir();
+    if (proc_fd < 0)
+    {
+        set_last_error("Failed to open /proc");
+        return false;
+    }
+
+    // One getdents64 pass for the PIDs, then one pass parsing each stat
+    std::vector<char> dirents;
+    std::vector<int> pids;
+    int syscall_count = 0;
+    if (!list_proc_pids(proc_fd, &dirents, &pids, &syscall_count))
+    {
+        close(proc_fd);
+        set_last_error("Failed to list /proc");
+        return false;
+    }
+
+    processes->clear();
+    processes->reserve(pids.size());
+    for (int pid : pids)
+    {
+        // Exited since the listing, or exited and not yet reaped
+        ProcStat stat;
+        if (!read_proc_stat(proc_fd, pid, &stat) || stat.state == 'Z')
+            continue;
+
+        RunningProcess process;
+        process.pid = pid;
+        process.parent_pid = stat.ppid;
+        process.start_time_ms = proc_start_time_ms(stat.start_time);
+        process.name = read_process_name(proc_fd, pid, stat.comm);
+        processes->push_back(std::move(process));
+    }
+    close(proc_fd);
+    return true;
+}
@@ -0,0 +1,46 @@
+#ifndef EXIT_WATCHER_H_
+#define EXIT_WATCHER_H_
+
+#include "process_monitor_api.h"
+#include "process_snapshot.h"
+#include "watch_list.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Reports the exit of watched processes the moment it happens, independently of the event source.
+// While a watcher is active it is the only origin of "stop" events for watched processes.
+class ExitWatcher
+{
+public:
+    virtual ~ExitWatcher() = default;
+
+    // Prepares the watcher so Track() can be called.
+    virtual bool Start() = 0;
+
+    // Watches every process in `running` that the watch list covers, by name and, for names
+    // narrowed to paths, by executable. Called with the process table's snapshot, taken once
+    // the event source is subscribed, so no process falls between the two.
+    virtual void WatchRunningProcesses(const std::vector<RunningProcess> &running) = 0;
+
+    // Watches a process the event source reported as started, if the watch list covers it.
+    // Called from the ingest thread.
+    virtual void Track(const CompactProcessEvent &start, const char *process_name) = 0;
+
+    // Returns true if the event source's stop event must be dropped because the watcher
+    // reports this process's exit itself.
+    virtual bool OwnsExit(const CompactProcessEvent &stop, const char *process_name) = 0;
+
+    // Stops watching and releases all handles.
+    virtual void Stop() = 0;
+};
+
+// Invoked from the watcher's thread for every exit it reports
+typedef void (*ExitWatcherCallback)(const CompactProcessEvent &event);
+
+// Creates the exit watcher for the current platform, or returns nullptr (after set_last_error)
+// where exact exit tracking is not supported. Implemented once per platform.
+ExitWatcher *create_exit_watcher(const WatchList &watch_list, ExitWatcherCallback on_exit);
+
+#endif // EXIT_WATCHER_H_
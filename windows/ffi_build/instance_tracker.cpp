@@ -0,0 +1,104 @@
+#include "instance_tracker.h"
+#include "event_source.h"
+#include "process_key.h"
+
+InstanceTracker::InstanceTracker(const WatchList &watch_list)
+    : m_watch_list(watch_list)
+{
+}
+
+void InstanceTracker::Seed(const std::vector<RunningProcess> &processes)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (const RunningProcess &process : processes)
+    {
+        if (!IsTracked(process.name.c_str(), process.pid, process.start_time_ms))
+            continue;
+
+        uint32_t name_id = intern_process_name(process.name);
+        ProcessKey key = make_process_key(process.pid, process.start_time_ms);
+        if (name_id != 0 && m_processes.emplace(process.pid, Instance{key, name_id}).second)
+            m_instances[name_id].insert(key);
+    }
+}
+
+int InstanceTracker::Observe(const CompactProcessEvent &event, CompactProcessEvent *edges)
+{
+    int count = 0;
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    ProcessKey key = process_key(event);
+    if (event.event_type == PROCESS_EVENT_START)
+    {
+        // A second exec by a tracked process ends its instance under the old name, and a start
+        // on a reused PID ends the process that held it before
+        auto known = m_processes.find(event.process_id);
+        if (known != m_processes.end() && (known->second.name_id != event.name_id || !process_keys_match(known->second.key, key)))
+            Remove(known->second.key, event, edges, &count);
+
+        if (IsTracked(lookup_process_name(event.name_id), event.process_id, event.start_time_ms))
+            Add(key, event.name_id, event, edges, &count);
+    }
+    else if (event.event_type == PROCESS_EVENT_STOP)
+    {
+        Remove(key, event, edges, &count);
+    }
+    return count;
+}
+
+size_t InstanceTracker::InstanceCount(uint32_t name_id) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto instances = m_instances.find(name_id);
+    return instances != m_instances.end() ? instances->second.size() : 0;
+}
+
+bool InstanceTracker::IsTracked(const char *process_name, int pid, long long start_time_ms) const
+{
+    if (process_name == nullptr || process_name[0] == '\0')
+        return false;
+    if (m_watch_list.Empty())
+        return true;
+    if (!m_watch_list.Matches(process_name))
+        return false;
+
+    // Same rule as the watch set filter for names narrowed to an executable path
+    return !m_watch_list.RequiresPath(process_name) || m_watch_list.MatchesPath(process_name, lookup_process_exe_path(pid, start_time_ms));
+}
+
+void InstanceTracker::Add(ProcessKey key, uint32_t name_id, const CompactProcessEvent &event, CompactProcessEvent *edges, int *count)
+{
+    if (!m_processes.emplace(process_key_pid(key), Instance{key, name_id}).second)
+        return;
+
+    auto &instances = m_instances[name_id];
+    instances.insert(key);
+    if (instances.size() == 1)
+    {
+        CompactProcessEvent &edge = edges[(*count)++];
+        edge = event;
+        edge.event_type = PROCESS_EVENT_FIRST_START;
+        edge.name_id = name_id;
+    }
+}
+
+void InstanceTracker::Remove(ProcessKey key, const CompactProcessEvent &event, CompactProcessEvent *edges, int *count)
+{
+    // A late stop for an earlier holder of the PID leaves the current one alone
+    auto known = m_processes.find(process_key_pid(key));
+    if (known == m_processes.end() || !process_keys_match(known->second.key, key))
+        return;
+
+    Instance instance = known->second;
+    m_processes.erase(known);
+
+    auto instances = m_instances.find(instance.name_id);
+    if (instances == m_instances.end() || instances->second.erase(instance.key) == 0 || !instances->second.empty())
+        return;
+    m_instances.erase(instances);
+
+    CompactProcessEvent &edge = edges[(*count)++];
+    edge = event;
+    edge.event_type = PROCESS_EVENT_LAST_STOP;
+    edge.name_id = instance.name_id;
+}
@@ -0,0 +1,58 @@
+#ifndef INSTANCE_TRACKER_H_
+#define INSTANCE_TRACKER_H_
+
+#include "process_monitor_api.h"
+#include "process_snapshot.h"
+#include "watch_list.h"
+
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// Tracks the running instances of each process name and turns the raw start/stop stream into
+// edges: PROCESS_EVENT_FIRST_START when a name goes from no instances to one, and
+// PROCESS_EVENT_LAST_STOP when its last instance exits.
+//
+// Seeded from a snapshot of the processes already running, so a name that was running before
+// monitoring started doesn't produce a first-start edge and does produce a last-stop edge.
+// Instances are process keys, so a stop that arrives after its PID was reused doesn't end the
+// new process, and a start on a reused PID ends the instance whose stop was missed.
+// Called from the ingest thread and the exit watcher thread.
+class InstanceTracker
+{
+public:
+    // Tracks the names on `watch_list`, or every name if it is empty
+    explicit InstanceTracker(const WatchList &watch_list);
+
+    void Seed(const std::vector<RunningProcess> &processes);
+
+    // Updates the instance sets for a delivered event and stores the resulting edge events
+    // (at most kMaxEdges) in `edges`. Returns how many were stored.
+    static constexpr int kMaxEdges = 2;
+    int Observe(const CompactProcessEvent &event, CompactProcessEvent *edges);
+
+    // Running instances of a name ID (0 if untracked)
+    size_t InstanceCount(uint32_t name_id) const;
+
+private:
+    WatchList m_watch_list;
+
+    struct Instance
+    {
+        ProcessKey key;
+        uint32_t name_id;
+    };
+
+    mutable std::mutex m_mutex;
+    std::unordered_map<uint32_t, std::unordered_set<ProcessKey>> m_instances; // Name ID -> running instances
+    std::unordered_map<int, Instance> m_processes;                            // PID -> the instance holding it
+
+    // Whether the process is on the watch list, its executable path included where the name is narrowed to one
+    bool IsTracked(const char *process_name, int pid, long long start_time_ms) const;
+    void Add(ProcessKey key, uint32_t name_id, const CompactProcessEvent &event, CompactProcessEvent *edges, int *count);
+    void Remove(ProcessKey key, const CompactProcessEvent &event, CompactProcessEvent *edges, int *count);
+};
+
+#endif // INSTANCE_TRACKER_H_
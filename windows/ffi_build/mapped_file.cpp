@@ -0,0 +1,239 @@
+#include "mapped_file.h"
+
+#ifdef _WIN32
+  #include <windows.h>
+#else
+  #include <cerrno>
+  #include <cstring>
+  #include <fcntl.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <unistd.h>
+#endif
+
+#ifdef _WIN32
+
+static std::string windows_error(const char *what)
+{
+    return std::string(what) + " failed (error " + std::to_string(GetLastError()) + ")";
+}
+
+// Paths are UTF-8, like every other string crossing the C API
+static std::wstring utf8_to_wide(const std::string &text)
+{
+    int length = MultiByteToWideChar(CP_UTF8, 0, text.data(), (int)text.size(), nullptr, 0);
+    std::wstring wide(length, L'\0');
+    MultiByteToWideChar(CP_UTF8, 0, text.data(), (int)text.size(), &wide[0], length);
+    return wide;
+}
+
+bool MappedFile::Create(const std::string &path, size_t size)
+{
+    Close();
+
+    HANDLE file = CreateFileW(utf8_to_wide(path).c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                              nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        m_error = windows_error("CreateFile");
+        return false;
+    }
+
+    // A mapping larger than the file extends it with zeros
+    HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READWRITE, (DWORD)((unsigned long long)size >> 32), (DWORD)(size & 0xFFFFFFFF), nullptr);
+    void *data = mapping != nullptr ? MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, size) : nullptr;
+    if (data == nullptr)
+    {
+        m_error = windows_error(mapping == nullptr ? "CreateFileMapping" : "MapViewOfFile");
+        if (mapping != nullptr)
+            CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+
+    m_file = file;
+    m_mapping = mapping;
+    m_data = data;
+    m_size = size;
+    m_writable = true;
+    return true;
+}
+
+bool MappedFile::OpenReadOnly(const std::string &path)
+{
+    Close();
+
+    HANDLE file = CreateFileW(utf8_to_wide(path).c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                              nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        m_error = windows_error("CreateFile");
+        return false;
+    }
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0)
+    {
+        m_error = size.QuadPart == 0 ? "File is empty" : windows_error("GetFileSizeEx");
+        CloseHandle(file);
+        return false;
+    }
+
+    HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    void *data = mapping != nullptr ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+    if (data == nullptr)
+    {
+        m_error = windows_error(mapping == nullptr ? "CreateFileMapping" : "MapViewOfFile");
+        if (mapping != nullptr)
+            CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+
+    m_file = file;
+    m_mapping = mapping;
+    m_data = data;
+    m_size = (size_t)size.QuadPart;
+    m_writable = false;
+    return true;
+}
+
+bool MappedFile::Flush(size_t offset, size_t length)
+{
+    if (!m_writable || length == 0)
+        return true;
+
+    if (!FlushViewOfFile((char *)m_data + offset, length) || !FlushFileBuffers(m_file))
+    {
+        m_error = windows_error("FlushViewOfFile");
+        return false;
+    }
+    return true;
+}
+
+void MappedFile::Close(size_t keep_size)
+{
+    if (m_data != nullptr)
+        UnmapViewOfFile(m_data);
+    if (m_mapping != nullptr)
+        CloseHandle(m_mapping);
+
+    // Fails while a reader still has the file mapped, which just leaves it at full size
+    if (m_file != nullptr && m_writable && keep_size < m_size)
+    {
+        LARGE_INTEGER position;
+        position.QuadPart = (LONGLONG)keep_size;
+        if (SetFilePointerEx(m_file, position, nullptr, FILE_BEGIN))
+            SetEndOfFile(m_file);
+    }
+    if (m_file != nullptr)
+        CloseHandle(m_file);
+
+    m_file = nullptr;
+    m_mapping = nullptr;
+    m_data = nullptr;
+    m_size = 0;
+    m_writable = false;
+}
+
+#else
+
+bool MappedFile::Create(const std::string &path, size_t size)
+{
+    Close();
+
+    int fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0)
+    {
+        m_error = "Failed to create " + path + ": " + strerror(errno);
+        return false;
+    }
+
+    // Sparse until written, so a fresh segment costs no disk space up front
+    void *data = MAP_FAILED;
+    if (ftruncate(fd, (off_t)size) == 0)
+        data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (data == MAP_FAILED)
+    {
+        m_error = "Failed to map " + path + ": " + strerror(errno);
+        close(fd);
+        return false;
+    }
+
+    m_fd = fd;
+    m_data = data;
+    m_size = size;
+    m_writable = true;
+    return true;
+}
+
+bool MappedFile::OpenReadOnly(const std::string &path)
+{
+    Close();
+
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        m_error = "Failed to open " + path + ": " + strerror(errno);
+        return false;
+    }
+
+    struct stat status;
+    if (fstat(fd, &status) != 0 || status.st_size == 0)
+    {
+        m_error = status.st_size == 0 ? path + " is empty" : "Failed to stat " + path + ": " + strerror(errno);
+        close(fd);
+        return false;
+    }
+
+    void *data = mmap(nullptr, (size_t)status.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    if (data == MAP_FAILED)
+    {
+        m_error = "Failed to map " + path + ": " + strerror(errno);
+        close(fd);
+        return false;
+    }
+
+    m_fd = fd;
+    m_data = data;
+    m_size = (size_t)status.st_size;
+    m_writable = false;
+    return true;
+}
+
+bool MappedFile::Flush(size_t offset, size_t length)
+{
+    if (!m_writable || length == 0)
+        return true;
+
+    // msync wants a page-aligned start
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    size_t start = offset / page * page;
+    if (msync((char *)m_data + start, offset + length - start, MS_SYNC) != 0)
+    {
+        m_error = std::string("msync failed: ") + strerror(errno);
+        return false;
+    }
+    return true;
+}
+
+void MappedFile::Close(size_t keep_size)
+{
+    if (m_data != nullptr)
+        munmap(m_data, m_size);
+    if (m_fd >= 0)
+    {
+        if (m_writable && keep_size < m_size && ftruncate(m_fd, (off_t)keep_size) != 0)
+        {
+            // Left at full size; readers only go by the committed length anyway
+        }
+        close(m_fd);
+    }
+
+    m_fd = -1;
+    m_data = nullptr;
+    m_size = 0;
+    m_writable = false;
+}
+
+#endif
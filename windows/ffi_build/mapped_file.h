@@ -0,0 +1,48 @@
+#ifndef MAPPED_FILE_H_
+#define MAPPED_FILE_H_
+
+#include <cstddef>
+#include <string>
+
+// A file mapped into memory in one piece: created at a fixed size and mapped read-write for
+// a writer, or mapped read-only as it is for readers, which may share it with a live writer.
+// Failures return false with the reason in Error().
+class MappedFile
+{
+public:
+    MappedFile() = default;
+    ~MappedFile() { Close(); }
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    // Creates (or truncates) `path` to `size` zero bytes and maps it read-write
+    bool Create(const std::string &path, size_t size);
+
+    // Maps an existing file read-only, at the size it has now
+    bool OpenReadOnly(const std::string &path);
+
+    // Writes `length` bytes from `offset` back to the file and waits until they are on disk
+    bool Flush(size_t offset, size_t length);
+
+    // Unmaps the file. A writer can pass the number of bytes worth keeping to cut off the rest.
+    void Close(size_t keep_size = (size_t)-1);
+
+    void *Data() const { return m_data; }
+    size_t Size() const { return m_size; }
+    const std::string &Error() const { return m_error; }
+
+private:
+    void *m_data = nullptr;
+    size_t m_size = 0;
+    bool m_writable = false;
+    std::string m_error;
+#ifdef _WIN32
+    void *m_file = nullptr;
+    void *m_mapping = nullptr;
+#else
+    int m_fd = -1;
+#endif
+};
+
+#endif // MAPPED_FILE_H_
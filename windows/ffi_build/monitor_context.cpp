@@ -0,0 +1,268 @@
+#include "monitor_context.h"
+#include "event_source.h"
+#include "pipeline_stats.h"
+#include "process_key.h"
+
+#include <cstring>
+
+// Events collected for the Dart port before a message is posted without waiting for the end of the pass
+static constexpr size_t kMaxDartBatch = 4096;
+
+static const char *event_type_name(unsigned char event_type)
+{
+    switch (event_type)
+    {
+    case PROCESS_EVENT_START: return "start";
+    case PROCESS_EVENT_FIRST_START: return "first_start";
+    case PROCESS_EVENT_LAST_STOP: return "last_stop";
+    default: return "stop";
+    }
+}
+
+void expand_process_event(const CompactProcessEvent &event, ProcessEventData *event_data)
+{
+    memset(event_data, 0, sizeof(ProcessEventData));
+    strncpy(event_data->event_type, event_type_name(event.event_type), sizeof(event_data->event_type) - 1);
+
+    const char *name = lookup_process_name(event.name_id);
+    if (name != nullptr)
+        strncpy(event_data->process_name, name, sizeof(event_data->process_name) - 1);
+
+    event_data->process_id = event.process_id;
+    event_data->timestamp_ms = event.timestamp_ms;
+}
+
+MonitorContext::MonitorContext(size_t queue_capacity)
+    : m_queue(queue_capacity, RingOverflowPolicy::kOverwriteOldest, kTimedRecordFormat)
+{
+}
+
+MonitorContext::~MonitorContext()
+{
+    Deactivate();
+    if (m_batcher)
+        m_batcher->Stop();
+}
+
+void MonitorContext::SetCallback(ProcessEventCallback callback, void *user_data)
+{
+    std::lock_guard<std::recursive_mutex> lock(m_callback_mutex);
+    m_callback = callback;
+    m_callback_user_data = user_data;
+}
+
+void MonitorContext::SetBatchCallback(ProcessEventBatchCallback callback, void *user_data, size_t max_events, int max_delay_us)
+{
+    m_batch_callback = callback;
+    m_batch_user_data = user_data;
+    m_batch_max_events = max_events;
+    m_batch_max_delay_us = max_delay_us;
+}
+
+bool MonitorContext::SetDartPort(void *api_dl_data, int64_t port)
+{
+    if (!m_dart_port_poster.Initialize(api_dl_data))
+        return false;
+    m_dart_port = port;
+    return true;
+}
+
+void MonitorContext::ClearDeliveryTargets()
+{
+    {
+        std::lock_guard<std::recursive_mutex> lock(m_callback_mutex);
+        m_callback = nullptr;
+        m_callback_user_data = nullptr;
+    }
+    m_batch_callback = nullptr;
+    m_batch_user_data = nullptr;
+    m_dart_port = 0;
+}
+
+bool MonitorContext::Activate()
+{
+    // The previous batcher was only asked to stop; it has delivered everything by now
+    if (m_batcher)
+    {
+        m_batcher->Stop();
+        std::atomic_store(&m_batcher, std::shared_ptr<EventBatcher>());
+    }
+    if (m_batch_callback != nullptr)
+    {
+        auto batcher = std::make_shared<EventBatcher>(m_batch_callback, m_batch_user_data, m_batch_max_events, m_batch_max_delay_us);
+        if (!batcher->Start())
+        {
+            SetLastError("Failed to start the batch callback thread");
+            return false;
+        }
+        std::atomic_store(&m_batcher, batcher);
+    }
+
+    std::shared_ptr<InstanceTracker> tracker;
+    if (m_event_delivery & PROCESS_EVENTS_EDGES)
+    {
+        std::shared_ptr<ProcessFilter> filter = std::atomic_load(&m_filter);
+        tracker = std::make_shared<InstanceTracker>(filter ? filter->Watching() : WatchList());
+    }
+    m_needs_seed = (bool)tracker;
+    std::atomic_store(&m_instance_tracker, tracker);
+
+    m_active = true;
+    return true;
+}
+
+void MonitorContext::Deactivate()
+{
+    if (!m_active.exchange(false))
+        return;
+
+    std::shared_ptr<EventBatcher> batcher = std::atomic_load(&m_batcher);
+    if (batcher)
+        batcher->RequestStop();
+    std::atomic_store(&m_instance_tracker, std::shared_ptr<InstanceTracker>());
+    Flush();
+
+    // Waits out a callback in progress; none starts once m_active is clear
+    {
+        std::lock_guard<std::recursive_mutex> lock(m_callback_mutex);
+    }
+
+    // Release a consumer blocked in a wait
+    m_signal.Set();
+}
+
+void MonitorContext::SeedInstances(const std::vector<RunningProcess> &running)
+{
+    std::shared_ptr<InstanceTracker> tracker = std::atomic_load(&m_instance_tracker);
+    if (tracker && m_needs_seed.exchange(false))
+        tracker->Seed(running);
+}
+
+bool MonitorContext::IsWanted(const CompactProcessEvent &event)
+{
+    int root = m_descendant_root;
+    if (root != 0 && event.process_id != root && !is_descendant_process(event.process_id, root))
+        return false;
+
+    std::shared_ptr<ProcessFilter> filter = std::atomic_load(&m_filter);
+    if (!filter || m_deliver_all_events)
+        return true;
+
+    const char *name = lookup_process_name(event.name_id);
+    if (event.event_type == PROCESS_EVENT_START)
+        return filter->AcceptStart(process_key(event), event.start_time_ms, event.name_id, name);
+    return filter->AcceptStop(process_key(event), event.name_id, name);
+}
+
+void MonitorContext::Push(const TimedProcessEvent &event)
+{
+    // A full queue is resolved by its overflow policy
+    PipelineStats &stats = pipeline_stats();
+    bool overwrote = false;
+    if (!m_queue.Push(event, &overwrote) || overwrote)
+        stats.Add(PipelineCounter::kDropped);
+    stats.RaiseQueueHighWater(m_queue.HighWaterMark());
+
+    // If we have a callback, call it immediately (kept for compatibility)
+    if (m_callback.load(std::memory_order_relaxed) == nullptr)
+        return;
+
+    std::lock_guard<std::recursive_mutex> lock(m_callback_mutex);
+    ProcessEventCallback callback = m_callback;
+    if (callback != nullptr && m_active)
+    {
+        stats.Add(PipelineCounter::kDelivered);
+        stats.RecordLatency(PipelineLatency::kIngestToDequeue, monotonic_time_ns() - event.ingest_time_ns);
+        try
+        {
+            ProcessEventData event_data;
+            expand_process_event(event.event, &event_data);
+            callback(&event_data, m_callback_user_data);
+        }
+        catch (...)
+        {
+            // Ignore callback errors to prevent crashes
+        }
+    }
+}
+
+void MonitorContext::Deliver(const TimedProcessEvent &event)
+{
+    // The tracker sees every event: its own watch list decides what it tracks, and
+    // repeats are harmless since a known start or an unknown stop changes nothing
+    CompactProcessEvent batch[1 + InstanceTracker::kMaxEdges];
+    int count = 0;
+    if ((m_event_delivery & PROCESS_EVENTS_RAW) && IsWanted(event.event))
+        batch[count++] = event.event;
+    else
+        pipeline_stats().Add(PipelineCounter::kFiltered);
+
+    std::shared_ptr<InstanceTracker> tracker = std::atomic_load(&m_instance_tracker);
+    if (tracker)
+        count += tracker->Observe(event.event, batch + count);
+    if (count == 0)
+        return;
+
+    // Collected for one Dart message per pass or handed to the batcher, bypassing the queue
+    if (m_dart_port != 0)
+    {
+        bool full;
+        {
+            std::lock_guard<std::mutex> lock(m_dart_mutex);
+            m_dart_pending.insert(m_dart_pending.end(), batch, batch + count);
+            full = m_dart_pending.size() >= kMaxDartBatch;
+        }
+        if (full)
+            Flush();
+        return;
+    }
+    std::shared_ptr<EventBatcher> batcher = std::atomic_load(&m_batcher);
+    if (batcher)
+    {
+        batcher->Add(batch, (size_t)count);
+        return;
+    }
+
+    // Edges carry the times of the event that caused them
+    for (int i = 0; i < count; i++)
+    {
+        TimedProcessEvent queued = event;
+        queued.event = batch[i];
+        Push(queued);
+    }
+
+    // Signal that new events are available
+    m_signal.Set();
+}
+
+void MonitorContext::Flush()
+{
+    std::lock_guard<std::mutex> lock(m_dart_mutex);
+    if (m_dart_pending.empty())
+        return;
+
+    // Posted under the lock so messages from the ingest and exit watcher threads stay in order;
+    // Dart_PostCObject copies the message and doesn't wait for the isolate
+    int64_t dart_port = m_dart_port;
+    bool posted = dart_port != 0 && m_dart_port_poster.Post(dart_port, m_dart_pending.data(), m_dart_pending.size());
+    pipeline_stats().Add(posted ? PipelineCounter::kDelivered : PipelineCounter::kDropped, (uint64_t)m_dart_pending.size());
+    m_dart_pending.clear();
+}
+
+void MonitorContext::SetLastError(const std::string &message)
+{
+    std::lock_guard<std::mutex> lock(m_error_mutex);
+    m_last_error = message;
+}
+
+std::string MonitorContext::LastError()
+{
+    std::lock_guard<std::mutex> lock(m_error_mutex);
+    return m_last_error;
+}
+
+void MonitorContext::ClearLastError()
+{
+    std::lock_guard<std::mutex> lock(m_error_mutex);
+    m_last_error.clear();
+}
@@ -0,0 +1,129 @@
+#ifndef MONITOR_CONTEXT_H_
+#define MONITOR_CONTEXT_H_
+
+#include "process_monitor_api.h"
+#include "dart_port.h"
+#include "event_batcher.h"
+#include "event_ring.h"
+#include "event_signal.h"
+#include "instance_tracker.h"
+#include "process_filter.h"
+#include "process_snapshot.h"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Record formats published in the ring header
+static constexpr uint32_t kCompactRecordFormat = 1; // CompactProcessEvent
+static constexpr uint32_t kTimedRecordFormat = 2;   // TimedProcessEvent
+
+// One consumer's view of the event stream: its own queue, watch set, edge tracking, delivery
+// mode and last error. The backend (event source, exit watcher, name table, deduplication)
+// is shared, so every extra context costs a queue and a filter rather than a kernel subscription.
+//
+// Deliver() is called from the ingest and exit watcher threads while the context is active;
+// the settings below are changed from the consumer's thread.
+class MonitorContext
+{
+public:
+    explicit MonitorContext(size_t queue_capacity);
+    ~MonitorContext();
+
+    MonitorContext(const MonitorContext &) = delete;
+    MonitorContext &operator=(const MonitorContext &) = delete;
+
+    // Events keep their timestamps while queued; a TimedProcessEvent fits the same cache-line cell
+    EventRing<TimedProcessEvent> &Queue() { return m_queue; }
+    EventSignal &Signal() { return m_signal; }
+
+    // Watch set checked before events are queued; null delivers every event. Takes effect immediately.
+    void SetFilter(std::shared_ptr<ProcessFilter> filter) { std::atomic_store(&m_filter, filter); }
+    void SetDeliverAllEvents(bool deliver_all) { m_deliver_all_events = deliver_all; }
+
+    // Limits events to a process and its descendants (0 for no limit). Takes effect immediately.
+    void SetDescendantRoot(int root_process_id) { m_descendant_root = root_process_id; }
+
+    // ProcessEventDelivery flags; applied when the context is activated
+    void SetEventDelivery(int flags) { m_event_delivery = flags; }
+    int EventDelivery() const { return m_event_delivery; }
+
+    // Alternatives to the queue, chosen before the context is activated
+    void SetCallback(ProcessEventCallback callback, void *user_data);
+    void SetBatchCallback(ProcessEventBatchCallback callback, void *user_data, size_t max_events, int max_delay_us);
+    bool SetDartPort(void *api_dl_data, int64_t port);
+    void ClearDeliveryTargets();
+
+    // Starts and stops the flow of events into the context. Activate() builds the instance tracker
+    // and batcher; the tracker is seeded by SeedInstances() once the backend is listening.
+    bool Activate();
+    void Deactivate();
+    bool IsActive() const { return m_active; }
+
+    // Seeds the instance tracker, once per activation
+    void SeedInstances(const std::vector<RunningProcess> &running);
+    bool NeedsSeed() const { return m_needs_seed; }
+
+    // Filters, tracks and queues (or posts) an event deduplicated by the backend
+    void Deliver(const TimedProcessEvent &event);
+
+    // Posts the events collected for the Dart port since the last call as one message.
+    // Called once per pass of the event source (e.g. one netlink recv) and by the exit watcher.
+    void Flush();
+
+    // Set from the API threads and by the monitor thread when the backend fails, so read as a copy
+    void SetLastError(const std::string &message);
+    std::string LastError();
+    void ClearLastError();
+
+private:
+    EventRing<TimedProcessEvent> m_queue;
+    EventSignal m_signal;
+
+    std::shared_ptr<ProcessFilter> m_filter; // Swapped with std::atomic_load/atomic_store
+    std::atomic<bool> m_deliver_all_events{false};
+    std::atomic<int> m_descendant_root{0};
+    std::atomic<int> m_event_delivery{PROCESS_EVENTS_RAW};
+
+    // Edges for the watch set registered when the context was activated
+    std::shared_ptr<InstanceTracker> m_instance_tracker;
+    std::atomic<bool> m_needs_seed{false};
+
+    // Per-event callback (kept for compatibility). The mutex is held while the callback runs, so
+    // changing the callback or deactivating waits for a call in progress; it is recursive so the
+    // callback itself may stop monitoring. m_callback is also read without it to skip the lock.
+    std::recursive_mutex m_callback_mutex;
+    std::atomic<ProcessEventCallback> m_callback{nullptr};
+    void *m_callback_user_data = nullptr;
+
+    // Batch callback; the batcher runs while the context is active and is joined on the next
+    // activation or on destruction, so stopping never waits for a callback in progress
+    ProcessEventBatchCallback m_batch_callback = nullptr;
+    void *m_batch_user_data = nullptr;
+    size_t m_batch_max_events = 0;
+    int m_batch_max_delay_us = 0;
+    std::shared_ptr<EventBatcher> m_batcher;
+
+    DartPortPoster m_dart_port_poster;
+    std::atomic<int64_t> m_dart_port{0};
+
+    // Events waiting for the next Flush(), appended by the ingest and exit watcher threads
+    std::mutex m_dart_mutex;
+    std::vector<CompactProcessEvent> m_dart_pending;
+
+    std::atomic<bool> m_active{false};
+
+    std::mutex m_error_mutex;
+    std::string m_last_error;
+
+    bool IsWanted(const CompactProcessEvent &event);
+    void Push(const TimedProcessEvent &event);
+};
+
+// Fills the FFI structure from a compact record
+void expand_process_event(const CompactProcessEvent &event, ProcessEventData *event_data);
+
+#endif // MONITOR_CONTEXT_H_
@@ -0,0 +1,139 @@
+#include "name_table.h"
+
+#include <mutex>
+
+#ifdef _WIN32
+  #include <windows.h>
+#endif
+
+// Rough per-entry cost of an unordered_map node (next pointer, cached hash, key, value)
+template <typename Map>
+static size_t map_memory_bytes(const Map &map)
+{
+    size_t node_size = sizeof(void *) + sizeof(size_t) + sizeof(typename Map::value_type);
+    return map.size() * node_size + map.bucket_count() * sizeof(void *);
+}
+
+NameTable::NameTable()
+{
+    for (auto &chunk : m_chunks)
+        chunk.store(nullptr, std::memory_order_relaxed);
+}
+
+NameTable::~NameTable()
+{
+    for (auto &chunk : m_chunks)
+        delete[] chunk.load(std::memory_order_relaxed);
+}
+
+uint32_t NameTable::Intern(const char *name, size_t length)
+{
+    if (name == nullptr || length == 0)
+        return 0;
+
+    m_intern_count.fetch_add(1, std::memory_order_relaxed);
+    std::string_view key(name, length);
+    {
+        std::shared_lock<std::shared_mutex> lock(m_mutex);
+        auto known = m_ids.find(key);
+        if (known != m_ids.end())
+            return known->second;
+    }
+
+    std::unique_lock<std::shared_mutex> lock(m_mutex);
+    auto known = m_ids.find(key);
+    if (known != m_ids.end())
+        return known->second;
+
+    return InsertLocked(std::string(name, length));
+}
+
+#ifdef _WIN32
+uint32_t NameTable::Intern(const wchar_t *name, size_t length)
+{
+    if (name == nullptr || length == 0)
+        return 0;
+
+    m_intern_count.fetch_add(1, std::memory_order_relaxed);
+    std::wstring_view key(name, length);
+    {
+        std::shared_lock<std::shared_mutex> lock(m_mutex);
+        auto known = m_wide_ids.find(key);
+        if (known != m_wide_ids.end())
+            return known->second;
+    }
+
+    // First sighting of this spelling: convert outside the lock
+    int utf8_length = WideCharToMultiByte(CP_UTF8, 0, name, (int)length, nullptr, 0, nullptr, nullptr);
+    if (utf8_length <= 0)
+        return 0;
+    std::string utf8_name(utf8_length, '\0');
+    WideCharToMultiByte(CP_UTF8, 0, name, (int)length, &utf8_name[0], utf8_length, nullptr, nullptr);
+
+    std::unique_lock<std::shared_mutex> lock(m_mutex);
+    auto known = m_wide_ids.find(key);
+    if (known != m_wide_ids.end())
+        return known->second;
+
+    uint32_t id;
+    auto utf8_known = m_ids.find(utf8_name);
+    if (utf8_known != m_ids.end())
+        id = utf8_known->second;
+    else
+        id = InsertLocked(std::move(utf8_name));
+    if (id == 0)
+        return 0;
+
+    m_wide_keys.emplace_back(name, length);
+    m_wide_ids.emplace(m_wide_keys.back(), id);
+    m_string_bytes += (length + 1) * sizeof(wchar_t);
+    return id;
+}
+#endif
+
+const char *NameTable::Lookup(uint32_t id) const
+{
+    if (id == 0 || id > m_count.load(std::memory_order_acquire))
+        return nullptr;
+
+    size_t index = id - 1;
+    return m_chunks[index / kChunkSize].load(std::memory_order_acquire)[index % kChunkSize];
+}
+
+size_t NameTable::MemoryBytes() const
+{
+    std::shared_lock<std::shared_mutex> lock(m_mutex);
+    size_t chunks = (m_names.size() + kChunkSize - 1) / kChunkSize;
+    size_t bytes = sizeof(NameTable) + m_string_bytes + m_names.size() * sizeof(std::string) + map_memory_bytes(m_ids) + chunks * kChunkSize * sizeof(const char *);
+#ifdef _WIN32
+    bytes += m_wide_keys.size() * sizeof(std::wstring) + map_memory_bytes(m_wide_ids);
+#endif
+    return bytes;
+}
+
+uint32_t NameTable::InsertLocked(std::string utf8_name)
+{
+    size_t index = m_names.size();
+    if (index >= kChunkSize * kMaxChunks)
+        return 0;
+
+    const char **chunk = m_chunks[index / kChunkSize].load(std::memory_order_relaxed);
+    if (chunk == nullptr)
+    {
+        chunk = new const char *[kChunkSize];
+        m_chunks[index / kChunkSize].store(chunk, std::memory_order_release);
+    }
+
+    m_names.push_back(std::move(utf8_name));
+    const std::string &stored = m_names.back();
+    m_string_bytes += stored.size() + 1;
+
+    uint32_t id = (uint32_t)(index + 1);
+    m_ids.emplace(std::string_view(stored), id);
+    chunk[index % kChunkSize] = stored.c_str();
+
+    // Publish the ID only once its string is in place
+    m_count.store(index + 1, std::memory_order_release);
+    m_insert_count.fetch_add(1, std::memory_order_relaxed);
+    return id;
+}
@@ -0,0 +1,75 @@
+#ifndef NAME_TABLE_H_
+#define NAME_TABLE_H_
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+// Interns process names: maps each distinct name to a small stable ID and its UTF-8 string,
+// so events carry a 32-bit ID and a name is converted and copied only the first time it is seen.
+//
+// IDs start at 1 (0 means no name) and are never reused. A name's string stays at the same
+// address for the lifetime of the table, so Lookup() results can be handed out through the C API.
+// Lookup() is lock-free; Intern() takes a shared lock for names already known.
+//
+// Names are keyed by their raw bytes as the platform delivers them (UTF-8/bytes from /proc,
+// UTF-16 from WMI), so a repeat sighting is a hash lookup with no conversion or allocation.
+class NameTable
+{
+public:
+    NameTable();
+    ~NameTable();
+
+    NameTable(const NameTable &) = delete;
+    NameTable &operator=(const NameTable &) = delete;
+
+    // Returns the ID for a UTF-8 name, adding it on first sight. Returns 0 for an empty name
+    // or when the table is full.
+    uint32_t Intern(const char *name, size_t length);
+    uint32_t Intern(const std::string &name) { return Intern(name.data(), name.size()); }
+
+#ifdef _WIN32
+    // Returns the ID for a UTF-16 name; converted to UTF-8 only the first time it is seen
+    uint32_t Intern(const wchar_t *name, size_t length);
+#endif
+
+    // Returns the name for `id`, or nullptr if there is no such ID
+    const char *Lookup(uint32_t id) const;
+
+    size_t Count() const { return m_count.load(std::memory_order_acquire); }
+
+    // Approximate heap memory held by the table, in bytes
+    size_t MemoryBytes() const;
+
+    // Intern() calls, and how many of them added a name
+    uint64_t InternCount() const { return m_intern_count.load(std::memory_order_relaxed); }
+    uint64_t InsertCount() const { return m_insert_count.load(std::memory_order_relaxed); }
+
+private:
+    // ID -> string, in fixed-size chunks that never move so Lookup() needs no lock
+    static constexpr size_t kChunkSize = 1024;
+    static constexpr size_t kMaxChunks = 1024;
+
+    mutable std::shared_mutex m_mutex;
+    std::deque<std::string> m_names; // Indexed by ID - 1; a deque never moves its elements
+    std::unordered_map<std::string_view, uint32_t> m_ids;
+#ifdef _WIN32
+    std::deque<std::wstring> m_wide_keys;
+    std::unordered_map<std::wstring_view, uint32_t> m_wide_ids;
+#endif
+    size_t m_string_bytes = 0;
+
+    std::atomic<const char **> m_chunks[kMaxChunks];
+    std::atomic<size_t> m_count{0};
+
+    std::atomic<uint64_t> m_intern_count{0};
+    std::atomic<uint64_t> m_insert_count{0};
+
+    uint32_t InsertLocked(std::string utf8_name);
+};
+
+#endif // NAME_TABLE_H_
@@ -0,0 +1,344 @@
+#include "netlink_event_source.h"
+#include "pipeline_stats.h"
+#include "process_details.h"
+#include "procfs.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <linux/cn_proc.h>
+#include <linux/connector.h>
+#include <linux/netlink.h>
+
+// Size of the receive buffer; one datagram carries a single proc_event, but reading
+// in large chunks keeps a burst from overflowing the socket buffer
+static constexpr size_t kReceiveBufferSize = 64 * 1024;
+
+bool NetlinkEventSource::Initialize()
+{
+    int socket_fd = socket(PF_NETLINK, SOCK_DGRAM | SOCK_CLOEXEC, NETLINK_CONNECTOR);
+    if (socket_fd < 0)
+    {
+        set_last_error("Failed to create proc connector socket: " + std::string(strerror(errno)));
+        return false;
+    }
+
+    sockaddr_nl address = {};
+    address.nl_family = AF_NETLINK;
+    address.nl_groups = CN_IDX_PROC;
+    address.nl_pid = 0; // Let the kernel assign a unique port id
+
+    if (bind(socket_fd, (sockaddr *)&address, sizeof(address)) < 0)
+    {
+        set_last_error("Failed to bind proc connector socket: " + std::string(strerror(errno)));
+        close(socket_fd);
+        return false;
+    }
+
+    // Give bursts some headroom before the kernel starts dropping with ENOBUFS
+    int receive_buffer = 4 * 1024 * 1024;
+    setsockopt(socket_fd, SOL_SOCKET, SO_RCVBUF, &receive_buffer, sizeof(receive_buffer));
+
+    if (!SetListening(socket_fd, true))
+    {
+        set_last_error("Failed to subscribe to proc connector (CAP_NET_ADMIN required): " + std::string(strerror(errno)));
+        close(socket_fd);
+        return false;
+    }
+
+    m_socket = socket_fd;
+    m_proc_fd = open_proc_dir();
+
+    struct stat socket_stat;
+    if (fstat(socket_fd, &socket_stat) == 0)
+        m_socket_inode = (unsigned long long)socket_stat.st_ino;
+    m_reported_drops = ReadSocketDrops();
+    return true;
+}
+
+uint64_t NetlinkEventSource::ReadSocketDrops() const
+{
+    if (m_proc_fd < 0 || m_socket_inode == 0)
+        return 0;
+
+    int fd = openat(m_proc_fd, "net/netlink", O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return 0;
+    FILE *file = fdopen(fd, "r");
+    if (file == nullptr)
+    {
+        close(fd);
+        return 0;
+    }
+
+    // Columns are found by name in the header line, their order has changed between kernels
+    size_t drops_column = 0;
+    size_t inode_column = 0;
+    uint64_t drops = 0;
+    char line[512];
+    for (bool header = true; fgets(line, sizeof(line), file) != nullptr; header = false)
+    {
+        std::vector<std::string> fields;
+        std::istringstream stream(line);
+        for (std::string field; stream >> field;)
+            fields.push_back(std::move(field));
+
+        if (header)
+        {
+            auto drops_it = std::find(fields.begin(), fields.end(), "Drops");
+            auto inode_it = std::find(fields.begin(), fields.end(), "Inode");
+            if (drops_it == fields.end() || inode_it == fields.end())
+                break;
+            drops_column = drops_it - fields.begin();
+            inode_column = inode_it - fields.begin();
+        }
+        else if (fields.size() > std::max(drops_column, inode_column) && strtoull(fields[inode_column].c_str(), nullptr, 10) == m_socket_inode)
+        {
+            drops = strtoull(fields[drops_column].c_str(), nullptr, 10);
+            break;
+        }
+    }
+    fclose(file);
+    return drops;
+}
+
+void NetlinkEventSource::CountKernelDrops(bool overrun)
+{
+    // The socket's drop counter keeps counting after ENOBUFS is raised, so only the growth is new
+    uint64_t drops = ReadSocketDrops();
+    if (drops > m_reported_drops)
+    {
+        pipeline_stats().Add(PipelineCounter::kDropped, drops - m_reported_drops);
+        m_reported_drops = drops;
+    }
+    else if (overrun && drops == 0 && m_reported_drops == 0)
+    {
+        // The counter couldn't be read; at least one notification was lost
+        pipeline_stats().Add(PipelineCounter::kDropped);
+    }
+}
+
+bool NetlinkEventSource::SetListening(int socket_fd, bool listen)
+{
+    // nlmsghdr | cn_msg | proc_cn_mcast_op, laid out by hand since cn_msg ends in a flexible array
+    alignas(nlmsghdr) char request[NLMSG_SPACE(sizeof(cn_msg) + sizeof(proc_cn_mcast_op))] = {};
+
+    nlmsghdr *header = (nlmsghdr *)request;
+    header->nlmsg_len = NLMSG_LENGTH(sizeof(cn_msg) + sizeof(proc_cn_mcast_op));
+    header->nlmsg_type = NLMSG_DONE;
+    header->nlmsg_pid = 0;
+
+    cn_msg *message = (cn_msg *)NLMSG_DATA(header);
+    message->id.idx = CN_IDX_PROC;
+    message->id.val = CN_VAL_PROC;
+    message->len = sizeof(proc_cn_mcast_op);
+
+    proc_cn_mcast_op op = listen ? PROC_CN_MCAST_LISTEN : PROC_CN_MCAST_IGNORE;
+    memcpy(message->data, &op, sizeof(op));
+
+    return send(socket_fd, request, header->nlmsg_len, 0) == (ssize_t)header->nlmsg_len;
+}
+
+void NetlinkEventSource::Run(const std::atomic<bool> &running, EventSignal &stop_signal)
+{
+    alignas(nlmsghdr) static thread_local char buffer[kReceiveBufferSize];
+
+    while (running)
+    {
+        int socket_fd = m_socket;
+        if (socket_fd < 0)
+            break;
+
+        // Sleeps until the kernel has something or monitoring stops, with no idle wakeups
+        pollfd descriptors[2] = {{socket_fd, POLLIN, 0}, {stop_signal.Descriptor(), POLLIN, 0}};
+        int ready = poll(descriptors, 2, -1);
+        if (ready < 0 && errno == EINTR)
+            continue;
+        if (ready < 0 || (descriptors[0].revents & POLLNVAL))
+            break;
+        if (descriptors[1].revents & POLLIN)
+        {
+            // Consumed so a stale signal can't keep poll() spinning; the loop re-checks `running`
+            stop_signal.Wait(0);
+            continue;
+        }
+        // POLLERR is how a receive buffer overrun shows up; recv() reports it as ENOBUFS
+        if (!(descriptors[0].revents & (POLLIN | POLLERR)))
+            continue;
+
+        ssize_t length = recv(socket_fd, buffer, sizeof(buffer), MSG_DONTWAIT);
+        if (length < 0)
+        {
+            // ENOBUFS means the kernel dropped notifications because we fell behind; keep going
+            if (errno == ENOBUFS)
+            {
+                CountKernelDrops(true);
+                continue;
+            }
+            if (errno == EINTR || errno == EAGAIN)
+                continue;
+            set_last_error("Proc connector receive failed: " + std::string(strerror(errno)));
+            break;
+        }
+
+        for (nlmsghdr *header = (nlmsghdr *)buffer; NLMSG_OK(header, (size_t)length); header = NLMSG_NEXT(header, length))
+        {
+            if (header->nlmsg_type == NLMSG_ERROR || header->nlmsg_type == NLMSG_NOOP)
+                continue;
+
+            HandleMessage((const cn_msg *)NLMSG_DATA(header));
+        }
+        flush_process_events();
+    }
+
+    // Drops made while the socket was still congested raise no further ENOBUFS
+    CountKernelDrops(false);
+}
+
+void NetlinkEventSource::HandleMessage(const cn_msg *message)
+{
+    if (message->id.idx != CN_IDX_PROC || message->id.val != CN_VAL_PROC)
+        return;
+
+    const proc_event *event = (const proc_event *)message->data;
+
+    switch (event->what)
+    {
+    case proc_event::PROC_EVENT_FORK:
+    {
+        // New thread groups only; remembered for the parent PID of their start and stop events
+        const auto &fork = event->event_data.fork;
+        if (fork.child_pid == fork.child_tgid)
+        {
+            m_processes[fork.child_tgid].parent_pid = fork.parent_tgid;
+            publish_process_fork(fork.child_tgid, fork.parent_tgid);
+        }
+        break;
+    }
+    case proc_event::PROC_EVENT_COMM:
+    {
+        // Sent on exec (before PROC_EVENT_EXEC) and on prctl(PR_SET_NAME); only track thread group leaders
+        const auto &comm = event->event_data.comm;
+        if (comm.process_pid == comm.process_tgid)
+            m_processes[comm.process_tgid].name_id = intern_process_name(comm.comm, strnlen(comm.comm, sizeof(comm.comm)));
+        break;
+    }
+    case proc_event::PROC_EVENT_EXEC:
+    {
+        int pid = event->event_data.exec.process_tgid;
+        KnownProcess &known = m_processes[pid];
+        known.exec_seen = true;
+
+        // The start time tells this process apart from earlier ones with the same PID
+        ProcStat stat;
+        if (read_proc_stat(m_proc_fd, pid, &stat))
+        {
+            known.start_time_ms = proc_start_time_ms(stat.start_time);
+            if (known.parent_pid == 0)
+                known.parent_pid = stat.ppid;
+        }
+
+        // The executable's path comes with its name, so it is kept for get_process_details
+        const char *comm = lookup_process_name(known.name_id);
+        std::string exe_path = read_process_exe_path(m_proc_fd, pid);
+        if (!exe_path.empty())
+        {
+            known.name_id = intern_process_name(exe_file_name(exe_path));
+            ProcessDetailsRecord details;
+            details.fields = PROCESS_DETAIL_EXE_PATH;
+            details.exe_path = std::move(exe_path);
+            record_process_details(pid, known.start_time_ms, details);
+        }
+        else if (comm == nullptr)
+            known.name_id = intern_process_name(!stat.comm.empty() ? stat.comm : read_process_comm(m_proc_fd, pid));
+
+        CompactProcessEvent start = {};
+        start.event_type = PROCESS_EVENT_START;
+        start.process_id = pid;
+        start.parent_process_id = known.parent_pid;
+        start.name_id = known.name_id;
+        start.start_time_ms = known.start_time_ms;
+        start.timestamp_ms = monotonic_to_timestamp_ms((long long)event->timestamp_ns);
+        publish_process_event(start, (long long)event->timestamp_ns);
+        break;
+    }
+    case proc_event::PROC_EVENT_EXIT:
+    {
+        // Thread exits are reported too; only the thread group leader ends the process
+        const auto &exit = event->event_data.exit;
+        if (exit.process_pid != exit.process_tgid)
+            break;
+
+        int pid = exit.process_tgid;
+        KnownProcess process;
+        auto known = m_processes.find(pid);
+        if (known != m_processes.end())
+        {
+            process = known->second;
+            m_processes.erase(known);
+        }
+        if (process.name_id == 0 || process.start_time_ms == 0)
+        {
+            // Started before we subscribed (or never exec'd); the zombie's stat is still readable until it is reaped
+            ProcStat stat;
+            if (read_proc_stat(m_proc_fd, pid, &stat))
+            {
+                process.start_time_ms = proc_start_time_ms(stat.start_time);
+                if (process.parent_pid == 0)
+                    process.parent_pid = stat.ppid;
+                if (process.name_id == 0)
+                    process.name_id = intern_process_name(stat.comm);
+            }
+        }
+
+        // A fork that never exec'd was never reported as started, unless it was already running
+        // when the process table was loaded
+        if (!process.exec_seen && !is_known_process(pid, process.start_time_ms))
+        {
+            publish_process_fork_exit(pid, process.start_time_ms);
+            break;
+        }
+
+        CompactProcessEvent stop = {};
+        stop.event_type = PROCESS_EVENT_STOP;
+        stop.process_id = pid;
+        stop.parent_process_id = process.parent_pid;
+        stop.name_id = process.name_id;
+        stop.start_time_ms = process.start_time_ms;
+        stop.timestamp_ms = monotonic_to_timestamp_ms((long long)event->timestamp_ns);
+        publish_process_event(stop, (long long)event->timestamp_ns);
+        break;
+    }
+    default:
+        break;
+    }
+}
+
+void NetlinkEventSource::Cleanup()
+{
+    int socket_fd = m_socket.exchange(-1);
+    if (socket_fd >= 0)
+    {
+        SetListening(socket_fd, false);
+        close(socket_fd);
+    }
+}
+
+NetlinkEventSource::~NetlinkEventSource()
+{
+    Cleanup();
+    if (m_proc_fd >= 0)
+        close(m_proc_fd);
+}
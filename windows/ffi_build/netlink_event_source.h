@@ -0,0 +1,57 @@
+#ifndef NETLINK_EVENT_SOURCE_H_
+#define NETLINK_EVENT_SOURCE_H_
+
+#include "event_source.h"
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+
+struct cn_msg;
+
+// Linux event source built on the kernel proc connector (NETLINK_CONNECTOR / CN_IDX_PROC).
+// The kernel pushes fork/exec/exit notifications as they happen, so there is no polling interval.
+// Subscribing requires CAP_NET_ADMIN.
+//
+// A process is reported as "start" when it execs (that is when it gets its executable name)
+// and as "stop" when its thread group leader exits. A fork that exits without exec'ing is not
+// reported at all, so every stop pairs with a start or with the startup process table.
+class NetlinkEventSource : public EventSource
+{
+public:
+    NetlinkEventSource() = default;
+    ~NetlinkEventSource() override;
+
+    bool Initialize() override;
+    void Run(const std::atomic<bool> &running, EventSignal &stop_signal) override;
+    void Cleanup() override;
+    ProcessEventSourceType Type() const override { return PROCESS_EVENT_SOURCE_PROC_CONNECTOR; }
+
+private:
+    std::atomic<int> m_socket{-1};
+    int m_proc_fd = -1;
+
+    // For finding the socket in /proc/net/netlink, whose Drops column counts the notifications
+    // the kernel discarded when the receive buffer was full
+    unsigned long long m_socket_inode = 0;
+    uint64_t m_reported_drops = 0;
+
+    struct KnownProcess
+    {
+        uint32_t name_id = 0;
+        int parent_pid = 0;
+        long long start_time_ms = 0;
+        bool exec_seen = false; // Reported as started
+    };
+
+    // Last known name and parent per thread group, so "stop" events can be filled in after /proc/<pid> is gone
+    std::unordered_map<int, KnownProcess> m_processes;
+
+    bool SetListening(int socket_fd, bool listen);
+    uint64_t ReadSocketDrops() const;
+    void CountKernelDrops(bool overrun); // Adds the notifications lost since the last call to the pipeline stats
+    void HandleMessage(const cn_msg *message);
+};
+
+#endif // NETLINK_EVENT_SOURCE_H_
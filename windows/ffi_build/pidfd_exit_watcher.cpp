@@ -0,0 +1,337 @@
+#include "pidfd_exit_watcher.h"
+#include "event_source.h"
+#include "process_key.h"
+#include "procfs.h"
+
+#include <cerrno>
+#include <cstring>
+#include <utility>
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#ifndef SYS_pidfd_open
+#define SYS_pidfd_open 434
+#endif
+
+// epoll_data value reserved for the wakeup eventfd; process keys are never 0 since PIDs are positive
+static constexpr uint64_t kWakeTag = 0;
+
+// Reported exits remembered for the event source's matching stop
+static constexpr size_t kMaxReportedExits = 1024;
+
+// Exits handled per epoll_wait call
+static constexpr int kMaxEventsPerWait = 64;
+
+static int pidfd_open(int pid)
+{
+    return (int)syscall(SYS_pidfd_open, pid, 0);
+}
+
+PidfdExitWatcher::PidfdExitWatcher(const WatchList &watch_list, ExitWatcherCallback on_exit)
+    : m_watch_list(watch_list), m_on_exit(on_exit)
+{
+}
+
+PidfdExitWatcher::~PidfdExitWatcher()
+{
+    Stop();
+}
+
+bool PidfdExitWatcher::Start()
+{
+    // Probe with our own PID so an old kernel fails here rather than on every Track()
+    int probe = pidfd_open(getpid());
+    if (probe < 0)
+    {
+        set_last_error("pidfd_open is not available (Linux 5.3+ required): " + std::string(strerror(errno)));
+        return false;
+    }
+    close(probe);
+
+    m_epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    m_wake_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    m_proc_fd = open_proc_dir();
+    if (m_epoll_fd < 0 || m_wake_fd < 0 || m_proc_fd < 0)
+    {
+        set_last_error("Failed to create exit watcher epoll set: " + std::string(strerror(errno)));
+        Stop();
+        return false;
+    }
+
+    epoll_event wake = {};
+    wake.events = EPOLLIN;
+    wake.data.u64 = kWakeTag;
+    epoll_ctl(m_epoll_fd, EPOLL_CTL_ADD, m_wake_fd, &wake);
+
+    m_running = true;
+    m_thread = std::thread(&PidfdExitWatcher::ThreadMain, this);
+    return true;
+}
+
+void PidfdExitWatcher::WatchRunningProcesses(const std::vector<RunningProcess> &running)
+{
+    for (const RunningProcess &process : running)
+    {
+        uint32_t name_id = intern_process_name(process.name);
+        if (!IsWatched(process.pid, process.start_time_ms, name_id, process.name.c_str()))
+            continue;
+
+        ProcessInfo info;
+        info.name_id = name_id;
+        info.parent_pid = process.parent_pid;
+        info.start_time_ms = process.start_time_ms;
+        Watch(process.pid, info);
+    }
+}
+
+void PidfdExitWatcher::Track(const CompactProcessEvent &start, const char *process_name)
+{
+    if (!IsWatched(start.process_id, start.start_time_ms, start.name_id, process_name))
+        return;
+
+    ProcessInfo info;
+    info.name_id = start.name_id;
+    info.parent_pid = start.parent_process_id;
+    info.start_time_ms = start.start_time_ms;
+    Watch(start.process_id, info);
+}
+
+bool PidfdExitWatcher::OwnsExit(const CompactProcessEvent &stop, const char *process_name)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (Classify(stop.name_id, process_name) == kIgnored)
+        return false;
+
+    // Ours if its pidfd is still pending or has fired already; anything else (a process whose
+    // pidfd couldn't be opened, one whose start was missed, or one run from an unwatched path)
+    // is left to the event source
+    ProcessKey key = process_key(stop);
+    if (FindWatched(key) != m_watched.end())
+        return true;
+
+    auto reported = FindReported(key);
+    if (reported == m_reported.end())
+        return false;
+    m_reported.erase(reported);
+    return true;
+}
+
+void PidfdExitWatcher::Stop()
+{
+    if (m_thread.joinable())
+    {
+        m_running = false;
+        uint64_t one = 1;
+        (void)!write(m_wake_fd, &one, sizeof(one));
+        m_thread.join();
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (auto &watched : m_watched)
+        close(watched.second.pidfd);
+    m_watched.clear();
+    m_reported.clear();
+    m_reported_order.clear();
+
+    if (m_epoll_fd >= 0)
+    {
+        close(m_epoll_fd);
+        m_epoll_fd = -1;
+    }
+    if (m_wake_fd >= 0)
+    {
+        close(m_wake_fd);
+        m_wake_fd = -1;
+    }
+    if (m_proc_fd >= 0)
+    {
+        close(m_proc_fd);
+        m_proc_fd = -1;
+    }
+}
+
+PidfdExitWatcher::Verdict PidfdExitWatcher::Classify(uint32_t name_id, const char *process_name)
+{
+    // Events without a name ID can't be cached, and nothing watches an empty name
+    if (name_id == 0)
+        return kIgnored;
+
+    if (name_id >= m_verdicts.size())
+        m_verdicts.resize(name_id + 1 + name_id / 2, kUnknown);
+
+    uint8_t &verdict = m_verdicts[name_id];
+    if (verdict == kUnknown)
+    {
+        if (!m_watch_list.Matches(process_name))
+            verdict = kIgnored;
+        else if (m_watch_list.RequiresPath(process_name))
+            verdict = kNeedsPath;
+        else
+            verdict = kWatched;
+    }
+    return (Verdict)verdict;
+}
+
+bool PidfdExitWatcher::IsWatched(int pid, long long start_time_ms, uint32_t name_id, const char *process_name)
+{
+    Verdict verdict;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        verdict = Classify(name_id, process_name);
+    }
+
+    // The same path rule as ProcessFilter, resolved outside the lock
+    return verdict == kWatched || (verdict == kNeedsPath && m_watch_list.MatchesPath(process_name, lookup_process_exe_path(pid, start_time_ms)));
+}
+
+std::unordered_map<ProcessKey, PidfdExitWatcher::WatchedProcess>::iterator PidfdExitWatcher::FindWatched(ProcessKey key)
+{
+    auto found = m_watched.find(key);
+    if (found != m_watched.end())
+        return found;
+
+    // Only processes of watched names get here, so there are few entries to go through
+    for (auto it = m_watched.begin(); it != m_watched.end(); ++it)
+    {
+        if (process_keys_match(it->first, key))
+            return it;
+    }
+    return m_watched.end();
+}
+
+std::unordered_set<ProcessKey>::iterator PidfdExitWatcher::FindReported(ProcessKey key)
+{
+    auto found = m_reported.find(key);
+    if (found != m_reported.end())
+        return found;
+
+    for (auto it = m_reported.begin(); it != m_reported.end(); ++it)
+    {
+        if (process_keys_match(*it, key))
+            return it;
+    }
+    return m_reported.end();
+}
+
+bool PidfdExitWatcher::IsSameProcess(int pid, const ProcessInfo &info)
+{
+    if (info.start_time_ms == 0)
+        return true;
+
+    // Unreadable means the process behind the pidfd has exited already, which its pidfd reports
+    ProcStat stat;
+    if (!read_proc_stat(m_proc_fd, pid, &stat))
+        return true;
+    return proc_start_time_ms(stat.start_time) == info.start_time_ms;
+}
+
+void PidfdExitWatcher::Watch(int pid, const ProcessInfo &info)
+{
+    // Opened and checked before taking the lock, which the exit thread and OwnsExit() wait on.
+    // The PID may have been reused since the start event, in which case the process it named is gone.
+    int pidfd = pidfd_open(pid);
+    if (pidfd >= 0 && !IsSameProcess(pid, info))
+    {
+        close(pidfd);
+        pidfd = -1;
+        errno = ESRCH;
+    }
+    if (pidfd < 0)
+    {
+        // The process exited before we got a pidfd for it. Anything else (out of descriptors or
+        // similar) leaves this exit to the event source.
+        if (errno == ESRCH)
+            ReportExit(pid, info);
+        return;
+    }
+
+    ProcessKey key = make_process_key(pid, info.start_time_ms);
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_watched.count(key) == 0)
+    {
+        epoll_event event = {};
+        event.events = EPOLLIN;
+        event.data.u64 = key;
+        if (epoll_ctl(m_epoll_fd, EPOLL_CTL_ADD, pidfd, &event) == 0)
+        {
+            m_watched[key] = {pidfd, info};
+            return;
+        }
+    }
+    // Watched already, or not watched at all so the event source reports this exit
+    close(pidfd);
+}
+
+void PidfdExitWatcher::ReportExit(int pid, const ProcessInfo &info)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        // A process watched twice (from the snapshot and its start) is reported once
+        ProcessKey key = make_process_key(pid, info.start_time_ms);
+        if (!m_reported.insert(key).second)
+            return;
+        m_reported_order.push_back(key);
+
+        // Forget the oldest ones whose stop the event source is never going to send
+        while (m_reported_order.size() > kMaxReportedExits)
+        {
+            m_reported.erase(m_reported_order.front());
+            m_reported_order.pop_front();
+        }
+    }
+
+    CompactProcessEvent event = {};
+    event.event_type = PROCESS_EVENT_STOP;
+    event.process_id = pid;
+    event.parent_process_id = info.parent_pid;
+    event.name_id = info.name_id;
+    event.start_time_ms = info.start_time_ms;
+    event.timestamp_ms = event_timestamp_ms();
+    m_on_exit(event);
+}
+
+void PidfdExitWatcher::ThreadMain()
+{
+    epoll_event events[kMaxEventsPerWait];
+
+    while (m_running)
+    {
+        int count = epoll_wait(m_epoll_fd, events, kMaxEventsPerWait, -1);
+        if (count < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            break;
+        }
+
+        for (int i = 0; i < count; i++)
+        {
+            if (events[i].data.u64 == kWakeTag)
+                continue;
+
+            ProcessKey key = events[i].data.u64;
+            ProcessInfo info;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                auto watched = m_watched.find(key);
+                if (watched == m_watched.end())
+                    continue;
+
+                // Closing the only reference also removes it from the epoll set
+                close(watched->second.pidfd);
+                info = watched->second.info;
+                m_watched.erase(watched);
+            }
+
+            ReportExit(process_key_pid(key), info);
+        }
+    }
+}
+
+ExitWatcher *create_exit_watcher(const WatchList &watch_list, ExitWatcherCallback on_exit)
+{
+    return new PidfdExitWatcher(watch_list, on_exit);
+}
@@ -0,0 +1,87 @@
+#ifndef PIDFD_EXIT_WATCHER_H_
+#define PIDFD_EXIT_WATCHER_H_
+
+#include "exit_watcher.h"
+
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// Linux exit watcher: one pidfd per watched process, all waited on by a single epoll set.
+// A pidfd turns readable when its process exits, so the stop event is pushed by the kernel
+// instead of waiting for the next scan or for the global exit stream. Needs Linux 5.3+.
+class PidfdExitWatcher : public ExitWatcher
+{
+public:
+    PidfdExitWatcher(const WatchList &watch_list, ExitWatcherCallback on_exit);
+    ~PidfdExitWatcher() override;
+
+    bool Start() override;
+    void WatchRunningProcesses(const std::vector<RunningProcess> &running) override;
+    void Track(const CompactProcessEvent &start, const char *process_name) override;
+    bool OwnsExit(const CompactProcessEvent &stop, const char *process_name) override;
+    void Stop() override;
+
+private:
+    enum Verdict : uint8_t
+    {
+        kUnknown = 0,
+        kIgnored,
+        kWatched,
+        kNeedsPath,
+    };
+
+    // What the stop event needs to carry
+    struct ProcessInfo
+    {
+        uint32_t name_id = 0;
+        int parent_pid = 0;
+        long long start_time_ms = 0;
+    };
+
+    struct WatchedProcess
+    {
+        int pidfd;
+        ProcessInfo info;
+    };
+
+    WatchList m_watch_list;
+    ExitWatcherCallback m_on_exit;
+
+    int m_epoll_fd = -1;
+    int m_wake_fd = -1; // eventfd that interrupts epoll_wait on Stop()
+    int m_proc_fd = -1;
+    std::thread m_thread;
+    std::atomic<bool> m_running{false};
+
+    // Keyed by PID and start time, so a process that reuses a watched PID before the old
+    // process's exit has been handled is still watched and reported on its own
+    std::mutex m_mutex;
+    std::unordered_map<ProcessKey, WatchedProcess> m_watched;
+    std::vector<uint8_t> m_verdicts; // Indexed by name ID, like ProcessFilter's
+
+    // Exits already reported, until the event source's stop for them arrives (oldest first, bounded
+    // for stops the source never sends)
+    std::unordered_set<ProcessKey> m_reported;
+    std::deque<ProcessKey> m_reported_order;
+
+    Verdict Classify(uint32_t name_id, const char *process_name);
+    bool IsWatched(int pid, long long start_time_ms, uint32_t name_id, const char *process_name);
+    void Watch(int pid, const ProcessInfo &info);
+
+    // Find `key` in m_watched or m_reported, also where either side's start time is unknown
+    std::unordered_map<ProcessKey, WatchedProcess>::iterator FindWatched(ProcessKey key);
+    std::unordered_set<ProcessKey>::iterator FindReported(ProcessKey key);
+
+    // Whether the process now at `pid` started when `info` says (true if either is unknown)
+    bool IsSameProcess(int pid, const ProcessInfo &info);
+    void ReportExit(int pid, const ProcessInfo &info);
+    void ThreadMain();
+};
+
+#endif // PIDFD_EXIT_WATCHER_H_
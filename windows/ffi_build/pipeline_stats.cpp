@@ -0,0 +1,119 @@
+#include "pipeline_stats.h"
+
+#include <cmath>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+// Number of the highest set bit of a nonzero value
+static int highest_bit(uint64_t value)
+{
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanReverse64(&index, value);
+    return (int)index;
+#else
+    return 63 - __builtin_clzll(value);
+#endif
+}
+
+int PipelineStats::LatencyBucket(long long latency_ns)
+{
+    if (latency_ns < 4)
+        return latency_ns < 0 ? 0 : (int)latency_ns;
+
+    int bit = highest_bit((uint64_t)latency_ns);
+    int sub_bucket = (int)(((uint64_t)latency_ns >> (bit - 2)) & 3);
+    int bucket = (bit - 1) * 4 + sub_bucket;
+    return bucket < MONITOR_LATENCY_BUCKETS ? bucket : MONITOR_LATENCY_BUCKETS - 1;
+}
+
+long long PipelineStats::BucketFloor(int bucket)
+{
+    if (bucket < 4)
+        return bucket < 0 ? 0 : bucket;
+
+    int bit = bucket / 4 + 1;
+    return (long long)(4 + bucket % 4) << (bit - 2);
+}
+
+PipelineStats::Shard &PipelineStats::LocalShard()
+{
+    static std::atomic<size_t> next_shard{0};
+    thread_local size_t shard = next_shard.fetch_add(1, std::memory_order_relaxed) % kShards;
+    return m_shards[shard];
+}
+
+void PipelineStats::Read(MonitorStats *stats) const
+{
+    long long *counters[] = {&stats->ingested, &stats->filtered, &stats->deduplicated, &stats->dropped, &stats->delivered};
+    static_assert(sizeof(counters) / sizeof(counters[0]) == (size_t)PipelineCounter::kCount, "Every counter needs a field");
+
+    for (size_t counter = 0; counter < (size_t)PipelineCounter::kCount; counter++)
+    {
+        uint64_t total = 0;
+        for (const Shard &shard : m_shards)
+            total += shard.counters[counter].load(std::memory_order_relaxed);
+        *counters[counter] = (long long)total;
+    }
+    stats->queue_high_water_mark = (long long)m_queue_high_water.load(std::memory_order_relaxed);
+
+    ReadHistogram(PipelineLatency::kKernelToIngest, &stats->kernel_to_ingest);
+    ReadHistogram(PipelineLatency::kIngestToDequeue, &stats->ingest_to_dequeue);
+}
+
+void PipelineStats::ReadHistogram(PipelineLatency latency, LatencyHistogram *histogram) const
+{
+    uint64_t count = 0;
+    uint64_t sum_ns = 0;
+    uint64_t max_ns = 0;
+    for (int bucket = 0; bucket < MONITOR_LATENCY_BUCKETS; bucket++)
+    {
+        uint64_t total = 0;
+        for (const Shard &shard : m_shards)
+            total += shard.histograms[(size_t)latency].buckets[bucket].load(std::memory_order_relaxed);
+        histogram->buckets[bucket] = (long long)total;
+        count += total;
+    }
+    for (const Shard &shard : m_shards)
+    {
+        const Histogram &local = shard.histograms[(size_t)latency];
+        sum_ns += local.sum_ns.load(std::memory_order_relaxed);
+        uint64_t local_max = local.max_ns.load(std::memory_order_relaxed);
+        if (local_max > max_ns)
+            max_ns = local_max;
+    }
+
+    histogram->count = (long long)count;
+    histogram->sum_ns = (long long)sum_ns;
+    histogram->max_ns = (long long)max_ns;
+
+    // A percentile is reported as the top of the bucket it falls in, so it errs high by at most a bucket
+    struct
+    {
+        double quantile;
+        long long *value_ns;
+    } percentiles[] = {{0.5, &histogram->p50_ns}, {0.9, &histogram->p90_ns}, {0.99, &histogram->p99_ns}, {0.999, &histogram->p999_ns}};
+    for (auto &percentile : percentiles)
+    {
+        *percentile.value_ns = 0;
+        if (count == 0)
+            continue;
+
+        uint64_t rank = (uint64_t)std::ceil(percentile.quantile * (double)count);
+        if (rank < 1)
+            rank = 1;
+        uint64_t seen = 0;
+        for (int bucket = 0; bucket < MONITOR_LATENCY_BUCKETS; bucket++)
+        {
+            seen += (uint64_t)histogram->buckets[bucket];
+            if (seen >= rank)
+            {
+                long long top = BucketFloor(bucket + 1) - 1;
+                *percentile.value_ns = top < (long long)max_ns ? top : (long long)max_ns;
+                break;
+            }
+        }
+    }
+}
@@ -0,0 +1,108 @@
+#ifndef PIPELINE_STATS_H_
+#define PIPELINE_STATS_H_
+
+#include "process_monitor_api.h"
+#include "event_ring.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Counters kept for get_monitor_stats
+enum class PipelineCounter
+{
+    kIngested,     // Events received from the event sources
+    kFiltered,     // Events a context kept out of its raw stream
+    kDeduplicated, // Events dropped as repeats
+    kDropped,      // Records discarded by a full queue or lost by a subscriber
+    kDelivered,    // Records read by a consumer or handed to its callback
+    kCount
+};
+
+// Latencies kept for get_monitor_stats
+enum class PipelineLatency
+{
+    kKernelToIngest,
+    kIngestToDequeue,
+    kCount
+};
+
+// Counters and latency histograms of the whole event pipeline, for the library's lifetime.
+//
+// Every thread updates a shard of its own (threads are spread round-robin over a fixed set of
+// cache-line aligned shards), so the ingest thread never shares a cache line with a consumer
+// and an update is one uncontended relaxed add. Read() sums the shards, so it is the only
+// part that costs anything and may see a count a moment before the matching one.
+class PipelineStats
+{
+public:
+    PipelineStats() = default;
+
+    PipelineStats(const PipelineStats &) = delete;
+    PipelineStats &operator=(const PipelineStats &) = delete;
+
+    void Add(PipelineCounter counter, uint64_t count = 1)
+    {
+        LocalShard().counters[(size_t)counter].fetch_add(count, std::memory_order_relaxed);
+    }
+
+    // Negative latencies (clock readings from before a source's own timestamp) count as 0
+    void RecordLatency(PipelineLatency latency, long long latency_ns)
+    {
+        if (latency_ns < 0)
+            latency_ns = 0;
+
+        Histogram &histogram = LocalShard().histograms[(size_t)latency];
+        histogram.buckets[LatencyBucket(latency_ns)].fetch_add(1, std::memory_order_relaxed);
+        histogram.sum_ns.fetch_add((uint64_t)latency_ns, std::memory_order_relaxed);
+        uint64_t max_ns = histogram.max_ns.load(std::memory_order_relaxed);
+        while ((uint64_t)latency_ns > max_ns && !histogram.max_ns.compare_exchange_weak(max_ns, (uint64_t)latency_ns, std::memory_order_relaxed))
+        {
+        }
+    }
+
+    // Records the depth of a queue if it is the deepest seen so far
+    void RaiseQueueHighWater(uint64_t depth)
+    {
+        uint64_t current = m_queue_high_water.load(std::memory_order_relaxed);
+        while (depth > current && !m_queue_high_water.compare_exchange_weak(current, depth, std::memory_order_relaxed))
+        {
+        }
+    }
+
+    void Read(MonitorStats *stats) const;
+
+    // Bucket of a latency: exact below 8 ns, then 4 buckets per power of two (each within 25%
+    // of the values it holds) up to 2^41 ns (about 37 minutes); the last bucket also holds anything longer
+    static int LatencyBucket(long long latency_ns);
+
+    // Smallest latency counted in `bucket`; MONITOR_LATENCY_BUCKETS gives the end of the last one
+    static long long BucketFloor(int bucket);
+
+private:
+    static constexpr size_t kShards = 16;
+
+    struct Histogram
+    {
+        std::atomic<uint64_t> buckets[MONITOR_LATENCY_BUCKETS]{};
+        std::atomic<uint64_t> sum_ns{0};
+        std::atomic<uint64_t> max_ns{0};
+    };
+
+    struct alignas(kCacheLineSize) Shard
+    {
+        std::atomic<uint64_t> counters[(size_t)PipelineCounter::kCount]{};
+        Histogram histograms[(size_t)PipelineLatency::kCount];
+    };
+
+    Shard m_shards[kShards];
+    alignas(kCacheLineSize) std::atomic<uint64_t> m_queue_high_water{0};
+
+    Shard &LocalShard();
+    void ReadHistogram(PipelineLatency latency, LatencyHistogram *histogram) const;
+};
+
+// The library's pipeline counters, updated wherever events pass a stage
+PipelineStats &pipeline_stats();
+
+#endif // PIPELINE_STATS_H_
@@ -0,0 +1,174 @@
+#include "proc_scan_event_source.h"
+#include "process_details.h"
+#include "procfs.h"
+
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+ProcScanEventSource::ProcScanEventSource(int interval_ms)
+    : m_interval_ms(interval_ms > 0 ? interval_ms : 1000)
+{
+}
+
+ProcScanEventSource::~ProcScanEventSource()
+{
+    Cleanup();
+}
+
+bool ProcScanEventSource::Initialize()
+{
+    m_proc_fd = open_proc_dir();
+    if (m_proc_fd < 0)
+    {
+        set_last_error("Failed to open /proc: " + std::string(strerror(errno)));
+        return false;
+    }
+
+    // Baseline: processes already running are not reported, so only their PIDs are listed.
+    // The process table, loaded from its own snapshot, fills in their stop events.
+    int syscall_count = 0;
+    if (!list_proc_pids(m_proc_fd, &m_dirents, &m_pids, &syscall_count))
+    {
+        set_last_error("Failed to list /proc: " + std::string(strerror(errno)));
+        return false;
+    }
+    return true;
+}
+
+void ProcScanEventSource::Run(const std::atomic<bool> &running, EventSignal &stop_signal)
+{
+    auto next_scan = std::chrono::steady_clock::now() + std::chrono::milliseconds(m_interval_ms);
+
+    while (running)
+    {
+        auto now = std::chrono::steady_clock::now();
+        if (now < next_scan)
+        {
+            // Rounded up so the scan isn't attempted a moment early and followed by a zero wait
+            auto remaining = std::chrono::ceil<std::chrono::milliseconds>(next_scan - now);
+            stop_signal.Wait((int)remaining.count());
+            continue;
+        }
+
+        Scan();
+        flush_process_events();
+        next_scan += std::chrono::milliseconds(m_interval_ms);
+
+        // Don't try to catch up after a stall, just keep the cadence from here
+        if (next_scan < std::chrono::steady_clock::now())
+            next_scan = std::chrono::steady_clock::now() + std::chrono::milliseconds(m_interval_ms);
+    }
+}
+
+void ProcScanEventSource::Cleanup()
+{
+    if (m_proc_fd >= 0)
+    {
+        close(m_proc_fd);
+        m_proc_fd = -1;
+    }
+}
+
+void ProcScanEventSource::Scan()
+{
+    auto scan_start = std::chrono::steady_clock::now();
+
+    ProcScanStats stats = {};
+    if (!list_proc_pids(m_proc_fd, &m_dirents, &m_next_pids, &stats.syscall_count))
+        return;
+
+    long long timestamp_ms = event_timestamp_ms();
+
+    // Merge walk over the two sorted arrays: PIDs only in the old one exited,
+    // PIDs only in the new one started
+    size_t old_index = 0;
+    size_t new_index = 0;
+    while (old_index < m_pids.size() || new_index < m_next_pids.size())
+    {
+        bool exited;
+        if (new_index == m_next_pids.size())
+            exited = true;
+        else if (old_index == m_pids.size())
+            exited = false;
+        else if (m_pids[old_index] == m_next_pids[new_index])
+        {
+            old_index++;
+            new_index++;
+            continue;
+        }
+        else
+            exited = m_pids[old_index] < m_next_pids[new_index];
+
+        CompactProcessEvent event = {};
+        event.timestamp_ms = timestamp_ms;
+
+        if (exited)
+        {
+            int pid = m_pids[old_index++];
+            stats.exited_count++;
+
+            auto known = m_processes.find(pid);
+            if (known != m_processes.end())
+            {
+                event.name_id = known->second.name_id;
+                event.parent_process_id = known->second.parent_pid;
+                event.start_time_ms = known->second.start_time_ms;
+                m_processes.erase(known);
+            }
+            else
+            {
+                // Running before the first scan
+                ProcessSnapshotEntry process;
+                if (find_known_process(pid, &process))
+                {
+                    event.name_id = process.name_id;
+                    event.parent_process_id = process.parent_process_id;
+                    event.start_time_ms = process.start_time_ms;
+                }
+            }
+
+            event.event_type = PROCESS_EVENT_STOP;
+            event.process_id = pid;
+        }
+        else
+        {
+            int pid = m_next_pids[new_index++];
+            stats.started_count++;
+
+            // Only new PIDs cost syscalls: stat for comm and parent, readlink for the executable name
+            ProcStat stat;
+            bool have_stat = read_proc_stat(m_proc_fd, pid, &stat, &stats.syscall_count);
+            std::string exe_path = read_process_exe_path(m_proc_fd, pid, &stats.syscall_count);
+            uint32_t name_id = intern_process_name(!exe_path.empty() ? exe_file_name(exe_path) : have_stat ? stat.comm : std::string());
+
+            event.event_type = PROCESS_EVENT_START;
+            event.process_id = pid;
+            event.parent_process_id = have_stat ? stat.ppid : 0;
+            event.start_time_ms = have_stat ? proc_start_time_ms(stat.start_time) : 0;
+            event.name_id = name_id;
+            m_processes[pid] = {name_id, event.parent_process_id, event.start_time_ms};
+
+            // Kept for get_process_details, since the path was read anyway
+            if (!exe_path.empty())
+            {
+                ProcessDetailsRecord details;
+                details.fields = PROCESS_DETAIL_EXE_PATH;
+                details.exe_path = std::move(exe_path);
+                record_process_details(pid, event.start_time_ms, details);
+            }
+        }
+
+        publish_process_event(event);
+    }
+
+    m_pids.swap(m_next_pids);
+
+    stats.scan_count = ++m_scan_count;
+    stats.process_count = (int)m_pids.size();
+    stats.duration_us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - scan_start).count();
+    publish_proc_scan_stats(stats);
+}
@@ -0,0 +1,57 @@
+#ifndef PROC_SCAN_EVENT_SOURCE_H_
+#define PROC_SCAN_EVENT_SOURCE_H_
+
+#include "event_source.h"
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// Unprivileged Linux event source that rescans /proc on an interval.
+// Used when the proc connector is unavailable (no CAP_NET_ADMIN, locked-down containers).
+//
+// Each scan lists /proc with getdents64 on a directory fd kept open for the whole session
+// and diffs the sorted PID array against the previous scan. Only PIDs that appeared are
+// looked at any further, so the per-scan syscall count is a handful of getdents64 calls
+// plus a constant per started process, independent of how many processes are running.
+//
+// The baseline at startup is a PID listing only; stops of processes that were already running
+// are filled in from the process table. Processes that start and exit between two scans are
+// not seen, and a PID that is reused between two scans is not reported.
+class ProcScanEventSource : public EventSource
+{
+public:
+    explicit ProcScanEventSource(int interval_ms);
+    ~ProcScanEventSource() override;
+
+    bool Initialize() override;
+    void Run(const std::atomic<bool> &running, EventSignal &stop_signal) override;
+    void Cleanup() override;
+    ProcessEventSourceType Type() const override { return PROCESS_EVENT_SOURCE_PROC_SCAN; }
+
+private:
+    int m_interval_ms;
+    int m_proc_fd = -1;
+    long long m_scan_count = 0;
+
+    // getdents64 output, sized from the previous scan so a listing usually takes one call
+    std::vector<char> m_dirents;
+
+    // Sorted PIDs of the previous scan and the one being built
+    std::vector<int> m_pids;
+    std::vector<int> m_next_pids;
+
+    struct KnownProcess
+    {
+        uint32_t name_id = 0;
+        int parent_pid = 0;
+        long long start_time_ms = 0;
+    };
+
+    // Names and parents of processes started since the baseline, needed to fill in "stop" events
+    std::unordered_map<int, KnownProcess> m_processes;
+
+    void Scan();
+};
+
+#endif // PROC_SCAN_EVENT_SOURCE_H_
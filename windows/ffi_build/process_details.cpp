@@ -0,0 +1,126 @@
+#include "process_details.h"
+#include "process_monitor_api.h"
+
+#include <cstdint>
+
+size_t ProcessDetailsCache::KeyHash::operator()(const Key &key) const
+{
+    uint64_t hash = (uint64_t)key.start_time_ms * 0x9E3779B97F4A7C15ULL ^ (uint32_t)key.pid;
+    hash ^= hash >> 33;
+    return (size_t)hash;
+}
+
+ProcessDetailsCache::ProcessDetailsCache(size_t capacity) : m_capacity(capacity > 0 ? capacity : 1)
+{
+}
+
+void ProcessDetailsCache::Record(int pid, long long start_time_ms, const ProcessDetailsRecord &captured)
+{
+    if (start_time_ms == 0)
+        return;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Merge(FindOrAdd({pid, start_time_ms}), captured);
+}
+
+bool ProcessDetailsCache::Get(int pid, long long start_time_ms, int fields, ProcessDetailsRecord *details)
+{
+    fields &= ~PROCESS_DETAIL_START_TIME; // Part of the key
+    ProcessDetailsRecord live;
+
+    // Only the system knows which process has the PID now, so it is asked every time
+    if (start_time_ms == 0)
+    {
+        if (!query_process_details(pid, 0, fields, &live) || live.start_time_ms == 0)
+            return false;
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        Entry &entry = FindOrAdd({pid, live.start_time_ms});
+        Merge(entry, live);
+        entry.attempted |= fields;
+        *details = entry.details;
+        return true;
+    }
+
+    Key key = {pid, start_time_ms};
+    int missing = fields;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (Entry *entry = Find(key))
+        {
+            missing &= ~(entry->attempted | entry->details.fields);
+            if (missing == 0)
+            {
+                *details = entry->details;
+                return true;
+            }
+        }
+    }
+
+    // Asked without the lock held; the query itself checks the PID still belongs to this process
+    bool running = query_process_details(pid, start_time_ms, missing, &live);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Entry *entry = Find(key);
+    if (entry == nullptr)
+    {
+        if (!running)
+            return false;
+        entry = &FindOrAdd(key);
+    }
+    if (running)
+        Merge(*entry, live);
+
+    // Once the process is gone nothing more can be learned about it
+    entry->attempted |= missing;
+    *details = entry->details;
+    return true;
+}
+
+void ProcessDetailsCache::Clear()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_index.clear();
+    m_entries.clear();
+}
+
+ProcessDetailsCache::Entry *ProcessDetailsCache::Find(const Key &key)
+{
+    auto found = m_index.find(key);
+    if (found == m_index.end())
+        return nullptr;
+
+    m_entries.splice(m_entries.begin(), m_entries, found->second);
+    return &*found->second;
+}
+
+ProcessDetailsCache::Entry &ProcessDetailsCache::FindOrAdd(const Key &key)
+{
+    if (Entry *entry = Find(key))
+        return *entry;
+
+    if (m_index.size() >= m_capacity)
+    {
+        m_index.erase(m_entries.back().key);
+        m_entries.pop_back();
+    }
+
+    m_entries.emplace_front();
+    Entry &entry = m_entries.front();
+    entry.key = key;
+    entry.details.fields = PROCESS_DETAIL_START_TIME;
+    entry.details.start_time_ms = key.start_time_ms;
+    m_index[key] = m_entries.begin();
+    return entry;
+}
+
+void ProcessDetailsCache::Merge(Entry &entry, const ProcessDetailsRecord &details)
+{
+    if (details.fields & PROCESS_DETAIL_EXE_PATH)
+        entry.details.exe_path = details.exe_path;
+    if (details.fields & PROCESS_DETAIL_COMMAND_LINE)
+        entry.details.command_line = details.command_line;
+    if (details.fields & PROCESS_DETAIL_USER_ID)
+        entry.details.user_id = details.user_id;
+    entry.details.fields |= details.fields & (PROCESS_DETAIL_EXE_PATH | PROCESS_DETAIL_COMMAND_LINE | PROCESS_DETAIL_USER_ID);
+}
@@ -0,0 +1,77 @@
+#ifndef PROCESS_DETAILS_H_
+#define PROCESS_DETAILS_H_
+
+#include <cstddef>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+// Details of one process; `fields` holds the ProcessDetailField flags of the ones filled in
+struct ProcessDetailsRecord
+{
+    int fields = 0;
+    long long start_time_ms = 0;
+    long long user_id = -1;
+    std::string exe_path;
+    std::string command_line;
+};
+
+// Reads `fields` of the running process `pid`, provided it is still the process that started at
+// `start_time_ms` (0 accepts whichever process has the PID, and fills in its start time).
+// Returns false if the process is gone or has been replaced; otherwise sets details->fields to
+// the fields that could be read. Implemented once per platform.
+bool query_process_details(int pid, long long start_time_ms, int fields, ProcessDetailsRecord *details);
+
+// Process details fetched on demand and cached per (PID, start time), so only the first lookup of
+// a field costs syscalls and a field that can't be read isn't retried. Event sources add what they
+// capture anyway while a process runs (its executable at exec, say), which keeps answering after
+// the process has exited. The least recently used entry goes once `capacity` are held.
+class ProcessDetailsCache
+{
+public:
+    explicit ProcessDetailsCache(size_t capacity);
+
+    ProcessDetailsCache(const ProcessDetailsCache &) = delete;
+    ProcessDetailsCache &operator=(const ProcessDetailsCache &) = delete;
+
+    // Merges fields captured by an event source; `start_time_ms` must be known
+    void Record(int pid, long long start_time_ms, const ProcessDetailsRecord &captured);
+
+    // Fills `fields` of `details` where known. A `start_time_ms` of 0 means the process running
+    // under `pid` now. Returns false if the process is neither cached nor running.
+    bool Get(int pid, long long start_time_ms, int fields, ProcessDetailsRecord *details);
+
+    void Clear();
+
+private:
+    struct Key
+    {
+        int pid;
+        long long start_time_ms;
+        bool operator==(const Key &other) const { return pid == other.pid && start_time_ms == other.start_time_ms; }
+    };
+
+    struct KeyHash
+    {
+        size_t operator()(const Key &key) const;
+    };
+
+    struct Entry
+    {
+        Key key;
+        ProcessDetailsRecord details;
+        int attempted = 0; // Fields asked of the system, whether or not they could be read
+    };
+
+    size_t m_capacity;
+    std::mutex m_mutex;
+    std::list<Entry> m_entries; // Most recently used first
+    std::unordered_map<Key, std::list<Entry>::iterator, KeyHash> m_index;
+
+    Entry &FindOrAdd(const Key &key);
+    Entry *Find(const Key &key);
+    static void Merge(Entry &entry, const ProcessDetailsRecord &details);
+};
+
+#endif // PROCESS_DETAILS_H_
@@ -0,0 +1,69 @@
+#include "process_filter.h"
+#include "event_source.h"
+#include "process_key.h"
+
+ProcessFilter::ProcessFilter(const WatchList &watch_list)
+    : m_watch_list(watch_list)
+{
+}
+
+bool ProcessFilter::AcceptStart(ProcessKey key, long long start_time_ms, uint32_t name_id, const char *process_name)
+{
+    int pid = process_key_pid(key);
+    Verdict verdict;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        verdict = Classify(name_id, process_name);
+    }
+
+    // Resolved through the details cache like the instance trackers do, and outside the lock
+    // since it may read the path from the system
+    bool accepted = verdict == kAccepted || (verdict == kNeedsPath && m_watch_list.MatchesPath(process_name, lookup_process_exe_path(pid, start_time_ms)));
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!accepted)
+    {
+        // The PID may have been reused since a delivered start whose stop was missed
+        m_started.erase(pid);
+        return false;
+    }
+
+    m_started[pid] = key;
+    return true;
+}
+
+bool ProcessFilter::AcceptStop(ProcessKey key, uint32_t name_id, const char *process_name)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto started = m_started.find(process_key_pid(key));
+    if (started != m_started.end() && process_keys_match(started->second, key))
+    {
+        m_started.erase(started);
+        return true;
+    }
+
+    // The executable is gone by now, so a path-narrowed name can't be checked
+    return Classify(name_id, process_name) == kAccepted;
+}
+
+ProcessFilter::Verdict ProcessFilter::Classify(uint32_t name_id, const char *process_name)
+{
+    // Events without a name ID can't be cached, and nothing watches an empty name
+    if (name_id == 0)
+        return kRejected;
+
+    if (name_id >= m_verdicts.size())
+        m_verdicts.resize(name_id + 1 + name_id / 2, kUnknown);
+
+    uint8_t &verdict = m_verdicts[name_id];
+    if (verdict == kUnknown)
+    {
+        if (!m_watch_list.Matches(process_name))
+            verdict = kRejected;
+        else if (m_watch_list.RequiresPath(process_name))
+            verdict = kNeedsPath;
+        else
+            verdict = kAccepted;
+    }
+    return (Verdict)verdict;
+}
@@ -0,0 +1,52 @@
+#ifndef PROCESS_FILTER_H_
+#define PROCESS_FILTER_H_
+
+#include "process_monitor_api.h"
+#include "watch_list.h"
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Decides which events reach the consumer when a watch set is registered, so events for
+// unwatched processes are dropped before they are queued.
+//
+// The verdict for a name is computed once per name ID and cached, so a repeat sighting costs
+// an array lookup instead of a lowercased string compare. Names narrowed to executable paths
+// cost one path query per started process with that name.
+//
+// A stop event is delivered if its start was, or if its name is watched from any path
+// (which covers processes that were already running when monitoring started).
+// Called from the ingest thread and the exit watcher thread.
+class ProcessFilter
+{
+public:
+    explicit ProcessFilter(const WatchList &watch_list);
+
+    // `start_time_ms` identifies the process when a path-narrowed name needs its executable looked up
+    bool AcceptStart(ProcessKey key, long long start_time_ms, uint32_t name_id, const char *process_name);
+    bool AcceptStop(ProcessKey key, uint32_t name_id, const char *process_name);
+
+    const WatchList &Watching() const { return m_watch_list; }
+
+private:
+    enum Verdict : uint8_t
+    {
+        kUnknown = 0,
+        kRejected,
+        kAccepted,
+        kNeedsPath,
+    };
+
+    WatchList m_watch_list;
+
+    std::mutex m_mutex;
+    std::vector<uint8_t> m_verdicts;     // Indexed by name ID
+    std::unordered_map<int, ProcessKey> m_started; // PID -> process whose start was delivered
+
+    Verdict Classify(uint32_t name_id, const char *process_name);
+};
+
+#endif // PROCESS_FILTER_H_
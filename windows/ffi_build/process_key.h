@@ -0,0 +1,28 @@
+#ifndef PROCESS_KEY_H_
+#define PROCESS_KEY_H_
+
+#include "process_monitor_api.h"
+
+#include <cstdint>
+
+// Helpers for ProcessKey. Structures that outlive a single event key processes this way, so a
+// missed stop followed by the PID's reuse can't make a new process pass for the old one.
+
+inline ProcessKey process_key(const CompactProcessEvent &event)
+{
+    return make_process_key(event.process_id, event.start_time_ms);
+}
+
+inline int process_key_pid(ProcessKey key)
+{
+    return (int)(uint32_t)key;
+}
+
+// Whether two keys may name the same process: the same PID, and the same start time unless
+// either is unknown (a process listed without one, or an event the source couldn't date)
+inline bool process_keys_match(ProcessKey a, ProcessKey b)
+{
+    return a == b || ((uint32_t)a == (uint32_t)b && ((a >> 32) == 0 || (b >> 32) == 0));
+}
+
+#endif // PROCESS_KEY_H_
@@ -1,474 +1,1803 @@
 #include "process_monitor_api.h"
+#include "broadcast_ring.h"
+#include "event_dedup.h"
+#include "event_journal.h"
+#include "event_signal.h"
+#include "event_ring.h"
+#include "event_source.h"
+#include "exit_watcher.h"
+#include "monitor_context.h"
+#include "name_table.h"
+#include "pipeline_stats.h"
+#include "process_details.h"
+#include "process_filter.h"
+#include "process_key.h"
+#include "process_snapshot.h"
+#include "process_table.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
 #include <string>
 #include <thread>
 #include <atomic>
+#include <condition_variable>
+#include <memory>
 #include <mutex>
-#include <queue>
+#include <vector>
 #include <chrono>
 
-#define _WIN32_DCOM
-#include <Wbemidl.h>
-#include <windows.h>
-#include <comdef.h>
+// Global state for FFI
+static std::string g_last_error; // Guarded by g_last_error_mutex, read through copies
+static std::mutex g_last_error_mutex;
+
+// Where set_last_error writes on the monitor and journal threads, whose failures are reported
+// to their consumers rather than to whichever API call reads get_last_error
+static thread_local std::string* t_error_sink = nullptr;
+static std::atomic<bool> g_monitoring = false; // The shared backend is running
+static std::atomic<bool> g_monitor_thread_running = false;
+static std::thread g_monitor_thread;
+
+// Set with every stop request so an idle event source wakes up to it. Never closed, since a
+// monitor thread that could not be joined may still be waiting on it.
+static EventSignal g_source_stop_signal;
+
+// Set once the backend is listening and has loaded the process table and seeded the instance
+// trackers. Changes to it and to g_monitor_thread_running are announced on g_backend_state_cond.
+static std::atomic<bool> g_backend_ready = false;
+static std::mutex g_backend_state_mutex;
+static std::condition_variable g_backend_state_cond;
+
+static constexpr size_t kDefaultEventQueueCapacity = 1024;
+
+// Context behind the original single-consumer API. Events are queued as compact records with
+// their timings and only expanded to ProcessEventData when read that way.
+static std::shared_ptr<MonitorContext> g_default_context = std::make_shared<MonitorContext>(kDefaultEventQueueCapacity);
+
+// Contexts receiving events from the backend. Replaced as a whole (std::atomic_load/atomic_store)
+// under g_subscription_mutex, so the ingest threads read it without locking.
+typedef std::vector<std::shared_ptr<MonitorContext>> SubscriberList;
+static std::shared_ptr<const SubscriberList> g_subscribers;
+static std::mutex g_subscription_mutex;
+
+// Handle returned by pm_context_create
+struct pm_context
+{
+    std::shared_ptr<MonitorContext> context;
+};
+
+static constexpr size_t kBroadcastRingCapacity = 4096;
+
+// Ring read by every pm_subscriber. Created with the first subscriber and kept for the life of
+// the library, since the ingest threads publish to it without taking g_subscription_mutex.
+static std::atomic<BroadcastRing<TimedProcessEvent>*> g_broadcast_ring = nullptr;
+static int g_broadcast_subscriber_count = 0; // Guarded by g_subscription_mutex
+static std::atomic<bool> g_broadcasting = false;
+
+// Handle returned by pm_subscribe; read by one thread at a time
+struct pm_subscriber
+{
+    BroadcastCursor cursor;
+    long long read = 0;
+    long long lost = 0;
+};
+
+static constexpr long long kDefaultJournalSegmentSize = 16 * 1024 * 1024;
+static constexpr long long kMinJournalSegmentSize = 64 * 1024;
+static constexpr int kDefaultJournalCommitIntervalMs = 100;
+static constexpr int kJournalBatchSize = 1024;
+
+// Handle returned by pm_journal_open; the journal thread owns the writer until it exits
+struct pm_journal
+{
+    std::unique_ptr<JournalWriter> writer;
+    pm_subscriber_t* subscriber = nullptr;
+    int commit_interval_ms = kDefaultJournalCommitIntervalMs;
+    std::atomic<bool> running = true;
+    std::thread thread;
+    std::mutex error_mutex;
+    std::string last_error; // Of the journal thread, guarded by error_mutex
+};
+
+// Handle returned by pm_journal_reader_open
+struct pm_journal_reader
+{
+    JournalReader reader;
+
+    explicit pm_journal_reader(const std::string &directory) : reader(directory) {}
+};
+
+// Names referenced by CompactProcessEvent::name_id; never cleared so IDs stay valid
+static NameTable g_process_names;
+
+// Set while a consumer reads the default queue in place through map_event_ring
+static std::atomic<bool> g_event_ring_mapped = false;
+static RingOverflowPolicy g_unmapped_overflow_policy = RingOverflowPolicy::kOverwriteOldest;
+
+// The published header must match the ring's control block
+static_assert(sizeof(ProcessEventRingHeader) == sizeof(RingControl), "ProcessEventRingHeader size mismatch");
+static_assert(offsetof(ProcessEventRingHeader, slots_offset) == offsetof(RingControl, slots_offset), "ProcessEventRingHeader layout mismatch");
+static_assert(offsetof(ProcessEventRingHeader, write_index) == offsetof(RingControl, tail), "ProcessEventRingHeader layout mismatch");
+static_assert(offsetof(ProcessEventRingHeader, read_index) == offsetof(RingControl, head), "ProcessEventRingHeader layout mismatch");
+static_assert(sizeof(CompactProcessEvent) == 32, "CompactProcessEvent must stay 32 bytes");
+static_assert(sizeof(TimedProcessEvent) + sizeof(uint64_t) <= kCacheLineSize, "TimedProcessEvent must fit a ring cell with its sequence");
+
+// Platform event source owned by the monitor thread
+static EventSource* g_event_source = nullptr;
+static EventSourceOptions g_event_source_options;
+static std::atomic<int> g_active_event_source = -1;
+
+// Exact exit tracking for watched processes
+static WatchList g_exit_watch_list;
+static std::atomic<ExitWatcher*> g_exit_watcher = nullptr;
+
+// Drops repeated events before they reach any context
+static EventDeduplicator g_event_dedup;
+
+// Processes running while the backend is, for snapshot_processes and the point queries
+static ProcessTable g_process_table;
+
+static constexpr size_t kProcessDetailsCacheCapacity = 4096;
+
+// Details fetched by get_process_details or captured by the event sources; kept across
+// monitoring sessions since entries are keyed by PID and start time
+static ProcessDetailsCache g_process_details(kProcessDetailsCacheCapacity);
+
+// Counters and latency histograms reported by get_monitor_stats
+static PipelineStats g_pipeline_stats;
+
+// Cost of the latest /proc scan, when the scanning backend is active
+static ProcScanStats g_proc_scan_stats = {};
+static std::mutex g_proc_scan_stats_mutex;
+
+void set_last_error(const std::string &message)
+{
+    if (t_error_sink != nullptr)
+    {
+        *t_error_sink = message;
+        return;
+    }
+    std::lock_guard<std::mutex> lock(g_last_error_mutex);
+    g_last_error = message;
+}
+
+static void clear_last_error()
+{
+    std::lock_guard<std::mutex> lock(g_last_error_mutex);
+    g_last_error.clear();
+}
+
+static std::string copy_last_error()
+{
+    std::lock_guard<std::mutex> lock(g_last_error_mutex);
+    return g_last_error;
+}
+
+uint32_t intern_process_name(const std::string &name)
+{
+    return g_process_names.Intern(name);
+}
+
+uint32_t intern_process_name(const char *name, size_t length)
+{
+    return g_process_names.Intern(name, length);
+}
+
+#ifdef _WIN32
+uint32_t intern_process_name(const wchar_t *name, size_t length)
+{
+    return g_process_names.Intern(name, length);
+}
+#endif
+
+const char *lookup_process_name(uint32_t name_id)
+{
+    return g_process_names.Lookup(name_id);
+}
+
+bool is_known_process(int process_id, long long start_time_ms)
+{
+    return g_process_table.Contains(make_process_key(process_id, start_time_ms));
+}
+
+bool find_known_process(int process_id, ProcessSnapshotEntry *process)
+{
+    return g_process_table.Find(process_id, process);
+}
+
+bool is_descendant_process(int process_id, int root_process_id)
+{
+    return g_process_table.Tree().IsDescendant(process_id, root_process_id);
+}
+
+PipelineStats &pipeline_stats()
+{
+    return g_pipeline_stats;
+}
+
+long long event_timestamp_ms()
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+long long monotonic_time_ns()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+long long monotonic_to_timestamp_ms(long long monotonic_ns)
+{
+    return event_timestamp_ms() - (monotonic_time_ns() - monotonic_ns) / 1000000;
+}
+
+// Hands an event to the broadcast ring and every subscribed context
+static void enqueue_process_event(const TimedProcessEvent &timed)
+{
+    const CompactProcessEvent& event = timed.event;
+    g_pipeline_stats.Add(PipelineCounter::kIngested);
+    if (timed.kernel_time_ns != 0) {
+        g_pipeline_stats.RecordLatency(PipelineLatency::kKernelToIngest, timed.ingest_time_ns - timed.kernel_time_ns);
+    }
+
+    std::shared_ptr<const SubscriberList> subscribers = std::atomic_load(&g_subscribers);
+    bool broadcasting = g_broadcasting;
+    if ((!subscribers || subscribers->empty()) && !broadcasting) {
+        return;
+    }
+
+    // Repeats never reach a consumer
+    long long now_ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    if (g_event_dedup.IsDuplicate(event, now_ms)) {
+        g_pipeline_stats.Add(PipelineCounter::kDeduplicated);
+        return;
+    }
+
+    // Starts go into the process tree before the descendant filters look for them, stops after
+    if (event.event_type == PROCESS_EVENT_START) {
+        g_process_table.Observe(event);
+    }
+    if (broadcasting) {
+        g_broadcast_ring.load()->Publish(timed);
+    }
+    if (subscribers) {
+        for (const std::shared_ptr<MonitorContext>& context : *subscribers) {
+            context->Deliver(timed);
+        }
+    }
+    if (event.event_type != PROCESS_EVENT_START) {
+        g_process_table.Observe(event);
+    }
+}
+
+// Stop events reported by the exit watcher, which has no kernel timestamp to go by
+static void enqueue_exit_event(const CompactProcessEvent &event)
+{
+    TimedProcessEvent timed = {};
+    timed.event = event;
+    timed.ingest_time_ns = monotonic_time_ns();
+    enqueue_process_event(timed);
+    flush_process_events();
+}
+
+void publish_process_event(const CompactProcessEvent &event, long long kernel_time_ns)
+{
+    TimedProcessEvent timed = {};
+    timed.event = event;
+    timed.kernel_time_ns = kernel_time_ns;
+    timed.ingest_time_ns = monotonic_time_ns();
+
+    // Watched processes get their stop event from the exit watcher the moment they exit
+    ExitWatcher* exit_watcher = g_exit_watcher;
+    if (exit_watcher != nullptr) {
+        const char* name = g_process_names.Lookup(event.name_id);
+        if (event.event_type == PROCESS_EVENT_START) {
+            exit_watcher->Track(event, name);
+        }
+        else if (exit_watcher->OwnsExit(event, name)) {
+            return;
+        }
+    }
+
+    enqueue_process_event(timed);
+}
+
+void flush_process_events()
+{
+    std::shared_ptr<const SubscriberList> subscribers = std::atomic_load(&g_subscribers);
+    if (subscribers) {
+        for (const std::shared_ptr<MonitorContext>& context : *subscribers) {
+            context->Flush();
+        }
+    }
+}
+
+void publish_process_fork(int pid, int parent_pid)
+{
+    g_process_table.ObserveFork(pid, parent_pid);
+}
+
+void publish_process_fork_exit(int pid, long long start_time_ms)
+{
+    g_process_table.ObserveForkExit(pid, start_time_ms);
+}
+
+void record_process_details(int pid, long long start_time_ms, const ProcessDetailsRecord &details)
+{
+    g_process_details.Record(pid, start_time_ms, details);
+}
+
+std::string lookup_process_exe_path(int pid, long long start_time_ms)
+{
+    ProcessDetailsRecord details;
+    if (!g_process_details.Get(pid, start_time_ms, PROCESS_DETAIL_EXE_PATH, &details) || !(details.fields & PROCESS_DETAIL_EXE_PATH)) {
+        return std::string();
+    }
+    return details.exe_path;
+}
+
+void publish_proc_scan_stats(const ProcScanStats &stats)
+{
+    std::lock_guard<std::mutex> lock(g_proc_scan_stats_mutex);
+    g_proc_scan_stats = stats;
+}
+
+// Seeds the instance trackers of subscribed contexts that haven't been seeded yet
+static void seed_subscribers(const std::vector<RunningProcess> &running)
+{
+    std::shared_ptr<const SubscriberList> subscribers = std::atomic_load(&g_subscribers);
+    if (subscribers) {
+        for (const std::shared_ptr<MonitorContext>& context : *subscribers) {
+            context->SeedInstances(running);
+        }
+    }
+}
+
+// Wakes consumers waiting on any subscribed context or the broadcast ring, e.g. when the backend stops
+static void signal_subscribers()
+{
+    std::shared_ptr<const SubscriberList> subscribers = std::atomic_load(&g_subscribers);
+    if (subscribers) {
+        for (const std::shared_ptr<MonitorContext>& context : *subscribers) {
+            context->Signal().Set();
+        }
+    }
+
+    BroadcastRing<TimedProcessEvent>* broadcast_ring = g_broadcast_ring;
+    if (broadcast_ring != nullptr) {
+        broadcast_ring->Interrupt();
+    }
+}
+
+static void set_backend_ready(bool ready)
+{
+    std::lock_guard<std::mutex> lock(g_backend_state_mutex);
+    g_backend_ready = ready;
+    g_backend_state_cond.notify_all();
+}
+
+// Reports a failure of the shared backend to every subscribed context, and through
+// get_last_error when the default context is one of them
+static void report_backend_error(const std::string &message)
+{
+    std::shared_ptr<const SubscriberList> subscribers = std::atomic_load(&g_subscribers);
+    if (!subscribers) {
+        return;
+    }
+    for (const std::shared_ptr<MonitorContext>& context : *subscribers) {
+        context->SetLastError(message);
+        if (context == g_default_context) {
+            std::lock_guard<std::mutex> lock(g_last_error_mutex);
+            g_last_error = message;
+        }
+    }
+}
+
+// Last step of the monitor thread on every path
+static void finish_monitor_thread()
+{
+    signal_subscribers();
+
+    std::lock_guard<std::mutex> lock(g_backend_state_mutex);
+    g_monitor_thread_running = false;
+    g_backend_state_cond.notify_all();
+}
+
+// Monitor thread function
+void monitor_thread_function()
+{
+    std::string backend_error;
+    t_error_sink = &backend_error;
+
+    // The exit watcher has to be ready before the source can report starts to it
+    ExitWatcher* exit_watcher = nullptr;
+    if (!g_exit_watch_list.Empty())
+    {
+        exit_watcher = create_exit_watcher(g_exit_watch_list, enqueue_exit_event);
+        if (exit_watcher == nullptr || !exit_watcher->Start())
+        {
+            delete exit_watcher;
+            report_backend_error(backend_error);
+            g_monitoring = false;
+            finish_monitor_thread();
+            return;
+        }
+        g_exit_watcher = exit_watcher;
+    }
+
+    g_event_source = create_event_source(g_event_source_options);
+
+    if (g_event_source == nullptr)
+    {
+        g_exit_watcher = nullptr;
+        delete exit_watcher;
+        report_backend_error(backend_error);
+        g_monitoring = false;
+        finish_monitor_thread();
+        return;
+    }
+    g_active_event_source = g_event_source->Type();
+
+    // Loaded after the source is listening, so no process falls between the snapshot and the first event.
+    // Contexts subscribed from here on seed themselves from the table.
+    std::vector<RunningProcess> running;
+    g_process_table.Load(&running);
+    if (exit_watcher != nullptr)
+        exit_watcher->WatchRunningProcesses(running);
+    set_backend_ready(true);
+    seed_subscribers(running);
+
+    // Keep the thread alive while monitoring
+    backend_error.clear();
+    g_event_source->Run(g_monitoring, g_source_stop_signal);
+    flush_process_events();
+
+    // A source that gives up on its own (e.g. its socket failed) leaves nothing delivering events,
+    // so monitoring is reported as stopped and the next start brings up a new backend
+    if (g_monitoring.exchange(false)) {
+        report_backend_error(backend_error.empty() ? "The event source stopped unexpectedly" : backend_error);
+    }
+
+    set_backend_ready(false);
+    g_process_table.Clear();
+    g_active_event_source = -1;
+    delete g_event_source;
+    g_event_source = nullptr;
+
+    g_exit_watcher = nullptr;
+    delete exit_watcher;
+
+    finish_monitor_thread();
+}
+
+// Stops the shared backend; the monitor thread winds down on its own
+static void stop_backend()
+{
+    g_monitoring = false;
+    g_source_stop_signal.Set();
+}
+
+// Starts the monitor thread for the first subscriber
+static bool start_monitor_thread()
+{
+    if (!g_source_stop_signal.Create()) {
+        set_last_error("Failed to create event source stop signal");
+        return false;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(g_proc_scan_stats_mutex);
+        g_proc_scan_stats = {};
+    }
+
+    // Wait for any previous thread to finish before raising the flag again,
+    // otherwise it never observes the stop and the join below never returns
+    if (g_monitor_thread.joinable()) {
+        g_monitor_thread.join();
+    }
+
+    // Discard the previous session's stop request
+    g_source_stop_signal.Wait(0);
+
+    g_monitoring = true;
+    g_monitor_thread_running = true;
+
+    // Start the monitoring thread
+    try {
+        g_monitor_thread = std::thread(monitor_thread_function);
+    }
+    catch (...) {
+        g_monitoring = false;
+        g_monitor_thread_running = false;
+        set_last_error("Failed to start monitoring thread");
+        return false;
+    }
+
+    return true;
+}
+
+// Copies the subscriber list for modification under g_subscription_mutex
+static std::shared_ptr<SubscriberList> copy_subscribers()
+{
+    auto subscribers = std::make_shared<SubscriberList>();
+    std::shared_ptr<const SubscriberList> current = std::atomic_load(&g_subscribers);
+    if (current) {
+        *subscribers = *current;
+    }
+    return subscribers;
+}
+
+// Starts delivering events to a context, starting the backend if it isn't running
+static bool subscribe_context(const std::shared_ptr<MonitorContext> &context)
+{
+    std::lock_guard<std::mutex> lock(g_subscription_mutex);
+
+    std::shared_ptr<SubscriberList> subscribers = copy_subscribers();
+    bool added = false;
+    if (std::find(subscribers->begin(), subscribers->end(), context) == subscribers->end())
+    {
+        if (!context->Activate()) {
+            return false;
+        }
+        subscribers->push_back(context);
+        std::atomic_store(&g_subscribers, std::shared_ptr<const SubscriberList>(subscribers));
+        added = true;
+    }
+
+    if (!g_monitoring && !start_monitor_thread())
+    {
+        if (added) {
+            subscribers = copy_subscribers();
+            subscribers->erase(std::remove(subscribers->begin(), subscribers->end(), context), subscribers->end());
+            std::atomic_store(&g_subscribers, std::shared_ptr<const SubscriberList>(subscribers));
+            context->Deactivate();
+        }
+        return false;
+    }
+
+    // The backend is already listening, so its table can seed the context right away
+    if (g_backend_ready && context->NeedsSeed())
+    {
+        std::vector<RunningProcess> running;
+        g_process_table.List(&running);
+        context->SeedInstances(running);
+    }
+    return true;
+}
+
+// Stops delivering events to a context; the backend stops with its last subscriber
+static void unsubscribe_context(const std::shared_ptr<MonitorContext> &context)
+{
+    std::lock_guard<std::mutex> lock(g_subscription_mutex);
+
+    std::shared_ptr<SubscriberList> subscribers = copy_subscribers();
+    subscribers->erase(std::remove(subscribers->begin(), subscribers->end(), context), subscribers->end());
+    std::atomic_store(&g_subscribers, std::shared_ptr<const SubscriberList>(subscribers));
+
+    context->Deactivate();
+    if (subscribers->empty() && g_broadcast_subscriber_count == 0) {
+        // No blocking operations at all
+        stop_backend();
+    }
+}
+
+// Whether a context is subscribed to a running backend
+static bool is_context_monitoring(const MonitorContext &context)
+{
+    return context.IsActive() && g_monitoring;
+}
+
+static std::shared_ptr<ProcessFilter> make_process_filter(const char** process_names, const char** exe_paths, int count)
+{
+    WatchList watch_list;
+    for (int i = 0; i < count; i++) {
+        if (process_names[i]) {
+            watch_list.Add(process_names[i], exe_paths && exe_paths[i] ? exe_paths[i] : "");
+        }
+    }
+
+    std::shared_ptr<ProcessFilter> filter;
+    if (!watch_list.Empty()) {
+        filter = std::make_shared<ProcessFilter>(watch_list);
+    }
+    return filter;
+}
+
+static bool is_valid_event_delivery(int flags)
+{
+    return flags > 0 && (flags & ~(PROCESS_EVENTS_RAW | PROCESS_EVENTS_EDGES)) == 0;
+}
+
+static void fill_event_queue_stats(const EventRing<TimedProcessEvent> &queue, EventQueueStats* stats)
+{
+    stats->capacity = (long long)queue.Capacity();
+    stats->pending = (long long)queue.Size();
+    stats->high_water_mark = (long long)queue.HighWaterMark();
+    stats->dropped = (long long)queue.DroppedCount();
+    stats->overwritten = (long long)queue.OverwrittenCount();
+}
+
+// Counts an event read by a consumer at `now_ns`
+static void record_dequeued(const TimedProcessEvent &timed, long long now_ns)
+{
+    g_pipeline_stats.Add(PipelineCounter::kDelivered);
+    g_pipeline_stats.RecordLatency(PipelineLatency::kIngestToDequeue, now_ns - timed.ingest_time_ns);
+}
+
+// Pops one queued event
+static bool pop_event(EventRing<TimedProcessEvent> &queue, TimedProcessEvent* timed)
+{
+    if (!queue.Pop(timed)) {
+        return false;
+    }
+    record_dequeued(*timed, monotonic_time_ns());
+    return true;
+}
+
+// Pops queued events without their timings
+static size_t pop_events(EventRing<TimedProcessEvent> &queue, CompactProcessEvent* events_array, size_t max_events)
+{
+    size_t count = 0;
+    TimedProcessEvent timed;
+    while (count < max_events && pop_event(queue, &timed)) {
+        events_array[count++] = timed.event;
+    }
+    return count;
+}
+
+// Pops queued events with their timings, stamped with the time they were dequeued
+static size_t pop_events(EventRing<TimedProcessEvent> &queue, TimedProcessEvent* events_array, size_t max_events)
+{
+    size_t count = queue.PopBatch(events_array, max_events);
+    long long now_ns = monotonic_time_ns();
+    for (size_t i = 0; i < count; i++) {
+        events_array[i].dequeue_time_ns = now_ns;
+        record_dequeued(events_array[i], now_ns);
+    }
+    return count;
+}
+
+// Waits for events on a context's queue and pops up to max_events of them
+template <typename Event>
+static int drain_context(MonitorContext &context, Event* events_array, int max_events, int timeout_ms)
+{
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms < 0 ? 0 : timeout_ms);
+    while (true) {
+        int count = (int)pop_events(context.Queue(), events_array, (size_t)max_events);
+        if (count > 0 || !is_context_monitoring(context)) {
+            return count;
+        }
+
+        int wait_ms = -1;
+        if (timeout_ms >= 0) {
+            auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()).count();
+            if (remaining <= 0) {
+                return 0;
+            }
+            wait_ms = (int)remaining;
+        }
+
+        // Woken by a new event, by a stop, or spuriously; the next pass tells which
+        if (context.Signal().Wait(wait_ms) < 0) {
+            return -1;
+        }
+    }
+}
+
+// Reads a subscriber's next events, waiting for up to timeout_ms if there are none.
+// `store(index, event)` writes each one out.
+template <typename Store>
+static int read_subscriber(pm_subscriber_t* subscriber, int max_events, int timeout_ms, long long* lost_events, Store store)
+{
+    BroadcastRing<TimedProcessEvent>& broadcast_ring = *g_broadcast_ring.load();
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms < 0 ? 0 : timeout_ms);
+    uint64_t lost = 0;
+    int count;
+    while (true) {
+        uint64_t interrupts = broadcast_ring.Interrupts();
+        count = (int)broadcast_ring.ReadWith(&subscriber->cursor, (size_t)max_events, &lost, [&store](size_t index, const TimedProcessEvent &timed) {
+            record_dequeued(timed, monotonic_time_ns());
+            store(index, timed);
+        });
+        if (count > 0 || !g_monitoring) {
+            break;
+        }
+
+        int wait_ms = -1;
+        if (timeout_ms >= 0) {
+            auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()).count();
+            if (remaining <= 0) {
+                break;
+            }
+            wait_ms = (int)remaining;
+        }
+
+        // Woken by a new event, by a stop, or on timeout; the next pass tells which
+        broadcast_ring.Wait(subscriber->cursor, interrupts, wait_ms);
+    }
+
+    subscriber->read += count;
+    subscriber->lost += (long long)lost;
+    g_pipeline_stats.Add(PipelineCounter::kDropped, lost);
+    if (lost_events) {
+        *lost_events = (long long)lost;
+    }
+    return count;
+}
+
+// Waits while the backend is starting, and returns the live process table once it is loaded.
+// Without a running backend, loads `scratch` from a fresh snapshot instead (null on failure).
+static const ProcessTable* current_process_table(ProcessTable* scratch)
+{
+    {
+        std::unique_lock<std::mutex> lock(g_backend_state_mutex);
+        g_backend_state_cond.wait(lock, [] { return g_backend_ready || !g_monitoring || !g_monitor_thread_running; });
+        if (g_backend_ready) {
+            return &g_process_table;
+        }
+    }
+
+    std::vector<RunningProcess> running;
+    return scratch->Load(&running) ? scratch : nullptr;
+}
+
+// Starts the default context with its delivery target already chosen
+static bool start_default_context()
+{
+    if (!subscribe_context(g_default_context))
+    {
+        std::string context_error = g_default_context->LastError();
+        if (!context_error.empty()) {
+            set_last_error(context_error);
+        }
+        g_default_context->ClearDeliveryTargets();
+        return false;
+    }
+    return true;
+}
+
+// C API Implementation
+extern "C" {
+
+PROCESS_MONITOR_API bool initialize_process_monitor()
+{
+    clear_last_error();
+    return true;
+}
+
+PROCESS_MONITOR_API bool start_monitoring()
+{
+    if (is_context_monitoring(*g_default_context))
+    {
+        set_last_error("Process monitor is already running");
+        return false;
+    }
+
+    // Create event handle for signaling
+    if (!g_default_context->Signal().Create()) {
+        set_last_error("Failed to create event handle");
+        return false;
+    }
+
+    // Clear any existing events
+    g_default_context->Queue().Clear();
+    g_default_context->ClearDeliveryTargets();
+    return start_default_context();
+}
+
+PROCESS_MONITOR_API bool start_monitoring_with_callback(ProcessEventCallback callback, void* user_data)
+{
+    if (is_context_monitoring(*g_default_context))
+    {
+        set_last_error("Process monitor is already running");
+        return false;
+    }
+
+    // Set the callback
+    g_default_context->Queue().Clear();
+    g_default_context->ClearDeliveryTargets();
+    g_default_context->SetCallback(callback, user_data);
+    return start_default_context();
+}
+
+PROCESS_MONITOR_API bool start_monitoring_with_batch_callback(ProcessEventBatchCallback callback, int max_events, int max_delay_us, void* user_data)
+{
+    if (is_context_monitoring(*g_default_context))
+    {
+        set_last_error("Process monitor is already running");
+        return false;
+    }
+    if (!callback || max_events <= 0 || max_events > 65536 || max_delay_us < 0)
+    {
+        set_last_error("Invalid batch callback parameters");
+        return false;
+    }
+
+    g_default_context->ClearDeliveryTargets();
+    g_default_context->SetBatchCallback(callback, user_data, (size_t)max_events, max_delay_us);
+    return start_default_context();
+}
+
+PROCESS_MONITOR_API bool start_monitoring_with_native_port(void* api_dl_data, long long port)
+{
+    if (is_context_monitoring(*g_default_context))
+    {
+        set_last_error("Process monitor is already running");
+        return false;
+    }
+    if (port == 0)
+    {
+        set_last_error("Invalid Dart port");
+        return false;
+    }
+
+    g_default_context->ClearDeliveryTargets();
+    if (!g_default_context->SetDartPort(api_dl_data, port)) {
+        return false;
+    }
+    return start_default_context();
+}
+
+PROCESS_MONITOR_API bool stop_monitoring()
+{
+    // No blocking operations at all: the backend and batcher threads wind down on their own
+    unsubscribe_context(g_default_context);
+
+    // Clear callback
+    g_default_context->ClearDeliveryTargets();
+
+    return true;
+}
+
+PROCESS_MONITOR_API bool set_event_source(int source_type)
+{
+    if (source_type < PROCESS_EVENT_SOURCE_AUTO || source_type > PROCESS_EVENT_SOURCE_REPLAY)
+    {
+        set_last_error("Unknown event source " + std::to_string(source_type));
+        return false;
+    }
+    if (g_monitoring)
+    {
+        set_last_error("Cannot change the event source while monitoring");
+        return false;
+    }
+
+    g_event_source_options.type = (ProcessEventSourceType)source_type;
+    return true;
+}
+
+PROCESS_MONITOR_API int get_active_event_source()
+{
+    return g_active_event_source;
+}
+
+PROCESS_MONITOR_API bool set_proc_scan_interval(int interval_ms)
+{
+    if (interval_ms <= 0)
+    {
+        set_last_error("Scan interval must be positive");
+        return false;
+    }
+    if (g_monitoring)
+    {
+        set_last_error("Cannot change the scan interval while monitoring");
+        return false;
+    }
+
+    g_event_source_options.proc_scan_interval_ms = interval_ms;
+    return true;
+}
+
+PROCESS_MONITOR_API bool set_synthetic_event_rate(int events_per_second, long long event_count)
+{
+    if (events_per_second <= 0 || event_count < 0)
+    {
+        set_last_error("Synthetic event rate must be positive and the event count not negative");
+        return false;
+    }
+    if (g_monitoring)
+    {
+        set_last_error("Cannot change the synthetic event rate while monitoring");
+        return false;
+    }
+
+    g_event_source_options.synthetic_events_per_second = events_per_second;
+    g_event_source_options.synthetic_event_count = event_count;
+    return true;
+}
+
+PROCESS_MONITOR_API bool set_replay_trace(const char* path)
+{
+    if (!path || !*path)
+    {
+        set_last_error("Trace path is empty");
+        return false;
+    }
+    if (g_monitoring)
+    {
+        set_last_error("Cannot change the replay trace while monitoring");
+        return false;
+    }
+
+    g_event_source_options.replay_trace_path = path;
+    return true;
+}
+
+PROCESS_MONITOR_API bool set_event_rate_multiplier(double multiplier)
+{
+    if (!(multiplier >= 0))
+    {
+        set_last_error("Rate multiplier must not be negative");
+        return false;
+    }
+    if (g_monitoring)
+    {
+        set_last_error("Cannot change the rate multiplier while monitoring");
+        return false;
+    }
+
+    g_event_source_options.rate_multiplier = multiplier;
+    return true;
+}
+
+PROCESS_MONITOR_API bool set_exit_watch_list(const char** process_names, const char** exe_paths, int count)
+{
+    if (count < 0 || (count > 0 && !process_names))
+    {
+        set_last_error("Invalid exit watch list");
+        return false;
+    }
+    if (g_monitoring)
+    {
+        set_last_error("Cannot change the exit watch list while monitoring");
+        return false;
+    }
+
+    g_exit_watch_list.Clear();
+    for (int i = 0; i < count; i++) {
+        if (process_names[i]) {
+            g_exit_watch_list.Add(process_names[i], exe_paths && exe_paths[i] ? exe_paths[i] : "");
+        }
+    }
+    return true;
+}
+
+PROCESS_MONITOR_API bool set_process_watch_set(const char** process_names, const char** exe_paths, int count)
+{
+    if (count < 0 || (count > 0 && !process_names))
+    {
+        set_last_error("Invalid process watch set");
+        return false;
+    }
+
+    g_default_context->SetFilter(make_process_filter(process_names, exe_paths, count));
+    return true;
+}
+
+PROCESS_MONITOR_API void set_deliver_all_events(bool deliver_all)
+{
+    g_default_context->SetDeliverAllEvents(deliver_all);
+}
+
+PROCESS_MONITOR_API bool set_event_delivery(int flags)
+{
+    if (!is_valid_event_delivery(flags))
+    {
+        set_last_error("Unknown event delivery flags " + std::to_string(flags));
+        return false;
+    }
+    if (is_context_monitoring(*g_default_context))
+    {
+        set_last_error("Cannot change event delivery while monitoring");
+        return false;
+    }
+
+    g_default_context->SetEventDelivery(flags);
+    return true;
+}
+
+PROCESS_MONITOR_API bool set_dedup_window(int window_ms)
+{
+    if (window_ms < 0)
+    {
+        set_last_error("Dedup window must not be negative");
+        return false;
+    }
+
+    g_event_dedup.SetWindow(window_ms);
+    return true;
+}
+
+PROCESS_MONITOR_API bool get_dedup_stats(EventDedupStats* stats)
+{
+    if (!stats) return false;
+
+    stats->checked = (long long)g_event_dedup.CheckedCount();
+    stats->duplicates = (long long)g_event_dedup.DuplicateCount();
+    stats->evicted = (long long)g_event_dedup.EvictedCount();
+    stats->window_ms = g_event_dedup.Window();
+    return true;
+}
+
+PROCESS_MONITOR_API bool get_proc_scan_stats(ProcScanStats* stats)
+{
+    if (!stats) return false;
+
+    std::lock_guard<std::mutex> lock(g_proc_scan_stats_mutex);
+    if (g_proc_scan_stats.scan_count == 0) {
+        return false;
+    }
+
+    *stats = g_proc_scan_stats;
+    return true;
+}
+
+PROCESS_MONITOR_API bool set_event_queue_capacity(int capacity, int overflow_policy)
+{
+    if (capacity <= 0 || capacity > (1 << 24))
+    {
+        set_last_error("Event queue capacity must be between 1 and 16777216");
+        return false;
+    }
+    if (overflow_policy != EVENT_QUEUE_OVERWRITE_OLDEST && overflow_policy != EVENT_QUEUE_DROP_NEWEST)
+    {
+        set_last_error("Unknown event queue overflow policy " + std::to_string(overflow_policy));
+        return false;
+    }
+    if (g_default_context->IsActive() || g_monitor_thread_running)
+    {
+        set_last_error("Cannot resize the event queue while monitoring");
+        return false;
+    }
+    if (g_event_ring_mapped)
+    {
+        set_last_error("Cannot resize the event queue while it is mapped");
+        return false;
+    }
+
+    if (!g_default_context->Queue().Reset((size_t)capacity, overflow_policy == EVENT_QUEUE_DROP_NEWEST ? RingOverflowPolicy::kDropNewest : RingOverflowPolicy::kOverwriteOldest))
+    {
+        set_last_error("Failed to allocate the event queue");
+        return false;
+    }
+    return true;
+}
+
+PROCESS_MONITOR_API bool get_event_queue_stats(EventQueueStats* stats)
+{
+    if (!stats) return false;
+
+    fill_event_queue_stats(g_default_context->Queue(), stats);
+    return true;
+}
+
+PROCESS_MONITOR_API bool get_monitor_stats(MonitorStats* stats)
+{
+    if (!stats) return false;
+
+    g_pipeline_stats.Read(stats);
+    return true;
+}
+
+PROCESS_MONITOR_API long long get_latency_bucket_floor_ns(int bucket)
+{
+    if (bucket < 0 || bucket > MONITOR_LATENCY_BUCKETS) return -1;
+
+    return PipelineStats::BucketFloor(bucket);
+}
+
+PROCESS_MONITOR_API const ProcessEventRingHeader* map_event_ring()
+{
+    EventRing<TimedProcessEvent>& queue = g_default_context->Queue();
+    if (queue.Control() == nullptr)
+    {
+        set_last_error("Event queue is not allocated");
+        return nullptr;
+    }
+
+    // Producers must not recycle slots the consumer has not released yet
+    if (!g_event_ring_mapped.exchange(true))
+    {
+        g_unmapped_overflow_policy = queue.OverflowPolicy();
+        queue.SetOverflowPolicy(RingOverflowPolicy::kDropNewest);
+    }
+
+    return (const ProcessEventRingHeader*)queue.ReadOnlyView();
+}
+
+PROCESS_MONITOR_API int acquire_mapped_events(long long* first_index, int max_events)
+{
+    if (!first_index || max_events <= 0 || !g_event_ring_mapped) {
+        return 0;
+    }
+
+    uint64_t first = 0;
+    int count = (int)g_default_context->Queue().Peek(&first, (size_t)max_events);
+    *first_index = (long long)first;
+    return count;
+}
+
+PROCESS_MONITOR_API int release_mapped_events(int count)
+{
+    if (count <= 0 || !g_event_ring_mapped) {
+        return 0;
+    }
+
+    // Read in place, so there is no dequeue time to measure
+    int released = (int)g_default_context->Queue().Release((size_t)count);
+    g_pipeline_stats.Add(PipelineCounter::kDelivered, (uint64_t)released);
+    return released;
+}
+
+PROCESS_MONITOR_API void unmap_event_ring()
+{
+    if (g_event_ring_mapped.exchange(false))
+    {
+        g_default_context->Queue().SetOverflowPolicy(g_unmapped_overflow_policy);
+    }
+}
+
+PROCESS_MONITOR_API bool get_next_event(ProcessEventData* event_data)
+{
+    if (!event_data) return false;
+
+    TimedProcessEvent timed;
+    if (!pop_event(g_default_context->Queue(), &timed)) {
+        return false;
+    }
+
+    expand_process_event(timed.event, event_data);
+    return true;
+}
+
+PROCESS_MONITOR_API bool is_monitoring()
+{
+    return is_context_monitoring(*g_default_context);
+}
+
+PROCESS_MONITOR_API int get_pending_event_count()
+{
+    return (int)g_default_context->Queue().Size();
+}
+
+PROCESS_MONITOR_API int wait_for_events(int timeout_ms)
+{
+    EventSignal& event_available = g_default_context->Signal();
+    if (!event_available.IsCreated()) {
+        return -1; // Not initialized
+    }
+
+    // The signal is auto-reset, so events left over from an earlier wakeup don't raise it again
+    size_t pending = g_default_context->Queue().Size();
+    if (pending > 0) {
+        return (int)pending;
+    }
+    if (timeout_ms < 0 && !is_context_monitoring(*g_default_context)) {
+        return 0;
+    }
+
+    int result = event_available.Wait(timeout_ms);
+    if (result > 0) {
+        // Event was signaled, return number of available events
+        return (int)g_default_context->Queue().Size();
+    }
+    return result; // 0 on timeout, -1 on error
+}
+
+PROCESS_MONITOR_API int wait_and_drain(CompactProcessEvent* events_array, int max_events, int timeout_ms)
+{
+    if (!events_array || max_events <= 0 || !g_default_context->Signal().IsCreated()) {
+        return -1;
+    }
+
+    return drain_context(*g_default_context, events_array, max_events, timeout_ms);
+}
+
+PROCESS_MONITOR_API int wait_and_drain_timed(TimedProcessEvent* events_array, int max_events, int timeout_ms)
+{
+    if (!events_array || max_events <= 0 || !g_default_context->Signal().IsCreated()) {
+        return -1;
+    }
+
+    return drain_context(*g_default_context, events_array, max_events, timeout_ms);
+}
+
+PROCESS_MONITOR_API long long get_monotonic_time_ns()
+{
+    return monotonic_time_ns();
+}
+
+PROCESS_MONITOR_API int get_all_events(ProcessEventData* events_array, int max_events)
+{
+    if (!events_array || max_events <= 0) {
+        return 0;
+    }
+
+    int count = 0;
+    TimedProcessEvent timed;
+    while (count < max_events && pop_event(g_default_context->Queue(), &timed)) {
+        expand_process_event(timed.event, &events_array[count++]);
+    }
+    return count;
+}
+
+PROCESS_MONITOR_API int get_all_events_compact(CompactProcessEvent* events_array, int max_events)
+{
+    if (!events_array || max_events <= 0) {
+        return 0;
+    }
+
+    return (int)pop_events(g_default_context->Queue(), events_array, (size_t)max_events);
+}
+
+PROCESS_MONITOR_API const char* get_process_name(unsigned int name_id)
+{
+    return g_process_names.Lookup(name_id);
+}
+
+PROCESS_MONITOR_API int get_process_name_count()
+{
+    return (int)g_process_names.Count();
+}
+
+PROCESS_MONITOR_API bool get_process_name_table_stats(ProcessNameTableStats* stats)
+{
+    if (!stats) return false;
+
+    stats->name_count = (long long)g_process_names.Count();
+    stats->memory_bytes = (long long)g_process_names.MemoryBytes();
+    stats->lookups = (long long)g_process_names.InternCount();
+    stats->inserts = (long long)g_process_names.InsertCount();
+    return true;
+}
+
+PROCESS_MONITOR_API int snapshot_processes(ProcessSnapshotEntry* entries, int max_entries)
+{
+    if (max_entries < 0 || (max_entries > 0 && !entries)) {
+        set_last_error("Invalid snapshot buffer");
+        return -1;
+    }
+
+    ProcessTable scratch;
+    const ProcessTable* table = current_process_table(&scratch);
+    if (!table) {
+        return -1;
+    }
+    return (int)table->Snapshot(entries, (size_t)max_entries);
+}
+
+PROCESS_MONITOR_API bool is_running(const char* process_name)
+{
+    return pids_of(process_name, nullptr, 0) > 0;
+}
+
+PROCESS_MONITOR_API int pids_of(const char* process_name, int* pids, int max_pids)
+{
+    if (!process_name || max_pids < 0 || (max_pids > 0 && !pids)) {
+        set_last_error("Invalid process name or PID buffer");
+        return -1;
+    }
+
+    ProcessTable scratch;
+    const ProcessTable* table = current_process_table(&scratch);
+    if (!table) {
+        return -1;
+    }
+    return (int)table->PidsOf(process_name, pids, (size_t)max_pids);
+}
+
+PROCESS_MONITOR_API int get_process_ancestors(int process_id, int* ancestors, int max_ancestors)
+{
+    if (max_ancestors < 0 || (max_ancestors > 0 && !ancestors)) {
+        set_last_error("Invalid ancestor buffer");
+        return -1;
+    }
 
-// Global state for FFI
-static std::string g_last_error;
-static std::atomic<bool> g_monitoring = false;
-static std::thread g_monitor_thread;
-static std::queue<ProcessEventData> g_event_queue;
-static std::mutex g_queue_mutex;
-static std::atomic<bool> g_com_initialized = false;
+    ProcessTable scratch;
+    const ProcessTable* table = current_process_table(&scratch);
+    if (!table) {
+        return -1;
+    }
+    return (int)table->Tree().Ancestors(process_id, ancestors, (size_t)max_ancestors);
+}
 
-// Event signaling mechanism
-static HANDLE g_event_available = nullptr;
+PROCESS_MONITOR_API int get_process_descendants(int process_id, int* descendants, int max_descendants)
+{
+    if (max_descendants < 0 || (max_descendants > 0 && !descendants)) {
+        set_last_error("Invalid descendant buffer");
+        return -1;
+    }
+
+    ProcessTable scratch;
+    const ProcessTable* table = current_process_table(&scratch);
+    if (!table) {
+        return -1;
+    }
+    return (int)table->Tree().Descendants(process_id, descendants, (size_t)max_descendants);
+}
 
-// Callback mechanism (kept for compatibility)
-static ProcessEventCallback g_event_callback = nullptr;
-static void* g_callback_user_data = nullptr;
+PROCESS_MONITOR_API bool set_descendant_filter(int root_process_id)
+{
+    if (root_process_id < 0) {
+        set_last_error("Invalid root process ID " + std::to_string(root_process_id));
+        return false;
+    }
 
-// Forward declaration
-class FFIProcessEventSink;
-static FFIProcessEventSink* g_event_sink = nullptr;
+    g_default_context->SetDescendantRoot(root_process_id);
+    return true;
+}
 
-class FFIProcessEventSink : public IWbemObjectSink
+PROCESS_MONITOR_API int get_process_details(int process_id, long long start_time_ms, int fields_mask, ProcessDetails* details, char* buffer, int buffer_size)
 {
-private:
-    LONG m_lRef;
-    IWbemServices *m_pSvc = nullptr;
-    IUnsecuredApartment *m_pUnsecApp = nullptr;
-    IWbemObjectSink *m_pStubSink = nullptr;
+    if (!details || process_id < 0 || buffer_size < 0 || (buffer_size > 0 && !buffer)) {
+        set_last_error("Invalid process details arguments");
+        return -1;
+    }
 
-public:
-    FFIProcessEventSink() : m_lRef(0) {}
-    virtual ~FFIProcessEventSink() { 
-        // Don't call Cleanup() in destructor - this can cause crashes
-        // We'll call it explicitly when safe
+    ProcessDetailsRecord record;
+    if (!g_process_details.Get(process_id, start_time_ms, fields_mask, &record)) {
+        set_last_error("Process " + std::to_string(process_id) + " is not running and no details were kept for it");
+        return -1;
     }
 
-    // IUnknown methods
-    ULONG STDMETHODCALLTYPE AddRef()
-    {
-        return InterlockedIncrement(&m_lRef);
+    details->fields = record.fields & fields_mask;
+    details->start_time_ms = (details->fields & PROCESS_DETAIL_START_TIME) ? record.start_time_ms : 0;
+    details->user_id = (details->fields & PROCESS_DETAIL_USER_ID) ? record.user_id : -1;
+    details->exe_path = nullptr;
+    details->command_line = nullptr;
+    details->reserved = 0;
+
+    // Strings are copied only if they all fit
+    int required = 0;
+    if (details->fields & PROCESS_DETAIL_EXE_PATH) {
+        required += (int)record.exe_path.size() + 1;
+    }
+    if (details->fields & PROCESS_DETAIL_COMMAND_LINE) {
+        required += (int)record.command_line.size() + 1;
+    }
+    if (required > buffer_size) {
+        return required;
     }
 
-    ULONG STDMETHODCALLTYPE Release()
-    {
-        LONG lRef = InterlockedDecrement(&m_lRef);
-        if (lRef == 0)
-            delete this;
-        return lRef;
+    char* cursor = buffer;
+    if (details->fields & PROCESS_DETAIL_EXE_PATH) {
+        memcpy(cursor, record.exe_path.c_str(), record.exe_path.size() + 1);
+        details->exe_path = cursor;
+        cursor += record.exe_path.size() + 1;
+    }
+    if (details->fields & PROCESS_DETAIL_COMMAND_LINE) {
+        memcpy(cursor, record.command_line.c_str(), record.command_line.size() + 1);
+        details->command_line = cursor;
     }
+    return required;
+}
 
-    HRESULT STDMETHODCALLTYPE QueryInterface(REFIID riid, void **ppv)
+PROCESS_MONITOR_API pm_context_t* pm_context_create(int queue_capacity)
+{
+    if (queue_capacity < 0 || queue_capacity > (1 << 24))
     {
-        if (riid == IID_IUnknown || riid == IID_IWbemObjectSink)
-        {
-            *ppv = (IWbemObjectSink *)this;
-            AddRef();
-            return WBEM_S_NO_ERROR;
+        set_last_error("Event queue capacity must be between 1 and 16777216");
+        return nullptr;
+    }
+
+    try {
+        pm_context_t* handle = new pm_context_t();
+        handle->context = std::make_shared<MonitorContext>(queue_capacity > 0 ? (size_t)queue_capacity : kDefaultEventQueueCapacity);
+        if (handle->context->Queue().Control() == nullptr || !handle->context->Signal().Create()) {
+            delete handle;
+            set_last_error("Failed to allocate the monitor context");
+            return nullptr;
         }
-        return E_NOINTERFACE;
+        return handle;
+    }
+    catch (...) {
+        set_last_error("Failed to allocate the monitor context");
+        return nullptr;
     }
+}
 
-    // IWbemObjectSink methods
-    HRESULT STDMETHODCALLTYPE Indicate(LONG lObjectCount, IWbemClassObject **apObjArray)
-    {
-        for (long i = 0; i < lObjectCount; i++)
-        {
-            VARIANT vtProp;
-            VariantInit(&vtProp);
-            HRESULT hr = apObjArray[i]->Get(_bstr_t(L"TargetInstance"), 0, &vtProp, 0, 0);
-
-            if (SUCCEEDED(hr))
-            {
-                IWbemClassObject *pTargetInstance = (IWbemClassObject *)vtProp.punkVal;
-
-                VARIANT vtProcessName;
-                VariantInit(&vtProcessName);
-                pTargetInstance->Get(L"Name", 0, &vtProcessName, 0, 0);
-
-                VARIANT vtProcessId;
-                VariantInit(&vtProcessId);
-                pTargetInstance->Get(L"ProcessId", 0, &vtProcessId, 0, 0);
-
-                std::wstring processName = vtProcessName.bstrVal;
-                uint32_t processId = vtProcessId.uintVal;
-
-                // Convert wide string to UTF-8
-                int utf8_length = WideCharToMultiByte(CP_UTF8, 0, processName.c_str(), -1, nullptr, 0, nullptr, nullptr);
-                std::string utf8_processName(utf8_length - 1, 0);
-                WideCharToMultiByte(CP_UTF8, 0, processName.c_str(), -1, &utf8_processName[0], utf8_length, nullptr, nullptr);
-
-                // Get event type
-                _variant_t vtClass;
-                apObjArray[i]->Get(_bstr_t(L"__CLASS"), 0, &vtClass, NULL, NULL);
-
-                ProcessEventData event_data = {0};
-                strncpy_s(event_data.process_name, sizeof(event_data.process_name), utf8_processName.c_str(), _TRUNCATE);
-                event_data.process_id = (int)processId;
-                
-                // Use system clock to get proper Unix epoch timestamp
-                auto now = std::chrono::system_clock::now();
-                auto duration = now.time_since_epoch();
-                auto millis = std::chrono::duration_cast<std::chrono::milliseconds>(duration).count();
-                event_data.timestamp_ms = millis;
-
-                if (wcscmp(vtClass.bstrVal, L"__InstanceCreationEvent") == 0)
-                    strncpy_s(event_data.event_type, sizeof(event_data.event_type), "start", _TRUNCATE);
-                else
-                    strncpy_s(event_data.event_type, sizeof(event_data.event_type), "stop", _TRUNCATE);
-
-                // Add to queue and signal event availability
-                {
-                    std::lock_guard<std::mutex> lock(g_queue_mutex);
-                    g_event_queue.push(event_data);
-                    
-                    // Limit queue size to prevent memory issues
-                    while (g_event_queue.size() > 1000) {
-                        g_event_queue.pop();
-                    }
-                }
-                
-                // Signal that new events are available
-                if (g_event_available != nullptr) {
-                    SetEvent(g_event_available);
-                }
-                
-                // If we have a callback, call it immediately (kept for compatibility)
-                if (g_event_callback != nullptr) {
-                    try {
-                        g_event_callback(&event_data, g_callback_user_data);
-                    }
-                    catch (...) {
-                        // Ignore callback errors to prevent crashes
-                    }
-                }
+PROCESS_MONITOR_API void pm_context_destroy(pm_context_t* context)
+{
+    if (!context) return;
 
-                VariantClear(&vtProcessName);
-                VariantClear(&vtProcessId);
-                VariantClear(&vtClass);
-                pTargetInstance->Release();
-            }
-            VariantClear(&vtProp);
-        }
+    unsubscribe_context(context->context);
+    delete context;
+}
+
+PROCESS_MONITOR_API bool pm_context_set_watch_set(pm_context_t* context, const char** process_names, const char** exe_paths, int count)
+{
+    if (!context) return false;
 
-        return WBEM_S_NO_ERROR;
+    if (count < 0 || (count > 0 && !process_names))
+    {
+        context->context->SetLastError("Invalid process watch set");
+        return false;
     }
 
-    HRESULT STDMETHODCALLTYPE SetStatus(LONG lFlags, HRESULT hResult, BSTR strParam, IWbemClassObject *pObjParam)
+    context->context->SetFilter(make_process_filter(process_names, exe_paths, count));
+    return true;
+}
+
+PROCESS_MONITOR_API bool pm_context_set_descendant_filter(pm_context_t* context, int root_process_id)
+{
+    if (!context) return false;
+
+    if (root_process_id < 0)
     {
-        return WBEM_S_NO_ERROR;
+        context->context->SetLastError("Invalid root process ID " + std::to_string(root_process_id));
+        return false;
     }
 
-    bool Initialize()
+    context->context->SetDescendantRoot(root_process_id);
+    return true;
+}
+
+PROCESS_MONITOR_API bool pm_context_set_event_delivery(pm_context_t* context, int flags)
+{
+    if (!context) return false;
+
+    if (!is_valid_event_delivery(flags))
     {
-        HRESULT hres;
+        context->context->SetLastError("Unknown event delivery flags " + std::to_string(flags));
+        return false;
+    }
+    if (context->context->IsActive())
+    {
+        context->context->SetLastError("Cannot change event delivery while the context is started");
+        return false;
+    }
 
-        // Only initialize COM if it hasn't been initialized yet
-        if (!g_com_initialized.exchange(true)) {
-            hres = CoInitializeEx(0, COINIT_MULTITHREADED);
-            if (FAILED(hres) && hres != RPC_E_CHANGED_MODE)
-            {
-                g_com_initialized = false;
-                g_last_error = "Failed to initialize COM library. Error code = 0x" + std::to_string(hres);
-                return false;
-            }
+    context->context->SetEventDelivery(flags);
+    return true;
+}
 
-            hres = CoInitializeSecurity(NULL, -1, NULL, NULL, RPC_C_AUTHN_LEVEL_DEFAULT, RPC_C_IMP_LEVEL_IMPERSONATE, NULL, EOAC_NONE, NULL);
-            if (FAILED(hres) && hres != RPC_E_TOO_LATE)
-            {
-                g_last_error = "Failed to initialize security. Error code = 0x" + std::to_string(hres);
-                // Don't fail completely on security init failure
-            }
-        }
+PROCESS_MONITOR_API bool pm_context_start(pm_context_t* context)
+{
+    if (!context) return false;
 
-        IWbemLocator *pLoc = NULL;
-        hres = CoCreateInstance(CLSID_WbemLocator, 0, CLSCTX_INPROC_SERVER, IID_IWbemLocator, (LPVOID *)&pLoc);
-        if (FAILED(hres))
-        {
-            CoUninitialize();
-            g_last_error = "Failed to create IWbemLocator object. Error code = 0x" + std::to_string(hres);
-            return false;
-        }
+    if (is_context_monitoring(*context->context))
+    {
+        context->context->SetLastError("Context is already started");
+        return false;
+    }
 
-        hres = pLoc->ConnectServer(_bstr_t(L"ROOT\\CIMV2"), NULL, NULL, 0, NULL, 0, 0, &m_pSvc);
-        if (FAILED(hres))
-        {
-            pLoc->Release();
-            CoUninitialize();
-            g_last_error = "Could not connect to WMI. Error code = 0x" + std::to_string(hres);
-            return false;
+    context->context->ClearLastError();
+    if (!subscribe_context(context->context))
+    {
+        if (context->context->LastError().empty()) {
+            context->context->SetLastError(copy_last_error());
         }
+        return false;
+    }
+    return true;
+}
 
-        hres = CoSetProxyBlanket(m_pSvc, RPC_C_AUTHN_WINNT, RPC_C_AUTHZ_NONE, NULL, RPC_C_AUTHN_LEVEL_CALL, RPC_C_IMP_LEVEL_IMPERSONATE, NULL, EOAC_NONE);
-        if (FAILED(hres))
-        {
-            m_pSvc->Release();
-            pLoc->Release();
-            CoUninitialize();
-            g_last_error = "Could not set proxy blanket. Error code = 0x" + std::to_string(hres);
-            return false;
-        }
+PROCESS_MONITOR_API bool pm_context_stop(pm_context_t* context)
+{
+    if (!context) return false;
 
-        IUnsecuredApartment *pUnsecApp = NULL;
-        hres = CoCreateInstance(CLSID_UnsecuredApartment, NULL, CLSCTX_LOCAL_SERVER, IID_IUnsecuredApartment, (void **)&pUnsecApp);
-        if (FAILED(hres))
-        {
-            m_pSvc->Release();
-            pLoc->Release();
-            CoUninitialize();
-            g_last_error = "Failed to create IUnsecuredApartment. Error code = 0x" + std::to_string(hres);
-            return false;
-        }
+    unsubscribe_context(context->context);
+    return true;
+}
 
-        pUnsecApp->CreateObjectStub(this, (IUnknown**)&m_pStubSink);
-        pUnsecApp->Release();
-        pLoc->Release();
+PROCESS_MONITOR_API int pm_context_drain(pm_context_t* context, CompactProcessEvent* events_array, int max_events, int timeout_ms)
+{
+    if (!context || !events_array || max_events <= 0) {
+        return -1;
+    }
 
-        // Creation events
-        hres = m_pSvc->ExecNotificationQueryAsync(
-            _bstr_t("WQL"),
-            _bstr_t("SELECT * FROM __InstanceCreationEvent WITHIN 1 WHERE TargetInstance ISA 'Win32_Process'"),
-            WBEM_FLAG_SEND_STATUS,
-            NULL,
-            m_pStubSink
-        );
+    return drain_context(*context->context, events_array, max_events, timeout_ms);
+}
 
-        if (FAILED(hres))
-        {
-            Cleanup();
-            g_last_error = "ExecNotificationQueryAsync (creation) failed. Error code = 0x" + std::to_string(hres);
-            return false;
-        }
+PROCESS_MONITOR_API int pm_context_drain_timed(pm_context_t* context, TimedProcessEvent* events_array, int max_events, int timeout_ms)
+{
+    if (!context || !events_array || max_events <= 0) {
+        return -1;
+    }
 
-        // Deletion events
-        hres = m_pSvc->ExecNotificationQueryAsync(
-            _bstr_t("WQL"),
-            _bstr_t("SELECT * FROM __InstanceDeletionEvent WITHIN 1 WHERE TargetInstance ISA 'Win32_Process'"),
-            WBEM_FLAG_SEND_STATUS,
-            NULL,
-            m_pStubSink
-        );
+    return drain_context(*context->context, events_array, max_events, timeout_ms);
+}
 
-        if (FAILED(hres))
-        {
-            Cleanup();
-            g_last_error = "ExecNotificationQueryAsync (deletion) failed. Error code = 0x" + std::to_string(hres);
-            return false;
-        }
+PROCESS_MONITOR_API bool pm_context_get_queue_stats(pm_context_t* context, EventQueueStats* stats)
+{
+    if (!context || !stats) return false;
 
-        return true;
-    }
+    fill_event_queue_stats(context->context->Queue(), stats);
+    return true;
+}
 
-    void Cleanup()
-    {
-        if (m_pSvc)
-        {
-            if (m_pStubSink)
-                m_pSvc->CancelAsyncCall(m_pStubSink);
-            m_pSvc->Release();
-            m_pSvc = nullptr;
+PROCESS_MONITOR_API const char* pm_context_get_last_error(pm_context_t* context)
+{
+    if (!context) return "";
+
+    // Copied, since a background thread may replace the context's error at any time
+    static thread_local std::string error;
+    error = context->context->LastError();
+    return error.c_str();
+}
+
+PROCESS_MONITOR_API pm_subscriber_t* pm_subscribe()
+{
+    std::lock_guard<std::mutex> lock(g_subscription_mutex);
+
+    try {
+        BroadcastRing<TimedProcessEvent>* broadcast_ring = g_broadcast_ring;
+        if (broadcast_ring == nullptr) {
+            broadcast_ring = new BroadcastRing<TimedProcessEvent>(kBroadcastRingCapacity);
+            g_broadcast_ring = broadcast_ring;
         }
-        if (m_pStubSink)
+
+        pm_subscriber_t* subscriber = new pm_subscriber_t();
+        subscriber->cursor = broadcast_ring->Subscribe();
+        g_broadcast_subscriber_count++;
+        g_broadcasting = true;
+
+        if (!g_monitoring && !start_monitor_thread())
         {
-            m_pStubSink->Release();
-            m_pStubSink = nullptr;
+            if (--g_broadcast_subscriber_count == 0) {
+                g_broadcasting = false;
+            }
+            delete subscriber;
+            return nullptr;
         }
-        CoUninitialize();
+        return subscriber;
     }
-};
+    catch (...) {
+        set_last_error("Failed to allocate the broadcast subscriber");
+        return nullptr;
+    }
+}
 
-// Monitor thread function
-void monitor_thread_function()
+PROCESS_MONITOR_API void pm_unsubscribe(pm_subscriber_t* subscriber)
 {
-    g_event_sink = new FFIProcessEventSink();
-    
-    if (!g_event_sink->Initialize())
+    if (!subscriber) return;
+
     {
-        delete g_event_sink;
-        g_event_sink = nullptr;
-        g_monitoring = false;
-        return;
+        std::lock_guard<std::mutex> lock(g_subscription_mutex);
+        if (--g_broadcast_subscriber_count == 0) {
+            g_broadcasting = false;
+
+            std::shared_ptr<const SubscriberList> subscribers = std::atomic_load(&g_subscribers);
+            if (!subscribers || subscribers->empty()) {
+                stop_backend();
+            }
+        }
     }
+    delete subscriber;
+}
 
-    // Keep the thread alive while monitoring
-    while (g_monitoring)
-    {
-        Sleep(50); // Sleep for 50ms - more responsive to stop signal
+PROCESS_MONITOR_API int pm_subscriber_read(pm_subscriber_t* subscriber, CompactProcessEvent* events_array, int max_events, int timeout_ms, long long* lost_events)
+{
+    if (!subscriber || !events_array || max_events <= 0) {
+        return -1;
     }
 
-    // DO NOT call Cleanup() here - this causes crashes
-    // Just set the pointer to nullptr - cleanup will happen in cleanup_process_monitor()
-    g_event_sink = nullptr;
+    return read_subscriber(subscriber, max_events, timeout_ms, lost_events, [events_array](size_t index, const TimedProcessEvent &timed) {
+        events_array[index] = timed.event;
+    });
 }
 
-// C API Implementation
-extern "C" {
+PROCESS_MONITOR_API int pm_subscriber_read_timed(pm_subscriber_t* subscriber, TimedProcessEvent* events_array, int max_events, int timeout_ms, long long* lost_events)
+{
+    if (!subscriber || !events_array || max_events <= 0) {
+        return -1;
+    }
 
-PROCESS_MONITOR_API bool initialize_process_monitor()
+    int count = read_subscriber(subscriber, max_events, timeout_ms, lost_events, [events_array](size_t index, const TimedProcessEvent &timed) {
+        events_array[index] = timed;
+    });
+    long long now_ns = monotonic_time_ns();
+    for (int i = 0; i < count; i++) {
+        events_array[i].dequeue_time_ns = now_ns;
+    }
+    return count;
+}
+
+PROCESS_MONITOR_API bool pm_subscriber_get_stats(pm_subscriber_t* subscriber, BroadcastSubscriberStats* stats)
 {
-    g_last_error.clear();
+    if (!subscriber || !stats) return false;
+
+    BroadcastRing<TimedProcessEvent>& broadcast_ring = *g_broadcast_ring.load();
+    stats->capacity = (long long)broadcast_ring.Capacity();
+    stats->pending = (long long)broadcast_ring.Backlog(subscriber->cursor);
+    stats->read = subscriber->read;
+    stats->lost = subscriber->lost;
     return true;
 }
 
-PROCESS_MONITOR_API bool start_monitoring()
+// Body of a journal's thread: writes what the subscriber reads, publishing every batch to
+// readers and flushing to disk once per commit interval
+// Keeps the latest failure of the journal thread for pm_journal_get_last_error
+static void publish_journal_error(pm_journal_t* journal, std::string* error)
 {
-    if (g_monitoring)
-    {
-        g_last_error = "Process monitor is already running";
-        return false;
+    if (error->empty()) {
+        return;
     }
+    std::lock_guard<std::mutex> lock(journal->error_mutex);
+    journal->last_error.swap(*error);
+    error->clear();
+}
 
-    // Create event handle for signaling
-    if (g_event_available == nullptr) {
-        g_event_available = CreateEvent(nullptr, FALSE, FALSE, nullptr); // Auto-reset event
-        if (g_event_available == nullptr) {
-            g_last_error = "Failed to create event handle";
-            return false;
+static void run_journal(pm_journal_t* journal)
+{
+    std::string error;
+    t_error_sink = &error;
+
+    std::vector<CompactProcessEvent> events(kJournalBatchSize);
+    auto interval = std::chrono::milliseconds(journal->commit_interval_ms);
+    auto next_commit = std::chrono::steady_clock::now() + interval;
+
+    while (true) {
+        bool running = journal->running;
+        int wait_ms = 0;
+        if (running) {
+            auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(next_commit - std::chrono::steady_clock::now()).count();
+            wait_ms = (int)std::max<long long>(remaining, 1);
         }
-    }
 
-    // Clear any existing events
-    {
-        std::lock_guard<std::mutex> lock(g_queue_mutex);
-        while (!g_event_queue.empty()) {
-            g_event_queue.pop();
+        long long lost = 0;
+        int count = pm_subscriber_read(journal->subscriber, events.data(), kJournalBatchSize, wait_ms, &lost);
+        if (lost > 0) {
+            journal->writer->Skip((uint64_t)lost);
         }
-    }
+        for (int i = 0; i < count; i++) {
+            journal->writer->Append(events[i]);
+        }
+        journal->writer->Publish();
+        publish_journal_error(journal, &error);
 
-    g_monitoring = true;
+        // Once closing, keep going until what was published before the close is written
+        if (!running && count < kJournalBatchSize) {
+            break;
+        }
 
-    // Wait for any previous thread to finish
-    if (g_monitor_thread.joinable()) {
-        g_monitor_thread.join();
+        auto now = std::chrono::steady_clock::now();
+        if (now >= next_commit) {
+            journal->writer->Sync();
+            publish_journal_error(journal, &error);
+            next_commit = now + interval;
+        }
+        else if (count == 0 && !g_monitoring) {
+            // The backend failed; reads return at once until it is restarted
+            std::this_thread::sleep_until(next_commit);
+        }
     }
+    journal->writer->Close();
+    publish_journal_error(journal, &error);
+}
 
-    // Start the monitoring thread
+PROCESS_MONITOR_API pm_journal_t* pm_journal_open(const char* directory, long long segment_size, int max_segments, int commit_interval_ms)
+{
+    if (!directory || !*directory) {
+        set_last_error("Journal directory is empty");
+        return nullptr;
+    }
+    if (segment_size == 0) {
+        segment_size = kDefaultJournalSegmentSize;
+    }
+    if (segment_size < kMinJournalSegmentSize || (unsigned long long)segment_size > SIZE_MAX || max_segments < 0 || commit_interval_ms < 0) {
+        set_last_error("Invalid journal segment size, segment count or commit interval");
+        return nullptr;
+    }
+
+    pm_journal_t* journal;
     try {
-        g_monitor_thread = std::thread(monitor_thread_function);
+        journal = new pm_journal_t();
+        journal->writer = std::make_unique<JournalWriter>(directory, (size_t)segment_size, max_segments);
     }
     catch (...) {
-        g_monitoring = false;
-        g_last_error = "Failed to start monitoring thread";
-        return false;
+        set_last_error("Failed to allocate the journal");
+        return nullptr;
     }
-
-    return true;
-}
-
-PROCESS_MONITOR_API bool start_monitoring_with_callback(ProcessEventCallback callback, void* user_data)
-{
-    if (g_monitoring)
-    {
-        g_last_error = "Process monitor is already running";
-        return false;
+    if (commit_interval_ms > 0) {
+        journal->commit_interval_ms = commit_interval_ms;
     }
 
-    // Set the callback
-    g_event_callback = callback;
-    g_callback_user_data = user_data;
-
-    // Clear any existing events
-    {
-        std::lock_guard<std::mutex> lock(g_queue_mutex);
-        while (!g_event_queue.empty()) {
-            g_event_queue.pop();
-        }
+    if (!journal->writer->Open()) {
+        delete journal;
+        return nullptr;
     }
 
-    g_monitoring = true;
-
-    // Wait for any previous thread to finish
-    if (g_monitor_thread.joinable()) {
-        g_monitor_thread.join();
+    journal->subscriber = pm_subscribe();
+    if (!journal->subscriber) {
+        delete journal;
+        return nullptr;
     }
 
-    // Start the monitoring thread
     try {
-        g_monitor_thread = std::thread(monitor_thread_function);
+        journal->thread = std::thread(run_journal, journal);
     }
     catch (...) {
-        g_monitoring = false;
-        g_event_callback = nullptr;
-        g_callback_user_data = nullptr;
-        g_last_error = "Failed to start monitoring thread";
-        return false;
+        set_last_error("Failed to start the journal thread");
+        pm_unsubscribe(journal->subscriber);
+        delete journal;
+        return nullptr;
     }
+    return journal;
+}
 
-    return true;
+PROCESS_MONITOR_API void pm_journal_close(pm_journal_t* journal)
+{
+    if (!journal) return;
+
+    // The thread notices within one commit interval
+    journal->running = false;
+    journal->thread.join();
+    pm_unsubscribe(journal->subscriber);
+    delete journal;
 }
 
-PROCESS_MONITOR_API bool stop_monitoring()
+PROCESS_MONITOR_API bool pm_journal_get_stats(pm_journal_t* journal, JournalStats* stats)
 {
-    // Simply set the flag - no blocking operations at all
-    g_monitoring = false;
-    
-    // Clear callback
-    g_event_callback = nullptr;
-    g_callback_user_data = nullptr;
-    
+    if (!journal || !stats) return false;
+
+    journal->writer->GetStats(stats);
     return true;
 }
 
-PROCESS_MONITOR_API bool get_next_event(ProcessEventData* event_data)
+PROCESS_MONITOR_API const char* pm_journal_get_last_error(pm_journal_t* journal)
 {
-    if (!event_data) return false;
+    if (!journal) return "";
 
-    std::lock_guard<std::mutex> lock(g_queue_mutex);
-    if (g_event_queue.empty()) {
-        return false;
+    static thread_local std::string error;
+    std::lock_guard<std::mutex> lock(journal->error_mutex);
+    error = journal->last_error;
+    return error.c_str();
+}
+
+PROCESS_MONITOR_API pm_journal_reader_t* pm_journal_reader_open(const char* directory)
+{
+    if (!directory || !*directory) {
+        set_last_error("Journal directory is empty");
+        return nullptr;
     }
 
-    *event_data = g_event_queue.front();
-    g_event_queue.pop();
-    return true;
+    pm_journal_reader_t* reader;
+    try {
+        reader = new pm_journal_reader_t(directory);
+    }
+    catch (...) {
+        set_last_error("Failed to allocate the journal reader");
+        return nullptr;
+    }
+    if (!reader->reader.Open()) {
+        delete reader;
+        return nullptr;
+    }
+    return reader;
 }
 
-PROCESS_MONITOR_API bool is_monitoring()
+PROCESS_MONITOR_API void pm_journal_reader_close(pm_journal_reader_t* reader)
 {
-    return g_monitoring;
+    delete reader;
 }
 
-PROCESS_MONITOR_API int get_pending_event_count()
+PROCESS_MONITOR_API bool pm_journal_reader_seek_sequence(pm_journal_reader_t* reader, long long sequence)
 {
-    std::lock_guard<std::mutex> lock(g_queue_mutex);
-    return (int)g_event_queue.size();
+    if (!reader || sequence < 0) return false;
+
+    return reader->reader.SeekSequence((uint64_t)sequence);
 }
 
-PROCESS_MONITOR_API int wait_for_events(int timeout_ms)
+PROCESS_MONITOR_API bool pm_journal_reader_seek_time(pm_journal_reader_t* reader, long long timestamp_ms)
 {
-    if (g_event_available == nullptr) {
-        return -1; // Not initialized
-    }
-    
-    DWORD result = WaitForSingleObject(g_event_available, timeout_ms);
-    if (result == WAIT_OBJECT_0) {
-        // Event was signaled, return number of available events
-        std::lock_guard<std::mutex> lock(g_queue_mutex);
-        return (int)g_event_queue.size();
-    } else if (result == WAIT_TIMEOUT) {
-        return 0; // Timeout
-    } else {
-        return -1; // Error
-    }
+    if (!reader) return false;
+
+    return reader->reader.SeekTime(timestamp_ms);
 }
 
-PROCESS_MONITOR_API int get_all_events(ProcessEventData* events_array, int max_events)
+PROCESS_MONITOR_API int pm_journal_reader_read(pm_journal_reader_t* reader, JournalEvent* events_array, int max_events)
 {
-    if (!events_array || max_events <= 0) {
-        return 0;
+    if (!reader || !events_array || max_events <= 0) {
+        return -1;
     }
-    
-    std::lock_guard<std::mutex> lock(g_queue_mutex);
-    int count = 0;
-    
-    while (!g_event_queue.empty() && count < max_events) {
-        events_array[count] = g_event_queue.front();
-        g_event_queue.pop();
-        count++;
-    }
-    
-    return count;
+
+    return (int)reader->reader.Read(events_array, (size_t)max_events);
+}
+
+PROCESS_MONITOR_API const char* pm_journal_reader_get_name(pm_journal_reader_t* reader, unsigned int name_id)
+{
+    if (!reader) return nullptr;
+
+    return reader->reader.Name(name_id);
 }
 
 PROCESS_MONITOR_API void cleanup_process_monitor()
@@ -479,27 +1808,29 @@ PROCESS_MONITOR_API void cleanup_process_monitor()
         // Cleanup already in progress, don't do it again
         return;
     }
-    
+
     try {
         // Stop monitoring first (non-blocking)
+        unsubscribe_context(g_default_context);
+        g_default_context->ClearDeliveryTargets();
         if (g_monitoring) {
-            g_monitoring = false;
+            stop_backend();
         }
-        
+
         // Wait for thread to finish safely
         if (g_monitor_thread.joinable()) {
             try {
                 // Give thread time to see the stop signal
-                Sleep(100);
-                
-                // Try to join with timeout
-                auto start_time = GetTickCount64();
-                while (g_monitor_thread.joinable() && (GetTickCount64() - start_time) < 1000) {
-                    Sleep(50);
+                auto start_time = std::chrono::steady_clock::now();
+                while (g_monitor_thread_running && std::chrono::steady_clock::now() - start_time < std::chrono::milliseconds(1000)) {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+                }
+
+                // Join if it finished, otherwise detach it (don't force terminate)
+                if (!g_monitor_thread_running) {
+                    g_monitor_thread.join();
                 }
-                
-                // If still running, detach it (don't force terminate)
-                if (g_monitor_thread.joinable()) {
+                else {
                     g_monitor_thread.detach();
                 }
             }
@@ -515,54 +1846,30 @@ PROCESS_MONITOR_API void cleanup_process_monitor()
                 }
             }
         }
-        
-        // Clean up any remaining event sink (if the thread didn't finish cleanly)
-        if (g_event_sink) {
+
+        // Clean up any remaining event source (if the thread didn't finish cleanly)
+        if (g_event_source) {
             try {
-                g_event_sink->Cleanup();
-                delete g_event_sink;
+                g_event_source->Cleanup();
             }
             catch (...) {
-                // Ignore cleanup errors - just set to null
+                // Ignore cleanup errors
             }
-            g_event_sink = nullptr;
         }
-        
+
         // Clear the queue safely
         try {
-            std::lock_guard<std::mutex> lock(g_queue_mutex);
-            while (!g_event_queue.empty()) {
-                g_event_queue.pop();
-            }
+            unmap_event_ring();
+            g_default_context->Queue().Clear();
         }
         catch (...) {
             // Ignore queue cleanup errors
         }
-        
+
         // Clean up event handle
-        if (g_event_available != nullptr) {
-            try {
-                CloseHandle(g_event_available);
-            }
-            catch (...) {
-                // Ignore handle cleanup errors
-            }
-            g_event_available = nullptr;
-        }
-        
-        // Clean up COM if we initialized it - but only if we're not in DLL unload
-        if (g_com_initialized.exchange(false)) {
-            try {
-                // Don't uninitialize COM during process shutdown - can cause crashes
-                // Just mark it as cleaned up
-                // CoUninitialize();
-            }
-            catch (...) {
-                // Ignore any COM cleanup errors
-            }
-        }
-        
-        g_last_error.clear();
+        g_default_context->Signal().Close();
+
+        clear_last_error();
     }
     catch (...) {
         // Ignore all cleanup errors to prevent crashes during app shutdown
@@ -571,7 +1878,10 @@ PROCESS_MONITOR_API void cleanup_process_monitor()
 
 PROCESS_MONITOR_API const char* get_last_error()
 {
-    return g_last_error.c_str();
+    // Copied, since another thread may replace the error at any time
+    static thread_local std::string error;
+    error = copy_last_error();
+    return error.c_str();
 }
 
-} // extern "C"
\ No newline at end of file
+} // extern "C"
@@ -8,7 +8,7 @@
     #define PROCESS_MONITOR_API __declspec(dllimport)
   #endif
 #else
-  #define PROCESS_MONITOR_API
+  #define PROCESS_MONITOR_API __attribute__((visibility("default")))
 #endif
 
 #ifdef __cplusplus
@@ -17,15 +17,213 @@ extern "C" {
 
 // Process event structure for FFI
 typedef struct {
-    char event_type[32];     // "start" or "stop"
+    char event_type[32];     // "start", "stop", "first_start" or "last_stop"
     char process_name[512];  // Process name
     int process_id;          // Process ID
     long long timestamp_ms;  // Timestamp in milliseconds since epoch
 } ProcessEventData;
 
+// Kind of a CompactProcessEvent
+typedef enum {
+    PROCESS_EVENT_START = 1,
+    PROCESS_EVENT_STOP = 2,
+    PROCESS_EVENT_FIRST_START = 3, // First running instance of a name started
+    PROCESS_EVENT_LAST_STOP = 4,   // Last running instance of a name stopped
+} ProcessEventType;
+
+// Which events are queued (flags for set_event_delivery)
+typedef enum {
+    PROCESS_EVENTS_RAW = 1,      // A start or stop for every process (default)
+    PROCESS_EVENTS_EDGES = 2,    // PROCESS_EVENT_FIRST_START / PROCESS_EVENT_LAST_STOP per name
+} ProcessEventDelivery;
+
+// 32-byte process event; the name is an ID resolved once per distinct name with get_process_name
+typedef struct {
+    long long timestamp_ms;      // When the event happened (as the kernel reports it where the source allows), in milliseconds since epoch
+    int process_id;              // Process ID
+    int parent_process_id;       // Parent process ID (0 if unknown)
+    unsigned int name_id;        // Process name ID (0 if the name is unknown)
+    unsigned char event_type;    // ProcessEventType
+    unsigned char reserved[3];
+    long long start_time_ms;     // Process start time in milliseconds since epoch (0 if unknown)
+} CompactProcessEvent;
+
+// A CompactProcessEvent with the times it passed through the library, in nanoseconds on the
+// clock of get_monotonic_time_ns (CLOCK_MONOTONIC on Linux, QueryPerformanceCounter on Windows).
+// Their differences give the detection latency of each event: kernel to ingest to consumer.
+typedef struct {
+    CompactProcessEvent event;
+    long long kernel_time_ns;    // When the kernel reported the event (proc connector) or WMI created it (0 if unknown)
+    long long ingest_time_ns;    // When the library received the event from its source
+    long long dequeue_time_ns;   // When a *_timed read handed the event to the consumer (0 until then)
+} TimedProcessEvent;
+
+// 64-bit key naming one process for its whole life, where a PID alone may name a later process
+// once the system reuses it. The low 32 bits are the PID and the high 32 bits are the low 32 bits
+// of the start time in milliseconds (0 when the start time is unknown, in which case the key only
+// names the PID). Every CompactProcessEvent and ProcessSnapshotEntry carries both halves.
+typedef unsigned long long ProcessKey;
+
+static inline ProcessKey make_process_key(int process_id, long long start_time_ms)
+{
+    return ((ProcessKey)(unsigned int)start_time_ms << 32) | (unsigned int)process_id;
+}
+
+// A running process as listed by snapshot_processes
+typedef struct {
+    long long start_time_ms;     // Process start time in milliseconds since epoch (0 if unknown)
+    int process_id;              // Process ID
+    int parent_process_id;       // Parent process ID (0 if unknown)
+    unsigned int name_id;        // Process name ID (0 if the name is unknown), see get_process_name
+    unsigned int reserved;
+} ProcessSnapshotEntry;
+
+// Fields of a ProcessDetails (flags for get_process_details)
+typedef enum {
+    PROCESS_DETAIL_EXE_PATH = 1,
+    PROCESS_DETAIL_COMMAND_LINE = 2,
+    PROCESS_DETAIL_USER_ID = 4,
+    PROCESS_DETAIL_START_TIME = 8,
+} ProcessDetailField;
+
+// Details of a process as filled by get_process_details; the strings point into the caller's buffer
+typedef struct {
+    long long start_time_ms;     // Process start time in milliseconds since epoch
+    long long user_id;           // Real user ID on Linux, RID of the owner's SID on Windows (-1 if unknown)
+    const char* exe_path;        // Full path of the executable (UTF-8)
+    const char* command_line;    // Command line, arguments separated by spaces on Linux (UTF-8)
+    int fields;                  // ProcessDetailField flags of the fields filled in
+    int reserved;
+} ProcessDetails;
+
+// Process name table counters
+typedef struct {
+    long long name_count;        // Distinct names (highest name ID)
+    long long memory_bytes;      // Approximate memory held by the table
+    long long lookups;           // Names looked up by the event sources
+    long long inserts;           // Lookups that added a new name (the only ones that convert or copy it)
+} ProcessNameTableStats;
+
+// Deduplication counters, cumulative for the library's lifetime
+typedef struct {
+    long long checked;           // Events checked
+    long long duplicates;        // Events dropped as repeats within the window
+    long long evicted;           // Live entries replaced because the table was crowded
+    int window_ms;               // Current window (0 = disabled)
+} EventDedupStats;
+
+// Backends that can produce process events
+typedef enum {
+    PROCESS_EVENT_SOURCE_AUTO = 0,           // Platform default: WMI on Windows, proc connector with /proc scan fallback on Linux
+    PROCESS_EVENT_SOURCE_WMI = 1,            // Windows WMI notification queries
+    PROCESS_EVENT_SOURCE_PROC_CONNECTOR = 2, // Linux netlink proc connector (needs CAP_NET_ADMIN)
+    PROCESS_EVENT_SOURCE_PROC_SCAN = 3,      // Linux /proc scanning on an interval (unprivileged)
+    PROCESS_EVENT_SOURCE_SYNTHETIC = 4,      // Generated starts and stops at a set rate, for load testing (any platform)
+    PROCESS_EVENT_SOURCE_REPLAY = 5,         // Events replayed from a trace file, for reproducing incidents (any platform)
+} ProcessEventSourceType;
+
+// Cost of the /proc scanning backend, updated after every scan
+typedef struct {
+    long long scan_count;        // Scans completed since monitoring started
+    int process_count;           // Processes seen by the last scan
+    int started_count;           // Processes that appeared in the last scan
+    int exited_count;            // Processes that disappeared in the last scan
+    int syscall_count;           // Syscalls made by the last scan
+    long long duration_us;       // Wall time of the last scan in microseconds
+} ProcScanStats;
+
+// What happens to an event that arrives while the event queue is full
+typedef enum {
+    EVENT_QUEUE_OVERWRITE_OLDEST = 0, // Discard the oldest queued event (default)
+    EVENT_QUEUE_DROP_NEWEST = 1,      // Discard the arriving event
+} EventQueueOverflowPolicy;
+
+// Event queue counters, cumulative since the queue was last resized
+typedef struct {
+    long long capacity;          // Slots in the queue (requested capacity rounded up to a power of two)
+    long long pending;           // Events waiting to be read
+    long long high_water_mark;   // Most events ever waiting at once
+    long long dropped;           // Events discarded on arrival (EVENT_QUEUE_DROP_NEWEST)
+    long long overwritten;       // Queued events discarded to make room (EVENT_QUEUE_OVERWRITE_OLDEST)
+} EventQueueStats;
+
+// Broadcast subscriber counters, cumulative since the subscriber was created
+typedef struct {
+    long long capacity;          // Slots in the shared broadcast ring
+    long long pending;           // Events published but not yet read by this subscriber
+    long long read;              // Events read by this subscriber
+    long long lost;              // Events overwritten before this subscriber read them
+} BroadcastSubscriberStats;
+
+#define MONITOR_LATENCY_BUCKETS 160
+
+// Latency distribution. Bucket b counts latencies from get_latency_bucket_floor_ns(b) up to
+// get_latency_bucket_floor_ns(b + 1): exact below 8 ns, then 4 buckets per power of two, the
+// last one also holding anything longer. Percentiles are the top of the bucket they fall in.
+typedef struct {
+    long long count;             // Latencies recorded
+    long long sum_ns;            // Their sum, for the mean
+    long long max_ns;            // Longest latency recorded
+    long long p50_ns;
+    long long p90_ns;
+    long long p99_ns;
+    long long p999_ns;
+    long long buckets[MONITOR_LATENCY_BUCKETS];
+} LatencyHistogram;
+
+// Counters of the whole event pipeline, cumulative for the library's lifetime. An event that
+// reaches several consumers (contexts, subscribers) is filtered, dropped or delivered once per consumer.
+typedef struct {
+    long long ingested;              // Events received from the event sources
+    long long filtered;              // Events a consumer's watch set, descendant limit or delivery mode kept out of its raw stream
+    long long deduplicated;          // Events dropped as repeats within the dedup window
+    long long dropped;               // Records discarded by a full queue, or overwritten before a subscriber read them
+    long long delivered;             // Records read from a queue or subscriber, or handed to a callback or Dart port
+    long long queue_high_water_mark; // Most records ever waiting in any one queue
+    LatencyHistogram kernel_to_ingest;   // From the kernel's timestamp to the library receiving the event (where the source has one)
+    LatencyHistogram ingest_to_dequeue;  // From the library receiving the event to a consumer reading it from a queue or subscriber, or the per-event callback getting it
+} MonitorStats;
+
+// Counters of a pm_journal, cumulative since it was opened
+typedef struct {
+    long long events_written;    // Events appended to the journal
+    long long events_lost;       // Events the journal missed, by falling behind or failing to create a segment (their sequence numbers are skipped)
+    long long bytes_written;     // Entry bytes appended, names included
+    long long segments_created;  // Segment files started, the first one included
+    long long commits;           // Flushes to disk, each covering every event written since the one before
+} JournalStats;
+
+// An event read back from a journal by pm_journal_reader_read
+typedef struct {
+    long long sequence;          // Position in the journal; consecutive events differ by 1 unless the journal missed some
+    CompactProcessEvent event;   // name_id is resolved with pm_journal_reader_get_name, not get_process_name
+} JournalEvent;
+
+// Header of the event queue as returned by map_event_ring; slots follow at slots_offset.
+// Slot i holds the event for index n (n % capacity == i) once the 64-bit sequence at the
+// start of the slot equals n + 1. The record itself is at record_offset within the slot.
+typedef struct {
+    unsigned int magic;                  // 0x47524D50
+    unsigned int version;                // 1
+    unsigned int capacity;               // Slot count, a power of two
+    unsigned int slot_size;              // Bytes per slot
+    unsigned int slots_offset;           // Offset of slot 0 from the start of the header
+    unsigned int record_offset;          // Offset of the record within a slot
+    unsigned int record_size;            // Bytes per record
+    unsigned int record_format;          // 1: CompactProcessEvent, 2: TimedProcessEvent (starts with a CompactProcessEvent)
+    unsigned char reserved[32];
+    unsigned long long write_index;      // Next index producers will write
+    unsigned char write_padding[56];
+    unsigned long long read_index;       // Next index to be released
+    unsigned char read_padding[56];
+} ProcessEventRingHeader;
+
 // Callback function type for process events
 typedef void (*ProcessEventCallback)(const ProcessEventData* event_data, void* user_data);
 
+// Callback function type for batches of process events; events is valid only during the call
+typedef void (*ProcessEventBatchCallback)(const CompactProcessEvent* events, int count, void* user_data);
+
 // Initialize the process monitor
 PROCESS_MONITOR_API bool initialize_process_monitor();
 
@@ -35,16 +233,122 @@ PROCESS_MONITOR_API bool start_monitoring();
 // Start monitoring with callback (immediate notification)
 PROCESS_MONITOR_API bool start_monitoring_with_callback(ProcessEventCallback callback, void* user_data);
 
+// Start monitoring with a batch callback. Events are gathered and passed to the callback, from a thread
+// of its own, as soon as max_events are waiting or the oldest has waited max_delay_us, whichever is first.
+// Events are not queued in this mode.
+PROCESS_MONITOR_API bool start_monitoring_with_batch_callback(ProcessEventBatchCallback callback, int max_events, int max_delay_us, void* user_data);
+
+// Start monitoring and post events straight to a Dart ReceivePort from the thread that produces them,
+// instead of queueing them. api_dl_data is NativeApi.initializeApiDLData and port is
+// ReceivePort.sendPort.nativePort. Each message is a Uint8List of CompactProcessEvent records: an
+// event and the edges it caused (see set_event_delivery).
+PROCESS_MONITOR_API bool start_monitoring_with_native_port(void* api_dl_data, long long port);
+
 // Stop monitoring processes
 PROCESS_MONITOR_API bool stop_monitoring();
 
+// Select the backend used by the next start_monitoring call (default PROCESS_EVENT_SOURCE_AUTO)
+PROCESS_MONITOR_API bool set_event_source(int source_type);
+
+// Get the backend in use, as a ProcessEventSourceType (-1 if not monitoring)
+PROCESS_MONITOR_API int get_active_event_source();
+
+// Set the interval between /proc scans for the scanning backend (default 1000 ms)
+PROCESS_MONITOR_API bool set_proc_scan_interval(int interval_ms);
+
+// Rate of PROCESS_EVENT_SOURCE_SYNTHETIC at a multiplier of 1 (default 1000 events/s), and how many
+// events it generates before going quiet (0 for no limit). The processes are named synthetic-0 to
+// synthetic-63, are children of the calling process, and use PIDs above 2^30. Not allowed while monitoring.
+PROCESS_MONITOR_API bool set_synthetic_event_rate(int events_per_second, long long event_count);
+
+// Trace replayed by PROCESS_EVENT_SOURCE_REPLAY: a text file with one event per line,
+//   time_ms start|stop pid parent_pid start_time_ms name
+// where time_ms is when the event was recorded (any epoch; only the spacing is kept) and the name
+// runs to the end of the line. Blank lines and lines starting with # are skipped. The trace is read
+// when monitoring starts. A path naming a journal directory (see pm_journal_open) replays the
+// events kept there instead, spaced by their timestamp_ms. Not allowed while monitoring.
+PROCESS_MONITOR_API bool set_replay_trace(const char* path);
+
+// Speed of the synthetic and replay sources relative to their recorded or configured pace
+// (default 1; 10 runs ten times faster; 0 as fast as possible). Not allowed while monitoring.
+PROCESS_MONITOR_API bool set_event_rate_multiplier(double multiplier);
+
+// Report exits of processes with these names (case-insensitive) the moment they happen, using one
+// pidfd per process in a single epoll set (Linux 5.3+). exe_paths may be NULL, or narrow names to
+// executables like set_process_watch_set's. Stop events for these processes then come only from the
+// exit watcher. Pass count 0 to turn it off. Takes effect on the next start_monitoring call.
+PROCESS_MONITOR_API bool set_exit_watch_list(const char** process_names, const char** exe_paths, int count);
+
+// Only queue events for processes with these names (case-insensitive). exe_paths may be NULL; a
+// non-empty exe_paths[i] narrows process_names[i] to that executable (the same name can be passed
+// once per path). Stop events are delivered for delivered starts and for names watched from any
+// path. Pass count 0 to deliver every event again (the default). Takes effect immediately.
+PROCESS_MONITOR_API bool set_process_watch_set(const char** process_names, const char** exe_paths, int count);
+
+// Keep delivering every event while a watch set is registered (default false)
+PROCESS_MONITOR_API void set_deliver_all_events(bool deliver_all);
+
+// Choose which events are queued, as ProcessEventDelivery flags (default PROCESS_EVENTS_RAW). Edges are
+// computed from the running instances of each name in the watch set registered when monitoring starts
+// (every name if there is none), seeded from the processes already running. Not allowed while monitoring.
+PROCESS_MONITOR_API bool set_event_delivery(int flags);
+
+// Drop repeats of an event (same type, PID, process start time and name) seen within window_ms
+// before they are queued. Default 1000 ms; 0 disables deduplication.
+PROCESS_MONITOR_API bool set_dedup_window(int window_ms);
+
+// Get the deduplication counters
+PROCESS_MONITOR_API bool get_dedup_stats(EventDedupStats* stats);
+
+// Get the cost of the most recent /proc scan (returns false if no scan has run)
+PROCESS_MONITOR_API bool get_proc_scan_stats(ProcScanStats* stats);
+
+// Resize the event queue (default 1024 slots, overwrite oldest). Discards queued events; not allowed while monitoring
+PROCESS_MONITOR_API bool set_event_queue_capacity(int capacity, int overflow_policy);
+
+// Get the event queue counters
+PROCESS_MONITOR_API bool get_event_queue_stats(EventQueueStats* stats);
+
+// Get the pipeline counters and latency histograms
+PROCESS_MONITOR_API bool get_monitor_stats(MonitorStats* stats);
+
+// Lower bound of a LatencyHistogram bucket in nanoseconds (MONITOR_LATENCY_BUCKETS gives the end of the last one)
+PROCESS_MONITOR_API long long get_latency_bucket_floor_ns(int bucket);
+
+// Map the event queue read-only for in-place reading (returns NULL on failure). While mapped the
+// queue drops new events when full instead of overwriting ones that may be being read, and
+// the get_next_event/get_all_events/wait_and_drain calls must not be used. Valid until unmap_event_ring or a resize.
+PROCESS_MONITOR_API const ProcessEventRingHeader* map_event_ring();
+
+// Get the events ready for in-place reading: stores the index of the first in first_index and
+// returns how many consecutive events (up to max_events) can be read starting there
+PROCESS_MONITOR_API int acquire_mapped_events(long long* first_index, int max_events);
+
+// Hand back the first count acquired events so their slots can be reused; returns how many were released
+PROCESS_MONITOR_API int release_mapped_events(int count);
+
+// Stop in-place reading and restore the queue's overflow policy
+PROCESS_MONITOR_API void unmap_event_ring();
+
 // Get the next available process event (returns false if no events)
 PROCESS_MONITOR_API bool get_next_event(ProcessEventData* event_data);
 
-// Wait for new events (blocks until events are available or timeout)
+// Wait for new events (blocks until events are available or timeout; a negative timeout waits until
+// events arrive or monitoring stops). Returns immediately if events are already queued.
 // Returns number of events available, or 0 on timeout, -1 on error
 PROCESS_MONITOR_API int wait_for_events(int timeout_ms);
 
+// Wait for events and copy up to max_events of them into events_array in one call. Returns as soon as
+// any are queued, with no wakeups while idle (a negative timeout waits until events arrive or monitoring
+// stops). Returns the number of events copied, 0 on timeout or once monitoring has stopped, -1 on error
+PROCESS_MONITOR_API int wait_and_drain(CompactProcessEvent* events_array, int max_events, int timeout_ms);
+
+// Same as wait_and_drain, with the timestamps of each event; dequeue_time_ns is set as the events are copied
+PROCESS_MONITOR_API int wait_and_drain_timed(TimedProcessEvent* events_array, int max_events, int timeout_ms);
+
+// Current time on the clock of the TimedProcessEvent timestamps, in nanoseconds
+PROCESS_MONITOR_API long long get_monotonic_time_ns();
+
 // Get all available events at once (up to max_events)
 // Returns actual number of events retrieved
 PROCESS_MONITOR_API int get_all_events(ProcessEventData* events_array, int max_events);
@@ -58,9 +362,182 @@ PROCESS_MONITOR_API int get_pending_event_count();
 // Cleanup and release resources
 PROCESS_MONITOR_API void cleanup_process_monitor();
 
-// Get the last error message (if any)
+// Get all available events as compact records (up to max_events)
+// Returns actual number of events retrieved
+PROCESS_MONITOR_API int get_all_events_compact(CompactProcessEvent* events_array, int max_events);
+
+// Resolve a name ID to its UTF-8 process name. IDs and the returned strings stay valid until the
+// library is unloaded, so callers can cache them. Returns NULL for an unknown ID.
+PROCESS_MONITOR_API const char* get_process_name(unsigned int name_id);
+
+// Get the number of distinct process names seen so far (the highest name ID)
+PROCESS_MONITOR_API int get_process_name_count();
+
+// Get the process name table counters
+PROCESS_MONITOR_API bool get_process_name_table_stats(ProcessNameTableStats* stats);
+
+// Get the last error message (if any). The string stays valid until the next call of this
+// function on the same thread.
 PROCESS_MONITOR_API const char* get_last_error();
 
+// Running processes. While monitoring these are answered from a table that is filled from one
+// system snapshot when the event source starts listening and then kept current by the events,
+// so the table plus the events that follow it miss nothing and no call rescans the system.
+// A call made while monitoring is still starting waits for the table; without monitoring each
+// call takes a fresh snapshot.
+
+// Copy up to max_entries running processes into entries. Returns how many processes are running
+// (call again with a larger buffer if that is more than max_entries), or -1 on failure.
+PROCESS_MONITOR_API int snapshot_processes(ProcessSnapshotEntry* entries, int max_entries);
+
+// Whether a process with this name is running (names match like set_process_watch_set entries)
+PROCESS_MONITOR_API bool is_running(const char* process_name);
+
+// Copy up to max_pids IDs of processes running under this name into pids. Returns how many are
+// running, or -1 on failure.
+PROCESS_MONITOR_API int pids_of(const char* process_name, int* pids, int max_pids);
+
+// Process tree, kept from the same snapshot and events. A process that exits stays in the tree
+// while it has running descendants, so they still trace back through it (a build's shells, say).
+
+// Copy up to max_ancestors PIDs of the ancestors of process_id, parent first, into ancestors.
+// Returns how many ancestors are known, or -1 on failure.
+PROCESS_MONITOR_API int get_process_ancestors(int process_id, int* ancestors, int max_ancestors);
+
+// Copy up to max_descendants PIDs of the running descendants of process_id into descendants.
+// Returns how many there are, or -1 on failure.
+PROCESS_MONITOR_API int get_process_descendants(int process_id, int* descendants, int max_descendants);
+
+// Only queue events for root_process_id and the processes it starts, directly or not (0 to
+// queue events for all processes). Applies together with the watch set; takes effect immediately.
+PROCESS_MONITOR_API bool set_descendant_filter(int root_process_id);
+
+// Get details of the process an event refers to, named by its process_id and start_time_ms (0 for
+// whichever process has the PID now, which always asks the system). Only the ProcessDetailField
+// flags in fields_mask are fetched, each at most once per process: later calls are answered from a
+// cache, and so are calls after the process has exited for fields read or captured while it ran
+// (the executable path is captured when a process starts). Fields that couldn't be read are left
+// out of details->fields. The strings are copied into buffer. Returns the bytes the strings need
+// (if that is more than buffer_size they aren't copied; call again with a larger buffer), or -1
+// if the process is unknown and not running.
+PROCESS_MONITOR_API int get_process_details(int process_id, long long start_time_ms, int fields_mask, ProcessDetails* details, char* buffer, int buffer_size);
+
+// Independent monitor contexts. Each context has its own event queue, watch set, event delivery
+// flags and last error, and every started context (and the API above, which uses a context of
+// its own) shares one event source. The source settings above (set_event_source,
+// set_proc_scan_interval, set_exit_watch_list, set_dedup_window) apply to all of them.
+typedef struct pm_context pm_context_t;
+
+// Create a context with its own queue of queue_capacity events (0 for the default of 1024).
+// Returns NULL on failure (see get_last_error).
+PROCESS_MONITOR_API pm_context_t* pm_context_create(int queue_capacity);
+
+// Stop the context if it is started and free it
+PROCESS_MONITOR_API void pm_context_destroy(pm_context_t* context);
+
+// Same as set_process_watch_set, for this context only. Takes effect immediately.
+PROCESS_MONITOR_API bool pm_context_set_watch_set(pm_context_t* context, const char** process_names, const char** exe_paths, int count);
+
+// Same as set_descendant_filter, for this context only
+PROCESS_MONITOR_API bool pm_context_set_descendant_filter(pm_context_t* context, int root_process_id);
+
+// Same as set_event_delivery, for this context only. Not allowed while the context is started.
+PROCESS_MONITOR_API bool pm_context_set_event_delivery(pm_context_t* context, int flags);
+
+// Start queueing events for this context, starting the event source if no other context uses it
+PROCESS_MONITOR_API bool pm_context_start(pm_context_t* context);
+
+// Stop queueing events for this context; the event source stops with its last context
+PROCESS_MONITOR_API bool pm_context_stop(pm_context_t* context);
+
+// Same as wait_and_drain, on this context's queue
+PROCESS_MONITOR_API int pm_context_drain(pm_context_t* context, CompactProcessEvent* events_array, int max_events, int timeout_ms);
+
+// Same as wait_and_drain_timed, on this context's queue
+PROCESS_MONITOR_API int pm_context_drain_timed(pm_context_t* context, TimedProcessEvent* events_array, int max_events, int timeout_ms);
+
+// Get the counters of this context's queue
+PROCESS_MONITOR_API bool pm_context_get_queue_stats(pm_context_t* context, EventQueueStats* stats);
+
+// Get the last error of a call on this context, or of the event source it was started on. The
+// string stays valid until the next call of this function on the same thread.
+PROCESS_MONITOR_API const char* pm_context_get_last_error(pm_context_t* context);
+
+// Broadcast subscribers. Every subscriber reads every event (deduplicated, before any watch set)
+// from one shared ring through its own cursor, so readers don't take events from each other and
+// an extra subscriber costs no copy on the producer side. The producer never waits for a slow
+// subscriber: one that falls more than the ring's capacity behind loses the oldest events and
+// is told how many. Subscribers keep the event source running like started contexts do.
+typedef struct pm_subscriber pm_subscriber_t;
+
+// Subscribe to events published from now on. Returns NULL on failure (see get_last_error).
+PROCESS_MONITOR_API pm_subscriber_t* pm_subscribe();
+
+// Free a subscriber; the event source stops with its last context or subscriber
+PROCESS_MONITOR_API void pm_unsubscribe(pm_subscriber_t* subscriber);
+
+// Read up to max_events events, waiting up to timeout_ms (negative waits until events arrive or
+// monitoring stops) when none are unread. If lost_events is not NULL it receives the number of
+// events overwritten before they could be read since the previous call. Returns the number
+// read, 0 on timeout or stop, or -1 on error. Only one thread may read a subscriber at a time.
+PROCESS_MONITOR_API int pm_subscriber_read(pm_subscriber_t* subscriber, CompactProcessEvent* events_array, int max_events, int timeout_ms, long long* lost_events);
+
+// Same as pm_subscriber_read, with the timestamps of each event
+PROCESS_MONITOR_API int pm_subscriber_read_timed(pm_subscriber_t* subscriber, TimedProcessEvent* events_array, int max_events, int timeout_ms, long long* lost_events);
+
+// Get this subscriber's counters
+PROCESS_MONITOR_API bool pm_subscriber_get_stats(pm_subscriber_t* subscriber, BroadcastSubscriberStats* stats);
+
+// Event journal. A journal appends every event (deduplicated, before any watch set) to a
+// directory of memory-mapped segment files, 48 bytes per event plus each name once per segment,
+// starting a new segment when one is full. It reads the events as a broadcast subscriber from a
+// thread of its own, so the event source never waits for the disk: a journal that falls behind
+// loses events like any subscriber, and skips their sequence numbers. Events are visible to
+// readers as soon as the journal thread has written them, and flushed to disk together once
+// per commit interval. Journals keep the event source running like subscribers do. Only one
+// journal may write to a directory at a time; reopening a directory continues its sequence.
+typedef struct pm_journal pm_journal_t;
+
+// Start journaling to directory (created if missing). segment_size is the size of each segment
+// file in bytes (0 for the default of 16 MB, at least 64 KB), max_segments the number of segments
+// to keep, deleting the oldest beyond it (0 keeps all), and commit_interval_ms the time between
+// flushes to disk (0 for the default of 100 ms). Returns NULL on failure (see get_last_error).
+PROCESS_MONITOR_API pm_journal_t* pm_journal_open(const char* directory, long long segment_size, int max_segments, int commit_interval_ms);
+
+// Write out and flush the events already published, close the journal and free it
+PROCESS_MONITOR_API void pm_journal_close(pm_journal_t* journal);
+
+// Get this journal's counters
+PROCESS_MONITOR_API bool pm_journal_get_stats(pm_journal_t* journal, JournalStats* stats);
+
+// Get the last error of this journal's thread, e.g. a segment it failed to create. The string
+// stays valid until the next call of this function on the same thread.
+PROCESS_MONITOR_API const char* pm_journal_get_last_error(pm_journal_t* journal);
+
+// Reader of a journal directory, written now or earlier, in this process or another. A reader
+// starts at the oldest event kept and can be moved with the seek calls; reading past the newest
+// event returns 0 until the journal writes more. Only one thread may use a reader at a time.
+typedef struct pm_journal_reader pm_journal_reader_t;
+
+// Open the journal in directory for reading. Returns NULL if it has no segments (see get_last_error).
+PROCESS_MONITOR_API pm_journal_reader_t* pm_journal_reader_open(const char* directory);
+
+// Free a reader
+PROCESS_MONITOR_API void pm_journal_reader_close(pm_journal_reader_t* reader);
+
+// Move the reader to the first event with a sequence number at or after sequence
+PROCESS_MONITOR_API bool pm_journal_reader_seek_sequence(pm_journal_reader_t* reader, long long sequence);
+
+// Move the reader to the first event, in journal order, with a timestamp_ms at or after timestamp_ms
+PROCESS_MONITOR_API bool pm_journal_reader_seek_time(pm_journal_reader_t* reader, long long timestamp_ms);
+
+// Read up to max_events events from the reader's position. Returns the number read (0 at the
+// end of the journal) or -1 on error.
+PROCESS_MONITOR_API int pm_journal_reader_read(pm_journal_reader_t* reader, JournalEvent* events_array, int max_events);
+
+// Get the name for a name_id returned by this reader (valid until the reader is closed), or NULL
+PROCESS_MONITOR_API const char* pm_journal_reader_get_name(pm_journal_reader_t* reader, unsigned int name_id);
+
 #ifdef __cplusplus
 }
 #endif
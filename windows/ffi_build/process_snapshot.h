@@ -0,0 +1,20 @@
+#ifndef PROCESS_SNAPSHOT_H_
+#define PROCESS_SNAPSHOT_H_
+
+#include <string>
+#include <vector>
+
+// A process found running when monitoring started
+struct RunningProcess
+{
+    int pid = 0;
+    int parent_pid = 0;
+    long long start_time_ms = 0; // 0 if unknown
+    std::string name;
+};
+
+// Lists the processes running right now. Returns false (after set_last_error) on failure.
+// Implemented once per platform.
+bool list_running_processes(std::vector<RunningProcess> *processes);
+
+#endif // PROCESS_SNAPSHOT_H_
@@ -0,0 +1,168 @@
+#include "process_table.h"
+#include "event_source.h"
+#include "process_key.h"
+#include "watch_list.h"
+
+#include <mutex>
+
+bool ProcessTable::Load(std::vector<RunningProcess> *processes)
+{
+    std::unique_lock<std::shared_mutex> lock(m_mutex);
+    m_processes.clear();
+    m_names.clear();
+    m_tree.Clear();
+    if (!list_running_processes(processes))
+        return false;
+
+    m_processes.reserve(processes->size());
+    for (const RunningProcess &process : *processes)
+    {
+        ProcessSnapshotEntry entry = {};
+        entry.process_id = process.pid;
+        entry.parent_process_id = process.parent_pid;
+        entry.name_id = intern_process_name(process.name);
+        entry.start_time_ms = process.start_time_ms;
+        AddLocked(entry);
+    }
+    m_tree.Seed(*processes);
+    return true;
+}
+
+void ProcessTable::Clear()
+{
+    std::unique_lock<std::shared_mutex> lock(m_mutex);
+    m_processes.clear();
+    m_names.clear();
+    m_tree.Clear();
+}
+
+void ProcessTable::Observe(const CompactProcessEvent &event)
+{
+    std::unique_lock<std::shared_mutex> lock(m_mutex);
+    if (event.event_type == PROCESS_EVENT_START)
+    {
+        // Also covers an exec under a new name and a reused PID: the newest start wins
+        ProcessSnapshotEntry entry = {};
+        entry.process_id = event.process_id;
+        entry.parent_process_id = event.parent_process_id;
+        entry.name_id = event.name_id;
+        entry.start_time_ms = event.start_time_ms;
+        RemoveLocked(event.process_id);
+        AddLocked(entry);
+        m_tree.AddProcess(event.process_id, event.parent_process_id, event.start_time_ms);
+    }
+    else if (event.event_type == PROCESS_EVENT_STOP)
+    {
+        // A late stop for an earlier holder of the PID leaves the current one alone
+        auto known = m_processes.find(event.process_id);
+        if (known != m_processes.end() && !process_keys_match(make_process_key(event.process_id, known->second.start_time_ms), process_key(event)))
+            return;
+
+        RemoveLocked(event.process_id);
+        m_tree.RemoveProcess(event.process_id, event.start_time_ms);
+    }
+}
+
+void ProcessTable::ObserveFork(int pid, int parent_pid)
+{
+    std::unique_lock<std::shared_mutex> lock(m_mutex);
+    m_tree.AddProcess(pid, parent_pid, 0);
+}
+
+bool ProcessTable::Contains(ProcessKey key) const
+{
+    std::shared_lock<std::shared_mutex> lock(m_mutex);
+    auto known = m_processes.find(process_key_pid(key));
+    return known != m_processes.end() && process_keys_match(make_process_key(known->second.process_id, known->second.start_time_ms), key);
+}
+
+bool ProcessTable::Find(int pid, ProcessSnapshotEntry *entry) const
+{
+    std::shared_lock<std::shared_mutex> lock(m_mutex);
+    auto known = m_processes.find(pid);
+    if (known == m_processes.end())
+        return false;
+    *entry = known->second;
+    return true;
+}
+
+void ProcessTable::ObserveForkExit(int pid, long long start_time_ms)
+{
+    std::unique_lock<std::shared_mutex> lock(m_mutex);
+    m_tree.RemoveProcess(pid, start_time_ms);
+}
+
+size_t ProcessTable::Snapshot(ProcessSnapshotEntry *entries, size_t max_entries) const
+{
+    std::shared_lock<std::shared_mutex> lock(m_mutex);
+    size_t count = 0;
+    for (const auto &process : m_processes)
+    {
+        if (count == max_entries)
+            break;
+        entries[count++] = process.second;
+    }
+    return m_processes.size();
+}
+
+void ProcessTable::List(std::vector<RunningProcess> *processes) const
+{
+    std::shared_lock<std::shared_mutex> lock(m_mutex);
+    processes->clear();
+    processes->reserve(m_processes.size());
+    for (const auto &process : m_processes)
+    {
+        const char *name = lookup_process_name(process.second.name_id);
+        RunningProcess running;
+        running.pid = process.second.process_id;
+        running.parent_pid = process.second.parent_process_id;
+        running.start_time_ms = process.second.start_time_ms;
+        running.name = name != nullptr ? name : "";
+        processes->push_back(std::move(running));
+    }
+}
+
+size_t ProcessTable::PidsOf(const char *process_name, int *pids, size_t max_pids) const
+{
+    WatchList query;
+    query.Add(process_name, "");
+
+    // Few distinct names are running at once, so matching each beats keeping a second index by lowercased name
+    std::shared_lock<std::shared_mutex> lock(m_mutex);
+    size_t copied = 0;
+    size_t matched = 0;
+    for (const auto &name : m_names)
+    {
+        const char *candidate = lookup_process_name(name.first);
+        if (candidate == nullptr || !query.Matches(candidate))
+            continue;
+
+        for (auto pid = name.second.begin(); pid != name.second.end() && copied < max_pids; ++pid)
+            pids[copied++] = *pid;
+        matched += name.second.size();
+    }
+    return matched;
+}
+
+void ProcessTable::AddLocked(const ProcessSnapshotEntry &entry)
+{
+    m_processes[entry.process_id] = entry;
+    if (entry.name_id != 0)
+        m_names[entry.name_id].insert(entry.process_id);
+}
+
+void ProcessTable::RemoveLocked(int pid)
+{
+    auto known = m_processes.find(pid);
+    if (known == m_processes.end())
+        return;
+
+    auto name = m_names.find(known->second.name_id);
+    if (name != m_names.end())
+    {
+        name->second.erase(pid);
+        if (name->second.empty())
+            m_names.erase(name);
+    }
+    m_processes.erase(known);
+}
@@ -0,0 +1,66 @@
+#ifndef PROCESS_TABLE_H_
+#define PROCESS_TABLE_H_
+
+#include "process_monitor_api.h"
+#include "process_snapshot.h"
+#include "process_tree.h"
+
+#include <cstdint>
+#include <shared_mutex>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// Live table of running processes, seeded from one snapshot when the backend starts listening
+// and kept current by the deduplicated event stream, so point queries and snapshots never
+// rescan the system. Updated from the ingest and exit watcher threads; queries take a shared lock,
+// except on the process tree, whose readers take none.
+class ProcessTable
+{
+public:
+    // Replaces the contents with a snapshot of the running processes, also stored in `processes`.
+    // Events observed while the snapshot is taken wait for it, so each one is applied after the
+    // snapshot it may already be part of, and applying it again changes nothing. Returns false
+    // (after set_last_error) if the processes can't be listed.
+    bool Load(std::vector<RunningProcess> *processes);
+    void Clear();
+
+    // Applies a start or stop event
+    void Observe(const CompactProcessEvent &event);
+
+    // Adds a forked process to the tree only; it joins the table when it execs
+    void ObserveFork(int pid, int parent_pid);
+
+    // Removes a forked process that exited without exec'ing (so without a stop event) from the tree
+    void ObserveForkExit(int pid, long long start_time_ms);
+
+    // Whether the process is in the table: listed by the snapshot or started since
+    bool Contains(ProcessKey key) const;
+
+    // Copies the entry of the process running as `pid`, if there is one
+    bool Find(int pid, ProcessSnapshotEntry *entry) const;
+
+    // Copies up to `max_entries` processes and returns how many are running
+    size_t Snapshot(ProcessSnapshotEntry *entries, size_t max_entries) const;
+
+    // Copies the processes in the form the instance trackers are seeded from
+    void List(std::vector<RunningProcess> *processes) const;
+
+    // Parent/child index of the same processes
+    const ProcessTree &Tree() const { return m_tree; }
+
+    // Copies up to `max_pids` PIDs running under `process_name` (matched like a watch set entry)
+    // and returns how many there are
+    size_t PidsOf(const char *process_name, int *pids, size_t max_pids) const;
+
+private:
+    mutable std::shared_mutex m_mutex;
+    std::unordered_map<int, ProcessSnapshotEntry> m_processes;     // PID -> process
+    std::unordered_map<uint32_t, std::unordered_set<int>> m_names; // Name ID -> PIDs
+    ProcessTree m_tree;                                            // Written under the unique lock
+
+    void AddLocked(const ProcessSnapshotEntry &entry);
+    void RemoveLocked(int pid);
+};
+
+#endif // PROCESS_TABLE_H_
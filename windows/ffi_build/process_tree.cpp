@@ -0,0 +1,455 @@
+#include "process_tree.h"
+
+static constexpr size_t kInitialCapacity = 1024;
+
+// Bounds on reader walks, in case a concurrent change sends one around in circles
+static constexpr size_t kMaxDepth = 4096;
+static constexpr int kReadAttempts = 100;
+
+static size_t home_slot(int pid, size_t capacity)
+{
+    return ((uint32_t)pid * 2654435761u) & (capacity - 1);
+}
+
+// Keeps replaced tables alive while a reader is inside
+class ProcessTree::ReadGuard
+{
+public:
+    explicit ReadGuard(const ProcessTree &tree)
+        : m_tree(tree)
+    {
+        m_tree.m_readers.fetch_add(1, std::memory_order_seq_cst);
+        m_table = m_tree.m_table.load(std::memory_order_seq_cst);
+    }
+
+    ~ReadGuard() { m_tree.m_readers.fetch_sub(1, std::memory_order_seq_cst); }
+
+    const Table &table() const { return *m_table; }
+
+private:
+    const ProcessTree &m_tree;
+    const Table *m_table;
+};
+
+ProcessTree::ProcessTree()
+    : m_table(new Table(kInitialCapacity))
+{
+}
+
+ProcessTree::~ProcessTree()
+{
+    for (Table *table : m_retired)
+        delete table;
+    delete m_table.load();
+}
+
+bool ProcessTree::ReadNode(const Table &table, int slot, NodeView *view)
+{
+    if (slot < 0 || (size_t)slot >= table.capacity)
+        return false;
+
+    const Node &node = table.nodes[slot];
+    for (int attempt = 0; attempt < kReadAttempts; attempt++)
+    {
+        uint32_t sequence = node.sequence.load(std::memory_order_acquire);
+        if (sequence & 1)
+            continue;
+
+        view->state = node.state.load(std::memory_order_relaxed);
+        view->pid = node.pid.load(std::memory_order_relaxed);
+        view->parent = node.parent.load(std::memory_order_relaxed);
+        view->first_child = node.first_child.load(std::memory_order_relaxed);
+        view->next_sibling = node.next_sibling.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (node.sequence.load(std::memory_order_relaxed) == sequence)
+            return true;
+    }
+    return false;
+}
+
+int ProcessTree::Find(const Table &table, int pid)
+{
+    size_t mask = table.capacity - 1;
+    size_t slot = home_slot(pid, table.capacity);
+    for (size_t probes = 0; probes < table.capacity; probes++, slot = (slot + 1) & mask)
+    {
+        const Node &node = table.nodes[slot];
+        uint32_t state = node.state.load(std::memory_order_acquire);
+        if (state == kEmpty)
+            return -1;
+        if ((state == kRunning || state == kExited) && node.pid.load(std::memory_order_relaxed) == pid)
+            return (int)slot;
+    }
+    return -1;
+}
+
+void ProcessTree::BeginWrite(Node &node)
+{
+    node.sequence.store(node.sequence.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+}
+
+void ProcessTree::EndWrite(Node &node)
+{
+    node.sequence.store(node.sequence.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+void ProcessTree::Seed(const std::vector<RunningProcess> &processes)
+{
+    size_t capacity = kInitialCapacity;
+    while (capacity < processes.size() * 2)
+        capacity <<= 1;
+    m_node_count = 0;
+    Rebuild(capacity);
+
+    // Parents may be listed after their children, so link once every process is in
+    for (const RunningProcess &process : processes)
+    {
+        if (Find(WritableTable(), process.pid) < 0)
+            Insert(process.pid, process.start_time_ms);
+    }
+    Table &table = WritableTable();
+    for (const RunningProcess &process : processes)
+    {
+        if (process.parent_pid > 0 && process.parent_pid != process.pid)
+            Link(Find(table, process.pid), Find(table, process.parent_pid));
+    }
+}
+
+void ProcessTree::Clear()
+{
+    m_node_count = 0;
+    Rebuild(kInitialCapacity);
+}
+
+void ProcessTree::AddProcess(int pid, int parent_pid, long long start_time_ms)
+{
+    ReclaimRetired();
+
+    int existing = Find(WritableTable(), pid);
+    if (existing >= 0)
+    {
+        Node &node = WritableTable().nodes[existing];
+        long long known_start_ms = node.start_time_ms.load(std::memory_order_relaxed);
+        bool reused = start_time_ms != 0 && known_start_ms != 0 && start_time_ms != known_start_ms;
+
+        // An exec by a process already known from its fork or an earlier exec keeps its place
+        if (!reused && node.state.load(std::memory_order_relaxed) == kRunning)
+        {
+            if (known_start_ms == 0)
+                node.start_time_ms.store(start_time_ms, std::memory_order_relaxed);
+            return;
+        }
+
+        // The PID now belongs to a new process; the old one only stays for its descendants
+        BeginWrite(node);
+        node.state.store(kDetached, std::memory_order_release);
+        EndWrite(node);
+        EvictIfUnused(existing);
+    }
+
+    // Insert() may rebuild the table, so the parent is looked up afterwards
+    int slot = Insert(pid, start_time_ms);
+    if (parent_pid > 0 && parent_pid != pid)
+        Link(slot, Find(WritableTable(), parent_pid));
+}
+
+void ProcessTree::RemoveProcess(int pid, long long start_time_ms)
+{
+    int slot = Find(WritableTable(), pid);
+    if (slot < 0)
+        return;
+
+    // Leave a newer process with the PID alone
+    Node &node = WritableTable().nodes[slot];
+    long long known_start_ms = node.start_time_ms.load(std::memory_order_relaxed);
+    if (start_time_ms != 0 && known_start_ms != 0 && start_time_ms != known_start_ms)
+        return;
+
+    BeginWrite(node);
+    node.state.store(kExited, std::memory_order_release);
+    EndWrite(node);
+    EvictIfUnused(slot);
+}
+
+size_t ProcessTree::Ancestors(int pid, int *ancestors, size_t max_ancestors) const
+{
+    ReadGuard guard(*this);
+    const Table &table = guard.table();
+
+    NodeView view;
+    if (!ReadNode(table, Find(table, pid), &view) || view.pid != pid)
+        return 0;
+
+    size_t depth = 0;
+    while (view.parent >= 0 && depth < kMaxDepth)
+    {
+        if (!ReadNode(table, view.parent, &view) || view.state == kEmpty || view.state == kDeleted)
+            break;
+        if (depth < max_ancestors)
+            ancestors[depth] = view.pid;
+        depth++;
+    }
+    return depth;
+}
+
+size_t ProcessTree::Descendants(int pid, int *descendants, size_t max_descendants) const
+{
+    ReadGuard guard(*this);
+    const Table &table = guard.table();
+
+    NodeView view;
+    if (!ReadNode(table, Find(table, pid), &view) || view.pid != pid)
+        return 0;
+
+    // Depth-first over the child and sibling links
+    std::vector<int> pending;
+    if (view.first_child >= 0)
+        pending.push_back(view.first_child);
+
+    size_t count = 0;
+    size_t visited = 0;
+    while (!pending.empty() && visited++ < table.capacity)
+    {
+        int slot = pending.back();
+        pending.pop_back();
+        if (!ReadNode(table, slot, &view) || view.state == kEmpty || view.state == kDeleted)
+            continue;
+
+        if (view.next_sibling >= 0)
+            pending.push_back(view.next_sibling);
+        if (view.first_child >= 0)
+            pending.push_back(view.first_child);
+
+        if (view.state == kRunning)
+        {
+            if (count < max_descendants)
+                descendants[count] = view.pid;
+            count++;
+        }
+    }
+    return count;
+}
+
+bool ProcessTree::IsDescendant(int pid, int root_pid) const
+{
+    ReadGuard guard(*this);
+    const Table &table = guard.table();
+
+    NodeView view;
+    if (!ReadNode(table, Find(table, pid), &view) || view.pid != pid)
+        return false;
+
+    for (size_t depth = 0; view.parent >= 0 && depth < kMaxDepth; depth++)
+    {
+        if (!ReadNode(table, view.parent, &view) || view.state == kEmpty || view.state == kDeleted)
+            return false;
+        if (view.pid == root_pid)
+            return true;
+    }
+    return false;
+}
+
+int ProcessTree::Insert(int pid, long long start_time_ms)
+{
+    // Rebuilt before probes get long: grown if live nodes fill half of it, otherwise
+    // just cleared of evicted slots
+    Table *table = &WritableTable();
+    if ((table->used + 1) * 4 > table->capacity * 3)
+    {
+        size_t capacity = table->capacity;
+        while ((m_node_count + 1) * 2 > capacity)
+            capacity <<= 1;
+        Rebuild(capacity);
+        table = &WritableTable();
+    }
+
+    size_t mask = table->capacity - 1;
+    size_t slot = home_slot(pid, table->capacity);
+    while (true)
+    {
+        uint32_t state = table->nodes[slot].state.load(std::memory_order_relaxed);
+        if (state == kEmpty || state == kDeleted)
+            break;
+        slot = (slot + 1) & mask;
+    }
+
+    Node &node = table->nodes[slot];
+    if (node.state.load(std::memory_order_relaxed) == kEmpty)
+        table->used++;
+
+    BeginWrite(node);
+    node.pid.store(pid, std::memory_order_relaxed);
+    node.start_time_ms.store(start_time_ms, std::memory_order_relaxed);
+    node.parent.store(-1, std::memory_order_relaxed);
+    node.first_child.store(-1, std::memory_order_relaxed);
+    node.next_sibling.store(-1, std::memory_order_relaxed);
+    node.prev_sibling.store(-1, std::memory_order_relaxed);
+    node.state.store(kRunning, std::memory_order_release);
+    EndWrite(node);
+
+    m_node_count++;
+    return (int)slot;
+}
+
+void ProcessTree::Link(int child, int parent)
+{
+    if (child < 0 || parent < 0)
+        return;
+
+    Table &table = WritableTable();
+    Node &parent_node = table.nodes[parent];
+    Node &child_node = table.nodes[child];
+    int first = parent_node.first_child.load(std::memory_order_relaxed);
+
+    BeginWrite(child_node);
+    child_node.parent.store(parent, std::memory_order_relaxed);
+    child_node.prev_sibling.store(-1, std::memory_order_relaxed);
+    child_node.next_sibling.store(first, std::memory_order_relaxed);
+    EndWrite(child_node);
+
+    if (first >= 0)
+    {
+        Node &first_node = table.nodes[first];
+        BeginWrite(first_node);
+        first_node.prev_sibling.store(child, std::memory_order_relaxed);
+        EndWrite(first_node);
+    }
+
+    BeginWrite(parent_node);
+    parent_node.first_child.store(child, std::memory_order_relaxed);
+    EndWrite(parent_node);
+}
+
+void ProcessTree::Unlink(int child)
+{
+    Table &table = WritableTable();
+    Node &child_node = table.nodes[child];
+    int parent = child_node.parent.load(std::memory_order_relaxed);
+    if (parent < 0)
+        return;
+
+    int prev = child_node.prev_sibling.load(std::memory_order_relaxed);
+    int next = child_node.next_sibling.load(std::memory_order_relaxed);
+    if (prev >= 0)
+    {
+        Node &prev_node = table.nodes[prev];
+        BeginWrite(prev_node);
+        prev_node.next_sibling.store(next, std::memory_order_relaxed);
+        EndWrite(prev_node);
+    }
+    else
+    {
+        Node &parent_node = table.nodes[parent];
+        BeginWrite(parent_node);
+        parent_node.first_child.store(next, std::memory_order_relaxed);
+        EndWrite(parent_node);
+    }
+    if (next >= 0)
+    {
+        Node &next_node = table.nodes[next];
+        BeginWrite(next_node);
+        next_node.prev_sibling.store(prev, std::memory_order_relaxed);
+        EndWrite(next_node);
+    }
+
+    BeginWrite(child_node);
+    child_node.parent.store(-1, std::memory_order_relaxed);
+    child_node.prev_sibling.store(-1, std::memory_order_relaxed);
+    child_node.next_sibling.store(-1, std::memory_order_relaxed);
+    EndWrite(child_node);
+}
+
+void ProcessTree::Free(int slot)
+{
+    Unlink(slot);
+
+    Node &node = WritableTable().nodes[slot];
+    BeginWrite(node);
+    node.state.store(kDeleted, std::memory_order_release);
+    node.pid.store(0, std::memory_order_relaxed);
+    node.start_time_ms.store(0, std::memory_order_relaxed);
+    EndWrite(node);
+
+    m_node_count--;
+}
+
+void ProcessTree::EvictIfUnused(int slot)
+{
+    // Walks up while each node is exited and has nothing left below it
+    Table &table = WritableTable();
+    while (slot >= 0)
+    {
+        Node &node = table.nodes[slot];
+        if (node.state.load(std::memory_order_relaxed) == kRunning || node.first_child.load(std::memory_order_relaxed) >= 0)
+            return;
+
+        int parent = node.parent.load(std::memory_order_relaxed);
+        Free(slot);
+        slot = parent;
+    }
+}
+
+void ProcessTree::Rebuild(size_t capacity)
+{
+    Table *old_table = m_table.load(std::memory_order_relaxed);
+    Table *table = new Table(capacity);
+
+    // Place the nodes that are still needed, then translate their links to the new slots
+    std::vector<int> moved(old_table->capacity, -1);
+    size_t mask = capacity - 1;
+    size_t count = 0;
+    if (m_node_count > 0)
+    {
+        for (size_t old_slot = 0; old_slot < old_table->capacity; old_slot++)
+        {
+            const Node &old_node = old_table->nodes[old_slot];
+            uint32_t state = old_node.state.load(std::memory_order_relaxed);
+            if (state != kRunning && state != kExited && state != kDetached)
+                continue;
+
+            int pid = old_node.pid.load(std::memory_order_relaxed);
+            size_t slot = home_slot(pid, capacity);
+            while (table->nodes[slot].state.load(std::memory_order_relaxed) != kEmpty)
+                slot = (slot + 1) & mask;
+
+            Node &node = table->nodes[slot];
+            node.pid.store(pid, std::memory_order_relaxed);
+            node.start_time_ms.store(old_node.start_time_ms.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            node.state.store(state, std::memory_order_relaxed);
+            moved[old_slot] = (int)slot;
+            count++;
+        }
+
+        auto translate = [&](int old_slot) { return old_slot >= 0 ? moved[old_slot] : -1; };
+        for (size_t old_slot = 0; old_slot < old_table->capacity; old_slot++)
+        {
+            if (moved[old_slot] < 0)
+                continue;
+
+            const Node &old_node = old_table->nodes[old_slot];
+            Node &node = table->nodes[moved[old_slot]];
+            node.parent.store(translate(old_node.parent.load(std::memory_order_relaxed)), std::memory_order_relaxed);
+            node.first_child.store(translate(old_node.first_child.load(std::memory_order_relaxed)), std::memory_order_relaxed);
+            node.next_sibling.store(translate(old_node.next_sibling.load(std::memory_order_relaxed)), std::memory_order_relaxed);
+            node.prev_sibling.store(translate(old_node.prev_sibling.load(std::memory_order_relaxed)), std::memory_order_relaxed);
+        }
+    }
+    table->used = count;
+
+    m_table.store(table, std::memory_order_seq_cst);
+    m_retired.push_back(old_table);
+    ReclaimRetired();
+}
+
+void ProcessTree::ReclaimRetired()
+{
+    // A reader that arrives after the swap above sees the new table, so once none is inside
+    // the replaced ones are unreachable
+    if (m_retired.empty() || m_readers.load(std::memory_order_seq_cst) != 0)
+        return;
+
+    for (Table *table : m_retired)
+        delete table;
+    m_retired.clear();
+}
@@ -0,0 +1,116 @@
+#ifndef PROCESS_TREE_H_
+#define PROCESS_TREE_H_
+
+#include "process_snapshot.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Parent/child index of the running processes, kept up to date from start and stop events.
+//
+// An exited process stays in the tree while it has descendants, so the ancestry of a process
+// survives its intermediate parents exiting (a build's shells, say) and a reused PID doesn't
+// inherit the old process's children. Once an exited process has no descendants left it is
+// evicted together with any exited ancestors it was keeping, so the tree only holds live
+// processes and the exited ancestors they still need.
+//
+// Nodes live in an open-addressed table keyed by PID and link to their parent and siblings by
+// slot. Writers are serialized by the caller. Readers take no lock: every node is a seqlock
+// that readers validate, a grown table is swapped in whole, and a replaced table is freed only
+// once no reader is inside. Ancestor queries cost O(depth).
+class ProcessTree
+{
+public:
+    ProcessTree();
+    ~ProcessTree();
+
+    ProcessTree(const ProcessTree &) = delete;
+    ProcessTree &operator=(const ProcessTree &) = delete;
+
+    // Writers
+    void Seed(const std::vector<RunningProcess> &processes);
+    void Clear();
+    void AddProcess(int pid, int parent_pid, long long start_time_ms);
+    void RemoveProcess(int pid, long long start_time_ms);
+
+    // Copies up to `max_ancestors` PIDs, parent first, and returns the depth of `pid`
+    // (0 if it has no known parent or isn't in the tree)
+    size_t Ancestors(int pid, int *ancestors, size_t max_ancestors) const;
+
+    // Copies up to `max_descendants` PIDs of running descendants of `pid`, including those below
+    // exited children, and returns how many there are
+    size_t Descendants(int pid, int *descendants, size_t max_descendants) const;
+
+    // Whether `pid` descends from `root_pid` (a process is not its own descendant)
+    bool IsDescendant(int pid, int root_pid) const;
+
+    // Nodes held, counting exited processes kept for their descendants
+    size_t NodeCount() const { return m_node_count.load(std::memory_order_relaxed); }
+
+private:
+    enum NodeState : uint32_t
+    {
+        kEmpty = 0,    // Never used; ends a probe
+        kRunning = 1,
+        kExited = 2,   // Kept for its descendants
+        kDetached = 3, // Like kExited, but its PID has been reused so lookups skip it
+        kDeleted = 4,  // Evicted; probes continue past it
+    };
+
+    struct Node
+    {
+        std::atomic<uint32_t> sequence{0}; // Odd while a writer changes the node
+        std::atomic<uint32_t> state{kEmpty};
+        std::atomic<int32_t> pid{0};
+        std::atomic<int32_t> parent{-1}; // Slots, -1 for none
+        std::atomic<int32_t> first_child{-1};
+        std::atomic<int32_t> next_sibling{-1};
+        std::atomic<int32_t> prev_sibling{-1};
+        std::atomic<long long> start_time_ms{0};
+    };
+
+    // Consistent copy of a node taken by a reader
+    struct NodeView
+    {
+        uint32_t state;
+        int pid;
+        int parent;
+        int first_child;
+        int next_sibling;
+    };
+
+    struct Table
+    {
+        explicit Table(size_t capacity) : capacity(capacity), nodes(new Node[capacity]) {}
+        size_t capacity;
+        std::unique_ptr<Node[]> nodes;
+        size_t used = 0; // Slots that aren't kEmpty
+    };
+
+    std::atomic<Table *> m_table;
+    mutable std::atomic<int> m_readers{0};
+    std::vector<Table *> m_retired;
+    std::atomic<size_t> m_node_count{0};
+
+    // Reader side
+    class ReadGuard;
+    static bool ReadNode(const Table &table, int slot, NodeView *view);
+    static int Find(const Table &table, int pid);
+
+    // Writer side
+    Table &WritableTable() { return *m_table.load(std::memory_order_relaxed); }
+    static void BeginWrite(Node &node);
+    static void EndWrite(Node &node);
+    int Insert(int pid, long long start_time_ms);
+    void Link(int child, int parent);
+    void Unlink(int child);
+    void Free(int slot);
+    void EvictIfUnused(int slot);
+    void Rebuild(size_t capacity);
+    void ReclaimRetired();
+};
+
+#endif // PROCESS_TREE_H_
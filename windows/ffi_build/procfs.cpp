@@ -0,0 +1,265 @@
+#include "procfs.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+// Layout of the records returned by getdents64 (glibc only exposes it through readdir)
+struct linux_dirent64
+{
+    unsigned long long d_ino;
+    long long d_off;
+    unsigned short d_reclen;
+    unsigned char d_type;
+    char d_name[];
+};
+
+// Smallest getdents64 buffer; roughly 2000 /proc entries
+static constexpr size_t kMinDirentBufferSize = 64 * 1024;
+
+int open_proc_dir()
+{
+    return open("/proc", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+}
+
+bool list_proc_pids(int proc_fd, std::vector<char> *dirents, std::vector<int> *pids, int *syscall_count)
+{
+    pids->clear();
+    if (dirents->size() < kMinDirentBufferSize)
+        dirents->resize(kMinDirentBufferSize);
+
+    // Rewind the directory fd instead of reopening /proc
+    lseek(proc_fd, 0, SEEK_SET);
+    (*syscall_count)++;
+
+    size_t total_bytes = 0;
+    while (true)
+    {
+        long length = syscall(SYS_getdents64, proc_fd, dirents->data(), dirents->size());
+        (*syscall_count)++;
+        if (length < 0)
+            return false;
+        if (length == 0)
+            break;
+        total_bytes += (size_t)length;
+
+        for (long offset = 0; offset < length;)
+        {
+            const linux_dirent64 *entry = (const linux_dirent64 *)(dirents->data() + offset);
+            offset += entry->d_reclen;
+
+            // Process directories are the all-digit names
+            const char *name = entry->d_name;
+            if (*name < '0' || *name > '9')
+                continue;
+
+            int pid = 0;
+            for (; *name >= '0' && *name <= '9'; name++)
+                pid = pid * 10 + (*name - '0');
+            if (*name == '\0')
+                pids->push_back(pid);
+        }
+    }
+
+    // Let the next listing fit in a single call
+    if (total_bytes + total_bytes / 4 > dirents->size())
+        dirents->resize(total_bytes + total_bytes / 4);
+
+    // The kernel lists PIDs in ascending order, sort only if that ever changes
+    if (!std::is_sorted(pids->begin(), pids->end()))
+        std::sort(pids->begin(), pids->end());
+    return true;
+}
+
+// Adds `count` syscalls to an optional counter
+static void count_syscalls(int *syscall_count, int count)
+{
+    if (syscall_count != nullptr)
+        *syscall_count += count;
+}
+
+// Reads up to `size - 1` bytes of a file under `dir_fd` and NUL-terminates them. Returns the length, or -1.
+static ssize_t read_small_file(int dir_fd, const char *path, char *buffer, size_t size, int *syscall_count = nullptr)
+{
+    int fd = openat(dir_fd, path, O_RDONLY | O_CLOEXEC);
+    count_syscalls(syscall_count, 1);
+    if (fd < 0)
+        return -1;
+
+    ssize_t length = read(fd, buffer, size - 1);
+    close(fd);
+    count_syscalls(syscall_count, 2);
+    if (length < 0)
+        return -1;
+    buffer[length] = '\0';
+    return length;
+}
+
+static bool read_stat_file(int dir_fd, const char *path, int pid, ProcStat *stat, int *syscall_count = nullptr)
+{
+    char buffer[1024];
+    if (read_small_file(dir_fd, path, buffer, sizeof(buffer), syscall_count) <= 0)
+        return false;
+
+    // "pid (comm) state ppid ..." - comm may itself contain spaces and parentheses,
+    // so it runs from the first '(' to the last ')'
+    char *open_paren = strchr(buffer, '(');
+    char *close_paren = strrchr(buffer, ')');
+    if (open_paren == nullptr || close_paren == nullptr || close_paren < open_paren || close_paren[1] == '\0')
+        return false;
+
+    stat->pid = pid;
+    stat->comm.assign(open_paren + 1, close_paren - open_paren - 1);
+
+    // Fields after comm, numbered as in proc(5): 3 state, 4 ppid, ..., 22 starttime
+    char *cursor = close_paren + 2;
+    stat->state = *cursor;
+    for (int field = 3; field < 22; field++)
+    {
+        cursor = strchr(cursor, ' ');
+        if (cursor == nullptr)
+            return false;
+        cursor++;
+
+        if (field == 3)
+            stat->ppid = (int)strtol(cursor, nullptr, 10);
+    }
+    stat->start_time = strtoull(cursor, nullptr, 10);
+    return true;
+}
+
+bool read_proc_stat(int proc_fd, int pid, ProcStat *stat, int *syscall_count)
+{
+    char path[32];
+    snprintf(path, sizeof(path), "%d/stat", pid);
+    return read_stat_file(proc_fd, path, pid, stat, syscall_count);
+}
+
+int open_proc_pid_dir(int proc_fd, int pid)
+{
+    char path[16];
+    snprintf(path, sizeof(path), "%d", pid);
+    return openat(proc_fd, path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+}
+
+bool read_proc_stat_at(int pid_dir_fd, int pid, ProcStat *stat)
+{
+    return read_stat_file(pid_dir_fd, "stat", pid, stat);
+}
+
+long long proc_start_time_ms(unsigned long long start_ticks)
+{
+    // Wall-clock time of boot, taken once so every process gets the same base
+    static const long long boot_time_ms = []()
+    {
+        timespec realtime, boottime;
+        clock_gettime(CLOCK_REALTIME, &realtime);
+        clock_gettime(CLOCK_BOOTTIME, &boottime);
+        return (realtime.tv_sec - boottime.tv_sec) * 1000LL + (realtime.tv_nsec - boottime.tv_nsec) / 1000000;
+    }();
+    static const long long ticks_per_second = sysconf(_SC_CLK_TCK);
+
+    return boot_time_ms + (long long)(start_ticks * 1000 / ticks_per_second);
+}
+
+static std::string read_exe_link(int dir_fd, const char *path, int *syscall_count = nullptr)
+{
+    char target[4096];
+    ssize_t length = readlinkat(dir_fd, path, target, sizeof(target) - 1);
+    count_syscalls(syscall_count, 1);
+    if (length <= 0)
+        return std::string();
+    target[length] = '\0';
+
+    // An unlinked binary shows up as "path (deleted)"
+    const char *deleted = strstr(target, " (deleted)");
+    return deleted ? std::string(target, deleted - target) : std::string(target, (size_t)length);
+}
+
+std::string read_process_exe_path(int proc_fd, int pid, int *syscall_count)
+{
+    char path[32];
+    snprintf(path, sizeof(path), "%d/exe", pid);
+    return read_exe_link(proc_fd, path, syscall_count);
+}
+
+std::string read_process_exe_path_at(int pid_dir_fd)
+{
+    return read_exe_link(pid_dir_fd, "exe");
+}
+
+bool read_process_cmdline_at(int pid_dir_fd, std::string *command_line)
+{
+    int fd = openat(pid_dir_fd, "cmdline", O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return false;
+
+    // Usually a single read; arguments can run to the kernel's ARG_MAX
+    command_line->clear();
+    char buffer[4096];
+    ssize_t length;
+    while ((length = read(fd, buffer, sizeof(buffer))) > 0)
+        command_line->append(buffer, (size_t)length);
+    close(fd);
+    if (length < 0)
+        return false;
+
+    // Arguments are NUL-separated (and NUL-terminated); show them space-separated like ps
+    while (!command_line->empty() && command_line->back() == '\0')
+        command_line->pop_back();
+    std::replace(command_line->begin(), command_line->end(), '\0', ' ');
+    return true;
+}
+
+bool read_process_uid_at(int pid_dir_fd, long long *uid)
+{
+    char buffer[4096];
+    if (read_small_file(pid_dir_fd, "status", buffer, sizeof(buffer)) <= 0)
+        return false;
+
+    // "Uid:\t<real>\t<effective>\t<saved>\t<filesystem>"
+    const char *line = strstr(buffer, "\nUid:");
+    if (line == nullptr)
+        return false;
+    *uid = strtoll(line + 5, nullptr, 10);
+    return true;
+}
+
+std::string exe_file_name(const std::string &exe_path)
+{
+    size_t slash = exe_path.rfind('/');
+    return slash != std::string::npos ? exe_path.substr(slash + 1) : exe_path;
+}
+
+std::string read_process_name(int proc_fd, int pid, const std::string &fallback_comm)
+{
+    std::string exe_path = read_process_exe_path(proc_fd, pid);
+    if (exe_path.empty())
+        return fallback_comm;
+    return exe_file_name(exe_path);
+}
+
+std::string read_process_comm(int proc_fd, int pid)
+{
+    char path[32];
+    snprintf(path, sizeof(path), "%d/comm", pid);
+
+    int fd = openat(proc_fd, path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return std::string();
+
+    char comm[64];
+    ssize_t length = read(fd, comm, sizeof(comm) - 1);
+    close(fd);
+    if (length <= 0)
+        return std::string();
+    comm[length] = '\0';
+
+    return std::string(comm, strcspn(comm, "\n"));
+}
@@ -0,0 +1,69 @@
+#ifndef PROCFS_H_
+#define PROCFS_H_
+
+#include <string>
+#include <vector>
+
+// Helpers for reading per-process information out of /proc (Linux only).
+// All paths are resolved relative to `proc_fd`, an O_DIRECTORY descriptor for /proc,
+// which saves the kernel a path walk from / on every lookup.
+
+// Fields of /proc/<pid>/stat that the event sources use
+struct ProcStat
+{
+    int pid = 0;
+    int ppid = 0;
+    char state = '?';
+    unsigned long long start_time = 0; // Clock ticks since boot
+    std::string comm;                  // Truncated to 15 bytes by the kernel
+};
+
+// Opens /proc for use with the helpers below. Returns -1 on failure.
+int open_proc_dir();
+
+// Lists the PIDs in /proc in ascending order with getdents64, rewinding `proc_fd` first.
+// `dirents` is the listing buffer; it is grown so the next listing of a similar size takes a
+// single call. Adds the syscalls made to `*syscall_count`.
+bool list_proc_pids(int proc_fd, std::vector<char> *dirents, std::vector<int> *pids, int *syscall_count);
+
+// Parses /proc/<pid>/stat. Costs three syscalls (openat, read, close), or one if the process is
+// gone; adds those made to `*syscall_count` if it is given.
+bool read_proc_stat(int proc_fd, int pid, ProcStat *stat, int *syscall_count = nullptr);
+
+// Opens /proc/<pid> for the *_at helpers below. Files read through it belong to that process
+// even if the PID is reused meanwhile: reads fail once the process has been reaped.
+// Returns -1 on failure.
+int open_proc_pid_dir(int proc_fd, int pid);
+
+// Same as read_proc_stat, through a descriptor from open_proc_pid_dir
+bool read_proc_stat_at(int pid_dir_fd, int pid, ProcStat *stat);
+
+// Converts ProcStat::start_time to milliseconds since the Unix epoch
+long long proc_start_time_ms(unsigned long long start_ticks);
+
+// Returns the executable's file name (like Win32_Process.Name), or `fallback_comm` when
+// /proc/<pid>/exe cannot be read (kernel threads, exited processes, missing permissions).
+// Costs one syscall (readlinkat).
+std::string read_process_name(int proc_fd, int pid, const std::string &fallback_comm);
+
+// Returns the full path of the executable, or an empty string if /proc/<pid>/exe cannot be read.
+// Costs one syscall (readlinkat), added to `*syscall_count` if it is given.
+std::string read_process_exe_path(int proc_fd, int pid, int *syscall_count = nullptr);
+
+// The file name part of an executable path, as read_process_name reports it
+std::string exe_file_name(const std::string &exe_path);
+
+// Same as read_process_exe_path, through a descriptor from open_proc_pid_dir
+std::string read_process_exe_path_at(int pid_dir_fd);
+
+// Reads the command line with its arguments separated by spaces (empty for kernel threads and
+// zombies). Costs at least three syscalls.
+bool read_process_cmdline_at(int pid_dir_fd, std::string *command_line);
+
+// Reads the real user ID from the status file. Costs three syscalls.
+bool read_process_uid_at(int pid_dir_fd, long long *uid);
+
+// Reads /proc/<pid>/comm. Used when nothing better is known about a process.
+std::string read_process_comm(int proc_fd, int pid);
+
+#endif // PROCFS_H_
@@ -0,0 +1,103 @@
+#include "shared_memory.h"
+
+#ifdef _WIN32
+  #include <windows.h>
+#else
+  #include <sys/mman.h>
+  #include <unistd.h>
+#endif
+
+#ifdef _WIN32
+
+bool SharedMemoryRegion::Allocate(size_t size)
+{
+    Release();
+
+    HANDLE mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, (DWORD)((unsigned long long)size >> 32), (DWORD)(size & 0xFFFFFFFF), nullptr);
+    if (mapping == nullptr)
+        return false;
+
+    void *writable = MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, size);
+    if (writable == nullptr)
+    {
+        CloseHandle(mapping);
+        return false;
+    }
+
+    const void *read_only = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, size);
+    m_mapping = mapping;
+    m_writable = writable;
+    m_read_only = read_only != nullptr ? read_only : writable;
+    m_size = size;
+    return true;
+}
+
+void SharedMemoryRegion::Release()
+{
+    if (m_read_only != nullptr && m_read_only != m_writable)
+        UnmapViewOfFile(m_read_only);
+    if (m_writable != nullptr)
+        UnmapViewOfFile(m_writable);
+    if (m_mapping != nullptr)
+        CloseHandle(m_mapping);
+
+    m_mapping = nullptr;
+    m_writable = nullptr;
+    m_read_only = nullptr;
+    m_size = 0;
+}
+
+#else
+
+bool SharedMemoryRegion::Allocate(size_t size)
+{
+    Release();
+
+    int fd = memfd_create("process_monitor_ring", MFD_CLOEXEC);
+    if (fd >= 0 && ftruncate(fd, (off_t)size) == 0)
+    {
+        void *writable = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        void *read_only = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);
+
+        if (writable != MAP_FAILED && read_only != MAP_FAILED)
+        {
+            m_writable = writable;
+            m_read_only = read_only;
+            m_size = size;
+            return true;
+        }
+        if (writable != MAP_FAILED)
+            munmap(writable, size);
+        if (read_only != MAP_FAILED)
+            munmap(read_only, size);
+    }
+    else if (fd >= 0)
+    {
+        close(fd);
+    }
+
+    // No memfd (old kernel, seccomp): a single anonymous mapping still avoids any copy
+    void *writable = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (writable == MAP_FAILED)
+        return false;
+
+    m_writable = writable;
+    m_read_only = writable;
+    m_size = size;
+    return true;
+}
+
+void SharedMemoryRegion::Release()
+{
+    if (m_read_only != nullptr && m_read_only != m_writable)
+        munmap(const_cast<void *>(m_read_only), m_size);
+    if (m_writable != nullptr)
+        munmap(m_writable, m_size);
+
+    m_writable = nullptr;
+    m_read_only = nullptr;
+    m_size = 0;
+}
+
+#endif
@@ -0,0 +1,35 @@
+#ifndef SHARED_MEMORY_H_
+#define SHARED_MEMORY_H_
+
+#include <cstddef>
+
+// Anonymous shared memory mapped twice: a writable view for the library and a read-only
+// view that can be handed to consumers, so they can read in place but not corrupt it.
+// Falls back to a single writable mapping where a second view cannot be created.
+class SharedMemoryRegion
+{
+public:
+    SharedMemoryRegion() = default;
+    ~SharedMemoryRegion() { Release(); }
+
+    SharedMemoryRegion(const SharedMemoryRegion &) = delete;
+    SharedMemoryRegion &operator=(const SharedMemoryRegion &) = delete;
+
+    // Maps `size` zero-filled bytes. Releases any previous mapping first.
+    bool Allocate(size_t size);
+    void Release();
+
+    void *Writable() const { return m_writable; }
+    const void *ReadOnly() const { return m_read_only; }
+    size_t Size() const { return m_size; }
+
+private:
+    void *m_writable = nullptr;
+    const void *m_read_only = nullptr;
+    size_t m_size = 0;
+#ifdef _WIN32
+    void *m_mapping = nullptr;
+#endif
+};
+
+#endif // SHARED_MEMORY_H_
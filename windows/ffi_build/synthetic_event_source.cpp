@@ -0,0 +1,247 @@
+#include "synthetic_event_source.h"
+#include "event_journal.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
+// Events published before the running flag and the clock are looked at again
+static constexpr int kMaxBurst = 1024;
+
+PacedEventSource::PacedEventSource(double rate_multiplier)
+    : m_rate_multiplier(rate_multiplier > 0 ? rate_multiplier : 0)
+{
+}
+
+void PacedEventSource::Run(const std::atomic<bool> &running, EventSignal &stop_signal)
+{
+    auto start = std::chrono::steady_clock::now();
+    uint64_t index = 0;
+
+    while (running)
+    {
+        long long elapsed_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+
+        // Everything due by now goes out at once, so a late wakeup catches up instead of drifting
+        long long due_ns = 0;
+        bool more = DueTime(index, &due_ns);
+        int burst = 0;
+        while (more && burst < kMaxBurst)
+        {
+            long long scheduled_ns = m_rate_multiplier > 0 ? (long long)((double)due_ns / m_rate_multiplier) : 0;
+            if (scheduled_ns > elapsed_ns)
+            {
+                due_ns = scheduled_ns;
+                break;
+            }
+            Publish(index++);
+            burst++;
+            more = DueTime(index, &due_ns);
+        }
+        if (burst > 0)
+            flush_process_events();
+        if (more && burst == kMaxBurst)
+            continue;
+
+        // Once the events run out the source stays quiet until monitoring stops.
+        // Waits of a millisecond or more sleep on the stop signal, the sub-millisecond rest is slept off.
+        if (!more)
+        {
+            stop_signal.Wait(-1);
+            continue;
+        }
+        long long wait_ns = due_ns - elapsed_ns;
+        if (wait_ns >= 1000000)
+            stop_signal.Wait((int)std::min<long long>(wait_ns / 1000000, INT_MAX));
+        else
+            std::this_thread::sleep_for(std::chrono::nanoseconds(wait_ns));
+    }
+}
+
+SyntheticEventSource::SyntheticEventSource(int events_per_second, long long event_count, double rate_multiplier)
+    : PacedEventSource(rate_multiplier), m_events_per_second(events_per_second > 0 ? events_per_second : 1), m_event_count(event_count > 0 ? event_count : 0)
+{
+}
+
+bool SyntheticEventSource::Initialize()
+{
+    for (int i = 0; i < kNameCount; i++)
+        m_name_ids[i] = intern_process_name("synthetic-" + std::to_string(i));
+
+#ifdef _WIN32
+    m_parent_pid = _getpid();
+#else
+    m_parent_pid = (int)getpid();
+#endif
+    m_first_start_time_ms = event_timestamp_ms();
+    return true;
+}
+
+bool SyntheticEventSource::DueTime(uint64_t index, long long *due_ns)
+{
+    if (m_event_count > 0 && index >= (uint64_t)m_event_count)
+        return false;
+
+    *due_ns = (long long)((double)index * 1e9 / m_events_per_second);
+    return true;
+}
+
+void SyntheticEventSource::Publish(uint64_t)
+{
+    // Once the pool is full, events alternate between stopping the oldest process and starting a new one
+    if (m_live.size() >= kLiveProcesses)
+    {
+        CompactProcessEvent stop = m_live.front();
+        m_live.pop_front();
+        stop.event_type = PROCESS_EVENT_STOP;
+        stop.timestamp_ms = event_timestamp_ms();
+        publish_process_event(stop);
+        return;
+    }
+
+    CompactProcessEvent start = {};
+    start.event_type = PROCESS_EVENT_START;
+    start.process_id = kFirstPid + (int)(m_started % kFirstPid);
+    start.parent_process_id = m_parent_pid;
+    start.name_id = m_name_ids[m_started % kNameCount];
+    start.start_time_ms = m_first_start_time_ms + m_started; // Distinct, so every process has its own key
+    start.timestamp_ms = event_timestamp_ms();
+    m_started++;
+    m_live.push_back(start);
+    publish_process_event(start);
+}
+
+ReplayEventSource::ReplayEventSource(const std::string &trace_path, double rate_multiplier)
+    : PacedEventSource(rate_multiplier), m_trace_path(trace_path)
+{
+}
+
+bool ReplayEventSource::Initialize()
+{
+    std::error_code error;
+    if (std::filesystem::is_directory(std::filesystem::u8path(m_trace_path), error))
+        return LoadJournal();
+
+    std::ifstream trace(m_trace_path);
+    if (!trace)
+    {
+        set_last_error("Failed to open trace " + m_trace_path + ": " + strerror(errno));
+        return false;
+    }
+
+    std::string line;
+    int line_number = 0;
+    while (std::getline(trace, line))
+    {
+        line_number++;
+        if (!line.empty() && line.back() == '\r')
+            line.pop_back();
+        size_t first = line.find_first_not_of(" \t");
+        if (first == std::string::npos || line[first] == '#')
+            continue;
+
+        // time_ms type pid parent_pid start_time_ms name (the name runs to the end of the line)
+        TraceEvent traced = {};
+        char type[16] = {};
+        int name_offset = 0;
+        if (sscanf(line.c_str(), "%lld %15s %d %d %lld %n", &traced.time_ms, type, &traced.event.process_id,
+                   &traced.event.parent_process_id, &traced.event.start_time_ms, &name_offset) != 5 ||
+            name_offset <= 0 || (size_t)name_offset >= line.size())
+        {
+            set_last_error("Trace line " + std::to_string(line_number) + " is not \"time_ms start|stop pid parent_pid start_time_ms name\"");
+            return false;
+        }
+
+        if (strcmp(type, "start") == 0)
+            traced.event.event_type = PROCESS_EVENT_START;
+        else if (strcmp(type, "stop") == 0)
+            traced.event.event_type = PROCESS_EVENT_STOP;
+        else
+        {
+            set_last_error("Trace line " + std::to_string(line_number) + " has unknown event type " + type);
+            return false;
+        }
+        traced.event.name_id = intern_process_name(line.substr((size_t)name_offset));
+
+        // A clock step backwards in the recording replays at once rather than stalling the rest
+        if (!m_events.empty() && traced.time_ms < m_events.back().time_ms)
+            traced.time_ms = m_events.back().time_ms;
+        m_events.push_back(traced);
+    }
+    return true;
+}
+
+bool ReplayEventSource::LoadJournal()
+{
+    JournalReader reader(m_trace_path);
+    if (!reader.Open())
+        return false;
+
+    JournalEvent journaled[256];
+    size_t count;
+    while ((count = reader.Read(journaled, sizeof(journaled) / sizeof(journaled[0]))) > 0)
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            TraceEvent traced = {};
+            traced.time_ms = journaled[i].event.timestamp_ms;
+            traced.event = journaled[i].event;
+            const char *name = reader.Name(journaled[i].event.name_id);
+            traced.event.name_id = name != nullptr ? intern_process_name(name, strlen(name)) : 0;
+
+            if (!m_events.empty() && traced.time_ms < m_events.back().time_ms)
+                traced.time_ms = m_events.back().time_ms;
+            m_events.push_back(traced);
+        }
+    }
+    return true;
+}
+
+bool ReplayEventSource::DueTime(uint64_t index, long long *due_ns)
+{
+    if (index >= m_events.size())
+        return false;
+
+    *due_ns = (m_events[index].time_ms - m_events[0].time_ms) * 1000000LL;
+    return true;
+}
+
+void ReplayEventSource::Publish(uint64_t index)
+{
+    CompactProcessEvent event = m_events[index].event;
+    event.timestamp_ms = event_timestamp_ms();
+    publish_process_event(event);
+}
+
+EventSource *create_paced_event_source(const EventSourceOptions &options)
+{
+    EventSource *source;
+    if (options.type == PROCESS_EVENT_SOURCE_SYNTHETIC)
+        source = new SyntheticEventSource(options.synthetic_events_per_second, options.synthetic_event_count, options.rate_multiplier);
+    else if (options.type == PROCESS_EVENT_SOURCE_REPLAY)
+        source = new ReplayEventSource(options.replay_trace_path, options.rate_multiplier);
+    else
+    {
+        set_last_error("Event source " + std::to_string(options.type) + " is not a synthetic source");
+        return nullptr;
+    }
+
+    if (!source->Initialize())
+    {
+        delete source;
+        return nullptr;
+    }
+    return source;
+}
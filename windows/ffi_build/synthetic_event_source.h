@@ -0,0 +1,94 @@
+#ifndef SYNTHETIC_EVENT_SOURCE_H_
+#define SYNTHETIC_EVENT_SOURCE_H_
+
+#include "event_source.h"
+
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <vector>
+
+// Base of the sources that make up their own events rather than observing the system.
+// Run() publishes each event when it falls due, with the schedule sped up by a rate
+// multiplier (0 publishes as fast as possible), so everything after publish_process_event
+// (dedup, filters, queues, delivery) runs exactly as it does for a real backend.
+class PacedEventSource : public EventSource
+{
+public:
+    explicit PacedEventSource(double rate_multiplier);
+
+    void Run(const std::atomic<bool> &running, EventSignal &stop_signal) override;
+    void Cleanup() override {}
+
+protected:
+    // When event `index` is due, in ns from the start at a multiplier of 1; false once there are no more.
+    // Indexes are asked for in order, and due times must not decrease.
+    virtual bool DueTime(uint64_t index, long long *due_ns) = 0;
+    virtual void Publish(uint64_t index) = 0;
+
+private:
+    double m_rate_multiplier;
+};
+
+// Generates processes that start and stop at a steady rate, for load testing consumers without
+// root or real process churn. Processes are named synthetic-0 to synthetic-63, are children of
+// the current process, and run until kLiveProcesses newer ones have started. PIDs are taken
+// from above 2^30, out of the way of real ones.
+class SyntheticEventSource : public PacedEventSource
+{
+public:
+    // `event_count` of 0 generates events until monitoring stops
+    SyntheticEventSource(int events_per_second, long long event_count, double rate_multiplier);
+
+    bool Initialize() override;
+    ProcessEventSourceType Type() const override { return PROCESS_EVENT_SOURCE_SYNTHETIC; }
+
+protected:
+    bool DueTime(uint64_t index, long long *due_ns) override;
+    void Publish(uint64_t index) override;
+
+private:
+    static constexpr int kNameCount = 64;
+    static constexpr size_t kLiveProcesses = 256;
+    static constexpr int kFirstPid = 0x40000000;
+
+    int m_events_per_second;
+    long long m_event_count;
+
+    uint32_t m_name_ids[kNameCount] = {};
+    int m_parent_pid = 0;
+    long long m_first_start_time_ms = 0;
+    long long m_started = 0;
+    std::deque<CompactProcessEvent> m_live; // Start events of the running processes, oldest first
+};
+
+// Replays a trace recorded from a real system (see set_replay_trace for the format), or the
+// events of a journal directory, keeping the recorded spacing between events. Events are
+// stamped with the time they are replayed.
+class ReplayEventSource : public PacedEventSource
+{
+public:
+    ReplayEventSource(const std::string &trace_path, double rate_multiplier);
+
+    // Reads the whole trace; fails on a missing file or a malformed line
+    bool Initialize() override;
+    ProcessEventSourceType Type() const override { return PROCESS_EVENT_SOURCE_REPLAY; }
+
+protected:
+    bool DueTime(uint64_t index, long long *due_ns) override;
+    void Publish(uint64_t index) override;
+
+private:
+    bool LoadJournal();
+
+    struct TraceEvent
+    {
+        long long time_ms;
+        CompactProcessEvent event;
+    };
+
+    std::string m_trace_path;
+    std::vector<TraceEvent> m_events;
+};
+
+#endif // SYNTHETIC_EVENT_SOURCE_H_
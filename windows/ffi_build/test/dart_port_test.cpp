@@ -0,0 +1,236 @@
+// Checks the messages DartPortPoster builds against the Dart_CObject layout from
+// dart_native_api.h, through a fake API DL table like the one NativeApi.initializeApiDLData
+// points at. lib/process_monitor.dart reads the posted bytes with the offsets checked here.
+//
+// Usage: dart_port_test
+
+#include "dart_port.h"
+#include "process_monitor_api.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+static int g_failures = 0;
+
+#define CHECK(condition)                                                      \
+    do                                                                        \
+    {                                                                         \
+        if (!(condition))                                                     \
+        {                                                                     \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            g_failures++;                                                     \
+        }                                                                     \
+    } while (0)
+
+// dart_port.cpp reports errors through the library's hook
+static std::string g_last_error;
+
+void set_last_error(const std::string &message)
+{
+    g_last_error = message;
+}
+
+// Dart_CObject as declared in dart_native_api.h, written out independently of dart_port.h
+enum FakeCObjectType : int32_t
+{
+    kFakeCObjectTypedData = 7,
+};
+
+enum FakeTypedDataType : int32_t
+{
+    kFakeTypedDataUint8 = 2,
+};
+
+struct FakeCObject
+{
+    FakeCObjectType type;
+    union
+    {
+        bool as_bool;
+        int64_t as_int64;
+        struct
+        {
+            int64_t id;
+            int64_t origin_id;
+        } as_send_port;
+        struct
+        {
+            FakeTypedDataType type;
+            intptr_t length;
+            const uint8_t *values;
+        } as_typed_data;
+        struct
+        {
+            FakeTypedDataType type;
+            intptr_t length;
+            uint8_t *data;
+            void *peer;
+            void *callback;
+        } as_external_typed_data;
+    } value;
+};
+
+// What the fake Dart_PostCObject saw; the bytes are copied like the VM does before returning
+struct PostedMessage
+{
+    int64_t port;
+    int32_t type;
+    int32_t typed_data_type;
+    intptr_t length;
+    std::vector<uint8_t> bytes;
+};
+
+static std::vector<PostedMessage> g_posted;
+
+static bool fake_post_cobject(int64_t port, FakeCObject *message)
+{
+    PostedMessage posted = {};
+    posted.port = port;
+    posted.type = message->type;
+    if (message->type == kFakeCObjectTypedData)
+    {
+        posted.typed_data_type = message->value.as_typed_data.type;
+        posted.length = message->value.as_typed_data.length;
+        posted.bytes.assign(message->value.as_typed_data.values, message->value.as_typed_data.values + posted.length);
+    }
+    g_posted.push_back(posted);
+    return true;
+}
+
+static void fake_unused_function()
+{
+}
+
+// DartApiEntry / DartApi from dart_api_dl.h
+struct FakeApiEntry
+{
+    const char *name;
+    void (*function)();
+};
+
+struct FakeApi
+{
+    int major;
+    int minor;
+    const FakeApiEntry *functions;
+};
+
+static const FakeApiEntry kFakeFunctions[] = {
+    {"Dart_PostInteger", fake_unused_function},
+    {"Dart_PostCObject", (void (*)())fake_post_cobject},
+    {"Dart_NewNativePort", fake_unused_function},
+    {nullptr, nullptr},
+};
+
+static const FakeApiEntry kFakeFunctionsWithoutPost[] = {
+    {"Dart_PostInteger", fake_unused_function},
+    {nullptr, nullptr},
+};
+
+static CompactProcessEvent make_event(int index)
+{
+    CompactProcessEvent event = {};
+    event.timestamp_ms = 1700000000000LL + index;
+    event.process_id = 1000 + index;
+    event.parent_process_id = 1;
+    event.name_id = 7 + (unsigned int)index;
+    event.event_type = index % 2 == 0 ? PROCESS_EVENT_START : PROCESS_EVENT_STOP;
+    event.start_time_ms = 1690000000000LL + index;
+    return event;
+}
+
+template <typename T>
+static T read_field(const uint8_t *record, size_t offset)
+{
+    T value;
+    memcpy(&value, record + offset, sizeof(value));
+    return value;
+}
+
+static void test_initialize()
+{
+    DartPortPoster poster;
+
+    CHECK(!poster.Initialize(nullptr));
+    CHECK(!poster.IsInitialized());
+
+    FakeApi old_version = {1, 0, kFakeFunctions};
+    CHECK(!poster.Initialize(&old_version));
+    CHECK(g_last_error.find("version") != std::string::npos);
+
+    FakeApi without_post = {2, 3, kFakeFunctionsWithoutPost};
+    CHECK(!poster.Initialize(&without_post));
+    CHECK(!poster.IsInitialized());
+
+    FakeApi api = {2, 3, kFakeFunctions};
+    CHECK(poster.Initialize(&api));
+    CHECK(poster.IsInitialized());
+}
+
+static void test_post()
+{
+    FakeApi api = {2, 3, kFakeFunctions};
+    DartPortPoster poster;
+    CHECK(poster.Initialize(&api));
+
+    static constexpr int kEventCount = 5;
+    CompactProcessEvent events[kEventCount];
+    for (int i = 0; i < kEventCount; i++)
+        events[i] = make_event(i);
+
+    g_posted.clear();
+    CHECK(!poster.Post(42, events, 0)); // Nothing to post
+    CHECK(g_posted.empty());
+
+    CHECK(poster.Post(42, events, kEventCount));
+    CHECK(g_posted.size() == 1); // One message for the whole batch
+    if (g_posted.size() != 1)
+        return;
+
+    const PostedMessage &posted = g_posted[0];
+    CHECK(posted.port == 42);
+    CHECK(posted.type == kFakeCObjectTypedData);
+    CHECK(posted.typed_data_type == kFakeTypedDataUint8);
+    CHECK(posted.length == kEventCount * 32);
+    CHECK(posted.bytes.size() == (size_t)kEventCount * 32);
+    if (posted.bytes.size() != (size_t)kEventCount * 32)
+        return;
+
+    // The record layout lib/process_monitor.dart decodes
+    CHECK(sizeof(CompactProcessEvent) == 32);
+    CHECK(offsetof(CompactProcessEvent, timestamp_ms) == 0);
+    CHECK(offsetof(CompactProcessEvent, process_id) == 8);
+    CHECK(offsetof(CompactProcessEvent, parent_process_id) == 12);
+    CHECK(offsetof(CompactProcessEvent, name_id) == 16);
+    CHECK(offsetof(CompactProcessEvent, event_type) == 20);
+    CHECK(offsetof(CompactProcessEvent, start_time_ms) == 24);
+
+    for (int i = 0; i < kEventCount; i++)
+    {
+        const uint8_t *record = posted.bytes.data() + i * 32;
+        CHECK(read_field<long long>(record, 0) == events[i].timestamp_ms);
+        CHECK(read_field<int>(record, 8) == events[i].process_id);
+        CHECK(read_field<int>(record, 12) == events[i].parent_process_id);
+        CHECK(read_field<unsigned int>(record, 16) == events[i].name_id);
+        CHECK(read_field<unsigned char>(record, 20) == events[i].event_type);
+        CHECK(read_field<long long>(record, 24) == events[i].start_time_ms);
+    }
+}
+
+int main()
+{
+    test_initialize();
+    test_post();
+
+    if (g_failures != 0)
+    {
+        fprintf(stderr, "%d check(s) failed\n", g_failures);
+        return 1;
+    }
+    printf("dart_port_test passed\n");
+    return 0;
+}
@@ -0,0 +1,76 @@
+#include "watch_list.h"
+
+#include <algorithm>
+
+// Lowercases ASCII letters only; process names are compared byte-wise otherwise
+static std::string to_lower_ascii(const char *text)
+{
+    std::string lowered(text);
+    for (char &c : lowered)
+    {
+        if (c >= 'A' && c <= 'Z')
+            c = (char)(c - 'A' + 'a');
+    }
+    return lowered;
+}
+
+// Paths follow the platform's file system: case-insensitive with either separator on Windows
+static std::string normalize_path(const std::string &path)
+{
+#ifdef _WIN32
+    std::string normalized = to_lower_ascii(path.c_str());
+    std::replace(normalized.begin(), normalized.end(), '/', '\\');
+    return normalized;
+#else
+    return path;
+#endif
+}
+
+void WatchList::Add(const std::string &process_name, const std::string &exe_path)
+{
+    if (process_name.empty())
+        return;
+
+    Entry &entry = m_names[to_lower_ascii(process_name.c_str())];
+    if (exe_path.empty())
+        entry.any_path = true;
+    else
+        entry.paths.push_back(normalize_path(exe_path));
+}
+
+void WatchList::Clear()
+{
+    m_names.clear();
+}
+
+bool WatchList::Matches(const char *process_name) const
+{
+    return Find(process_name) != nullptr;
+}
+
+bool WatchList::RequiresPath(const char *process_name) const
+{
+    const Entry *entry = Find(process_name);
+    return entry != nullptr && !entry->any_path;
+}
+
+bool WatchList::MatchesPath(const char *process_name, const std::string &exe_path) const
+{
+    const Entry *entry = Find(process_name);
+    if (entry == nullptr)
+        return false;
+    if (entry->any_path)
+        return true;
+
+    std::string normalized = normalize_path(exe_path);
+    return std::find(entry->paths.begin(), entry->paths.end(), normalized) != entry->paths.end();
+}
+
+const WatchList::Entry *WatchList::Find(const char *process_name) const
+{
+    if (m_names.empty() || process_name == nullptr || process_name[0] == '\0')
+        return nullptr;
+
+    auto found = m_names.find(to_lower_ascii(process_name));
+    return found != m_names.end() ? &found->second : nullptr;
+}
@@ -0,0 +1,37 @@
+#ifndef WATCH_LIST_H_
+#define WATCH_LIST_H_
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Set of process names to watch, compared case-insensitively (ASCII) like the Dart ProcessConfig matching.
+// A name can be narrowed to specific executable paths.
+class WatchList
+{
+public:
+    // An empty `exe_path` watches the name wherever it runs from
+    void Add(const std::string &process_name, const std::string &exe_path = std::string());
+    void Clear();
+
+    bool Empty() const { return m_names.empty(); }
+    bool Matches(const char *process_name) const;
+
+    // True if a matching name is only watched from specific paths, so MatchesPath() must be consulted
+    bool RequiresPath(const char *process_name) const;
+    bool MatchesPath(const char *process_name, const std::string &exe_path) const;
+
+private:
+    struct Entry
+    {
+        bool any_path = false;
+        std::vector<std::string> paths; // Normalized
+    };
+
+    // Keyed by lowercased name
+    std::unordered_map<std::string, Entry> m_names;
+
+    const Entry *Find(const char *process_name) const;
+};
+
+#endif // WATCH_LIST_H_
@@ -0,0 +1,533 @@
+#include "event_source.h"
+#include "exit_watcher.h"
+#include "process_details.h"
+#include "process_snapshot.h"
+#include <string>
+#include <thread>
+#include <atomic>
+#include <vector>
+
+#define _WIN32_DCOM
+#include <Wbemidl.h>
+#include <windows.h>
+#include <comdef.h>
+#include <tlhelp32.h>
+#include <winternl.h>
+
+static std::atomic<bool> g_com_initialized = false;
+
+// Converts a CIM_DATETIME ("yyyymmddHHMMSS.mmmmmmsUUU", UUU = UTC offset in minutes)
+// to milliseconds since the Unix epoch. Returns 0 if it can't be parsed.
+static long long cim_datetime_to_ms(const wchar_t *text)
+{
+    SYSTEMTIME time = {};
+    int microseconds = 0;
+    wchar_t sign = L'+';
+    int offset_minutes = 0;
+    if (text == nullptr || swscanf_s(text, L"%4hu%2hu%2hu%2hu%2hu%2hu.%6d%c%3d", &time.wYear, &time.wMonth, &time.wDay, &time.wHour, &time.wMinute, &time.wSecond, &microseconds, &sign, 1, &offset_minutes) != 9)
+        return 0;
+
+    FILETIME file_time;
+    if (!SystemTimeToFileTime(&time, &file_time))
+        return 0;
+
+    // FILETIME counts 100 ns intervals since 1601-01-01
+    ULARGE_INTEGER intervals;
+    intervals.LowPart = file_time.dwLowDateTime;
+    intervals.HighPart = file_time.dwHighDateTime;
+    long long local_ms = (long long)(intervals.QuadPart / 10000ULL) - 11644473600000LL + microseconds / 1000;
+    return local_ms - (sign == L'-' ? -offset_minutes : offset_minutes) * 60000LL;
+}
+
+// How long ago a WMI TIME_CREATED stamp (FILETIME intervals, as a decimal string) was, in ns.
+// Returns -1 if it can't be parsed.
+static long long time_created_age_ns(const wchar_t *text)
+{
+    if (text == nullptr)
+        return -1;
+
+    unsigned long long created = _wcstoui64(text, nullptr, 10);
+    FILETIME file_time;
+    GetSystemTimeAsFileTime(&file_time);
+    ULARGE_INTEGER now;
+    now.LowPart = file_time.dwLowDateTime;
+    now.HighPart = file_time.dwHighDateTime;
+    if (created == 0 || created > now.QuadPart)
+        return created == 0 ? -1 : 0;
+    return (long long)(now.QuadPart - created) * 100;
+}
+
+static std::string wide_to_utf8(const wchar_t *text, int length)
+{
+    if (length <= 0)
+        return std::string();
+
+    int utf8_length = WideCharToMultiByte(CP_UTF8, 0, text, length, nullptr, 0, nullptr, nullptr);
+    std::string utf8(utf8_length, '\0');
+    WideCharToMultiByte(CP_UTF8, 0, text, length, &utf8[0], utf8_length, nullptr, nullptr);
+    return utf8;
+}
+
+class FFIProcessEventSink : public IWbemObjectSink
+{
+private:
+    LONG m_lRef;
+    IWbemServices *m_pSvc = nullptr;
+    IUnsecuredApartment *m_pUnsecApp = nullptr;
+    IWbemObjectSink *m_pStubSink = nullptr;
+
+public:
+    FFIProcessEventSink() : m_lRef(0) {}
+    virtual ~FFIProcessEventSink() { 
+        // Don't call Cleanup() in destructor - this can cause crashes
+        // We'll call it explicitly when safe
+    }
+
+    // IUnknown methods
+    ULONG STDMETHODCALLTYPE AddRef()
+    {
+        return InterlockedIncrement(&m_lRef);
+    }
+
+    ULONG STDMETHODCALLTYPE Release()
+    {
+        LONG lRef = InterlockedDecrement(&m_lRef);
+        if (lRef == 0)
+            delete this;
+        return lRef;
+    }
+
+    HRESULT STDMETHODCALLTYPE QueryInterface(REFIID riid, void **ppv)
+    {
+        if (riid == IID_IUnknown || riid == IID_IWbemObjectSink)
+        {
+            *ppv = (IWbemObjectSink *)this;
+            AddRef();
+            return WBEM_S_NO_ERROR;
+        }
+        return E_NOINTERFACE;
+    }
+
+    // IWbemObjectSink methods
+    HRESULT STDMETHODCALLTYPE Indicate(LONG lObjectCount, IWbemClassObject **apObjArray)
+    {
+        for (long i = 0; i < lObjectCount; i++)
+        {
+            VARIANT vtProp;
+            VariantInit(&vtProp);
+            HRESULT hr = apObjArray[i]->Get(_bstr_t(L"TargetInstance"), 0, &vtProp, 0, 0);
+
+            if (SUCCEEDED(hr))
+            {
+                IWbemClassObject *pTargetInstance = (IWbemClassObject *)vtProp.punkVal;
+
+                VARIANT vtProcessName;
+                VariantInit(&vtProcessName);
+                pTargetInstance->Get(L"Name", 0, &vtProcessName, 0, 0);
+
+                VARIANT vtProcessId;
+                VariantInit(&vtProcessId);
+                pTargetInstance->Get(L"ProcessId", 0, &vtProcessId, 0, 0);
+
+                VARIANT vtParentProcessId;
+                VariantInit(&vtParentProcessId);
+                pTargetInstance->Get(L"ParentProcessId", 0, &vtParentProcessId, 0, 0);
+
+                VARIANT vtCreationDate;
+                VariantInit(&vtCreationDate);
+                pTargetInstance->Get(L"CreationDate", 0, &vtCreationDate, 0, 0);
+
+                uint32_t processId = vtProcessId.uintVal;
+
+                // Intern the name straight from the BSTR; it is converted to UTF-8 only the first time it is seen
+                uint32_t nameId = 0;
+                if (vtProcessName.vt == VT_BSTR && vtProcessName.bstrVal != nullptr)
+                    nameId = intern_process_name(vtProcessName.bstrVal, SysStringLen(vtProcessName.bstrVal));
+
+                // Get event type
+                _variant_t vtClass;
+                apObjArray[i]->Get(_bstr_t(L"__CLASS"), 0, &vtClass, NULL, NULL);
+
+                CompactProcessEvent event = {};
+                event.name_id = nameId;
+                event.process_id = (int)processId;
+                event.parent_process_id = vtParentProcessId.vt == VT_I4 ? (int)vtParentProcessId.uintVal : 0;
+                event.start_time_ms = vtCreationDate.vt == VT_BSTR ? cim_datetime_to_ms(vtCreationDate.bstrVal) : 0;
+                event.timestamp_ms = event_timestamp_ms();
+
+                // The event's TIME_CREATED says when the kernel raised it; placed on the monotonic clock by its age
+                long long kernel_time_ns = 0;
+                _variant_t vtTimeCreated;
+                apObjArray[i]->Get(L"TIME_CREATED", 0, &vtTimeCreated, 0, 0);
+                long long age_ns = vtTimeCreated.vt == VT_BSTR ? time_created_age_ns(vtTimeCreated.bstrVal) : -1;
+                if (age_ns >= 0)
+                {
+                    kernel_time_ns = monotonic_time_ns() - age_ns;
+                    event.timestamp_ms -= age_ns / 1000000;
+                }
+
+                if (wcscmp(vtClass.bstrVal, L"__InstanceCreationEvent") == 0)
+                    event.event_type = PROCESS_EVENT_START;
+                else
+                    event.event_type = PROCESS_EVENT_STOP;
+
+                // The instance already carries the path and command line; keep them for get_process_details
+                if (event.event_type == PROCESS_EVENT_START && event.start_time_ms != 0)
+                {
+                    _variant_t vtExecutablePath;
+                    _variant_t vtCommandLine;
+                    pTargetInstance->Get(L"ExecutablePath", 0, &vtExecutablePath, 0, 0);
+                    pTargetInstance->Get(L"CommandLine", 0, &vtCommandLine, 0, 0);
+
+                    ProcessDetailsRecord details;
+                    if (vtExecutablePath.vt == VT_BSTR && vtExecutablePath.bstrVal != nullptr)
+                    {
+                        details.exe_path = wide_to_utf8(vtExecutablePath.bstrVal, (int)SysStringLen(vtExecutablePath.bstrVal));
+                        details.fields |= PROCESS_DETAIL_EXE_PATH;
+                    }
+                    if (vtCommandLine.vt == VT_BSTR && vtCommandLine.bstrVal != nullptr)
+                    {
+                        details.command_line = wide_to_utf8(vtCommandLine.bstrVal, (int)SysStringLen(vtCommandLine.bstrVal));
+                        details.fields |= PROCESS_DETAIL_COMMAND_LINE;
+                    }
+                    if (details.fields != 0)
+                        record_process_details(event.process_id, event.start_time_ms, details);
+                }
+
+                publish_process_event(event, kernel_time_ns);
+
+                VariantClear(&vtProcessName);
+                VariantClear(&vtProcessId);
+                VariantClear(&vtParentProcessId);
+                VariantClear(&vtCreationDate);
+                VariantClear(&vtClass);
+                pTargetInstance->Release();
+            }
+            VariantClear(&vtProp);
+        }
+        flush_process_events();
+
+        return WBEM_S_NO_ERROR;
+    }
+
+    HRESULT STDMETHODCALLTYPE SetStatus(LONG lFlags, HRESULT hResult, BSTR strParam, IWbemClassObject *pObjParam)
+    {
+        return WBEM_S_NO_ERROR;
+    }
+
+    bool Initialize()
+    {
+        HRESULT hres;
+
+        // Only initialize COM if it hasn't been initialized yet
+        if (!g_com_initialized.exchange(true)) {
+            hres = CoInitializeEx(0, COINIT_MULTITHREADED);
+            if (FAILED(hres) && hres != RPC_E_CHANGED_MODE)
+            {
+                g_com_initialized = false;
+                set_last_error("Failed to initialize COM library. Error code = 0x" + std::to_string(hres));
+                return false;
+            }
+
+            hres = CoInitializeSecurity(NULL, -1, NULL, NULL, RPC_C_AUTHN_LEVEL_DEFAULT, RPC_C_IMP_LEVEL_IMPERSONATE, NULL, EOAC_NONE, NULL);
+            if (FAILED(hres) && hres != RPC_E_TOO_LATE)
+            {
+                set_last_error("Failed to initialize security. Error code = 0x" + std::to_string(hres));
+                // Don't fail completely on security init failure
+            }
+        }
+
+        IWbemLocator *pLoc = NULL;
+        hres = CoCreateInstance(CLSID_WbemLocator, 0, CLSCTX_INPROC_SERVER, IID_IWbemLocator, (LPVOID *)&pLoc);
+        if (FAILED(hres))
+        {
+            CoUninitialize();
+            set_last_error("Failed to create IWbemLocator object. Error code = 0x" + std::to_string(hres));
+            return false;
+        }
+
+        hres = pLoc->ConnectServer(_bstr_t(L"ROOT\\CIMV2"), NULL, NULL, 0, NULL, 0, 0, &m_pSvc);
+        if (FAILED(hres))
+        {
+            pLoc->Release();
+            CoUninitialize();
+            set_last_error("Could not connect to WMI. Error code = 0x" + std::to_string(hres));
+            return false;
+        }
+
+        hres = CoSetProxyBlanket(m_pSvc, RPC_C_AUTHN_WINNT, RPC_C_AUTHZ_NONE, NULL, RPC_C_AUTHN_LEVEL_CALL, RPC_C_IMP_LEVEL_IMPERSONATE, NULL, EOAC_NONE);
+        if (FAILED(hres))
+        {
+            m_pSvc->Release();
+            pLoc->Release();
+            CoUninitialize();
+            set_last_error("Could not set proxy blanket. Error code = 0x" + std::to_string(hres));
+            return false;
+        }
+
+        IUnsecuredApartment *pUnsecApp = NULL;
+        hres = CoCreateInstance(CLSID_UnsecuredApartment, NULL, CLSCTX_LOCAL_SERVER, IID_IUnsecuredApartment, (void **)&pUnsecApp);
+        if (FAILED(hres))
+        {
+            m_pSvc->Release();
+            pLoc->Release();
+            CoUninitialize();
+            set_last_error("Failed to create IUnsecuredApartment. Error code = 0x" + std::to_string(hres));
+            return false;
+        }
+
+        pUnsecApp->CreateObjectStub(this, (IUnknown**)&m_pStubSink);
+        pUnsecApp->Release();
+        pLoc->Release();
+
+        // Creation events
+        hres = m_pSvc->ExecNotificationQueryAsync(
+            _bstr_t("WQL"),
+            _bstr_t("SELECT * FROM __InstanceCreationEvent WITHIN 1 WHERE TargetInstance ISA 'Win32_Process'"),
+            WBEM_FLAG_SEND_STATUS,
+            NULL,
+            m_pStubSink
+        );
+
+        if (FAILED(hres))
+        {
+            Cleanup();
+            set_last_error("ExecNotificationQueryAsync (creation) failed. Error code = 0x" + std::to_string(hres));
+            return false;
+        }
+
+        // Deletion events
+        hres = m_pSvc->ExecNotificationQueryAsync(
+            _bstr_t("WQL"),
+            _bstr_t("SELECT * FROM __InstanceDeletionEvent WITHIN 1 WHERE TargetInstance ISA 'Win32_Process'"),
+            WBEM_FLAG_SEND_STATUS,
+            NULL,
+            m_pStubSink
+        );
+
+        if (FAILED(hres))
+        {
+            Cleanup();
+            set_last_error("ExecNotificationQueryAsync (deletion) failed. Error code = 0x" + std::to_string(hres));
+            return false;
+        }
+
+        return true;
+    }
+
+    void Cleanup()
+    {
+        if (m_pSvc)
+        {
+            if (m_pStubSink)
+                m_pSvc->CancelAsyncCall(m_pStubSink);
+            m_pSvc->Release();
+            m_pSvc = nullptr;
+        }
+        if (m_pStubSink)
+        {
+            m_pStubSink->Release();
+            m_pStubSink = nullptr;
+        }
+        CoUninitialize();
+    }
+};
+
+class WmiEventSource : public EventSource
+{
+private:
+    FFIProcessEventSink *m_sink = nullptr;
+
+public:
+    ~WmiEventSource() override
+    {
+        // Don't uninitialize COM during process shutdown - can cause crashes
+        // Just mark it as cleaned up so the next monitor thread initializes it again
+        g_com_initialized = false;
+    }
+
+    bool Initialize() override
+    {
+        m_sink = new FFIProcessEventSink();
+        if (!m_sink->Initialize())
+        {
+            delete m_sink;
+            m_sink = nullptr;
+            return false;
+        }
+        return true;
+    }
+
+    void Run(const std::atomic<bool> &running, EventSignal &stop_signal) override
+    {
+        // WMI delivers events on its own threads, just keep the subscription alive
+        while (running)
+            stop_signal.Wait(-1);
+
+        // DO NOT call Cleanup() here - this causes crashes
+        // The sink stays owned by the WMI stub, Cleanup() only runs from cleanup_process_monitor()
+        m_sink = nullptr;
+    }
+
+    void Cleanup() override
+    {
+        if (m_sink)
+        {
+            m_sink->Cleanup();
+            delete m_sink;
+            m_sink = nullptr;
+        }
+    }
+
+    ProcessEventSourceType Type() const override { return PROCESS_EVENT_SOURCE_WMI; }
+};
+
+EventSource *create_event_source(const EventSourceOptions &options)
+{
+    if (options.type == PROCESS_EVENT_SOURCE_SYNTHETIC || options.type == PROCESS_EVENT_SOURCE_REPLAY)
+        return create_paced_event_source(options);
+
+    if (options.type != PROCESS_EVENT_SOURCE_AUTO && options.type != PROCESS_EVENT_SOURCE_WMI)
+    {
+        set_last_error("Event source " + std::to_string(options.type) + " is not available on Windows");
+        return nullptr;
+    }
+
+    EventSource *source = new WmiEventSource();
+    if (!source->Initialize())
+    {
+        delete source;
+        return nullptr;
+    }
+    return source;
+}
+
+ExitWatcher *create_exit_watcher(const WatchList &watch_list, ExitWatcherCallback on_exit)
+{
+    set_last_error("Exact exit tracking is not available on Windows");
+    return nullptr;
+}
+static std::string query_image_path(HANDLE process)
+{
+    wchar_t path[MAX_PATH * 4];
+    DWORD length = sizeof(path) / sizeof(path[0]);
+    if (!QueryFullProcessImageNameW(process, 0, path, &length))
+        return std::string();
+    return wide_to_utf8(path, (int)length);
+}
+
+// Command line through NtQueryInformationProcess(ProcessCommandLineInformation), Windows 8.1+
+static bool query_command_line(HANDLE process, std::string *command_line)
+{
+    typedef NTSTATUS(NTAPI * NtQueryInformationProcessFn)(HANDLE, ULONG, PVOID, ULONG, PULONG);
+    static const NtQueryInformationProcessFn query_information = (NtQueryInformationProcessFn)GetProcAddress(GetModuleHandleW(L"ntdll.dll"), "NtQueryInformationProcess");
+    static constexpr ULONG kProcessCommandLineInformation = 60;
+    if (query_information == nullptr)
+        return false;
+
+    ULONG size = 0;
+    query_information(process, kProcessCommandLineInformation, nullptr, 0, &size);
+    if (size < sizeof(UNICODE_STRING))
+        return false;
+
+    std::vector<unsigned char> buffer(size);
+    if (query_information(process, kProcessCommandLineInformation, buffer.data(), size, &size) < 0)
+        return false;
+
+    const UNICODE_STRING *text = (const UNICODE_STRING *)buffer.data();
+    *command_line = wide_to_utf8(text->Buffer, text->Length / sizeof(wchar_t));
+    return true;
+}
+
+// The relative ID (last sub-authority) of the token owner's SID
+static bool query_user_id(HANDLE process, long long *user_id)
+{
+    HANDLE token = nullptr;
+    if (!OpenProcessToken(process, TOKEN_QUERY, &token))
+        return false;
+
+    unsigned char buffer[sizeof(TOKEN_USER) + SECURITY_MAX_SID_SIZE];
+    DWORD size = 0;
+    BOOL ok = GetTokenInformation(token, TokenUser, buffer, sizeof(buffer), &size);
+    CloseHandle(token);
+    if (!ok)
+        return false;
+
+    PSID sid = ((const TOKEN_USER *)buffer)->User.Sid;
+    UCHAR count = *GetSidSubAuthorityCount(sid);
+    *user_id = count > 0 ? (long long)*GetSidSubAuthority(sid, count - 1) : 0;
+    return true;
+}
+
+bool query_process_details(int pid, long long start_time_ms, int fields, ProcessDetailsRecord *details)
+{
+    // The handle pins the process, so once its creation time matches every field comes from it
+    HANDLE process = OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION, FALSE, (DWORD)pid);
+    if (process == nullptr)
+        return false;
+
+    FILETIME creation, exit, kernel, user;
+    DWORD exit_code = 0;
+    if (!GetProcessTimes(process, &creation, &exit, &kernel, &user) || !GetExitCodeProcess(process, &exit_code) || exit_code != STILL_ACTIVE)
+    {
+        CloseHandle(process);
+        return false;
+    }
+
+    // Same conversion as cim_datetime_to_ms, so it matches the start_time_ms of WMI events
+    ULARGE_INTEGER intervals;
+    intervals.LowPart = creation.dwLowDateTime;
+    intervals.HighPart = creation.dwHighDateTime;
+    long long created_ms = (long long)(intervals.QuadPart / 10000ULL) - 11644473600000LL;
+    if (start_time_ms != 0 && created_ms != start_time_ms)
+    {
+        CloseHandle(process);
+        return false;
+    }
+
+    details->fields = PROCESS_DETAIL_START_TIME;
+    details->start_time_ms = created_ms;
+    if (fields & PROCESS_DETAIL_EXE_PATH)
+    {
+        details->exe_path = query_image_path(process);
+        if (!details->exe_path.empty())
+            details->fields |= PROCESS_DETAIL_EXE_PATH;
+    }
+    if ((fields & PROCESS_DETAIL_COMMAND_LINE) && query_command_line(process, &details->command_line))
+        details->fields |= PROCESS_DETAIL_COMMAND_LINE;
+    if ((fields & PROCESS_DETAIL_USER_ID) && query_user_id(process, &details->user_id))
+        details->fields |= PROCESS_DETAIL_USER_ID;
+    CloseHandle(process);
+    return true;
+}
+
+bool list_running_processes(std::vector<RunningProcess> *processes)
+{
+    HANDLE snapshot = CreateToolhelp32Snapshot(TH32CS_SNAPPROCESS, 0);
+    if (snapshot == INVALID_HANDLE_VALUE)
+    {
+        set_last_error("Failed to snapshot running processes");
+        return false;
+    }
+
+    processes->clear();
+    PROCESSENTRY32W entry = {};
+    entry.dwSize = sizeof(entry);
+    for (BOOL ok = Process32FirstW(snapshot, &entry); ok; ok = Process32NextW(snapshot, &entry))
+    {
+        size_t length = wcslen(entry.szExeFile);
+        int utf8_length = WideCharToMultiByte(CP_UTF8, 0, entry.szExeFile, (int)length, nullptr, 0, nullptr, nullptr);
+        if (utf8_length <= 0)
+            continue;
+
+        // The snapshot has no creation time; start_time_ms stays 0
+        RunningProcess process;
+        process.pid = (int)entry.th32ProcessID;
+        process.parent_pid = (int)entry.th32ParentProcessID;
+        process.name.assign(utf8_length, '\0');
+        WideCharToMultiByte(CP_UTF8, 0, entry.szExeFile, (int)length, &process.name[0], utf8_length, nullptr, nullptr);
+        processes->push_back(std::move(process));
+    }
+    CloseHandle(snapshot);
+    return true;
+}